@@ -0,0 +1,331 @@
+/*
+ * Ncview by David W. Pierce.  A visual netCDF file viewer.
+ * Copyright (C) 1993 through 2010 David W. Pierce
+ *
+ * This program  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License, version 3, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * David W. Pierce
+ * 6259 Caminito Carrena
+ * San Diego, CA  92122
+ * dpierce@ucsd.edu
+ */
+
+/* The "-batch DIR" mode: without opening the display, make the frames of
+ * a variable (or of every variable) the same way they would be shown, with
+ * the same range, colormap, overlay, and blowup or zoom, and write them to
+ * DIR as PNG files named VAR.NNNNNN.png, where NNNNNN is the frame number.
+ *
+ * The netCDF library isn't thread safe, so the frames are read one at a
+ * time, a batch of them (one per thread) at once.  Then the whole batch is
+ * turned into pixels and written out with par_for, one frame per thread.
+ * Each frame has its own copy of the View, so the frames don't share any
+ * data, shrunken data, or pixels.  The par_for loops inside data_to_pixels
+ * are done in the thread that makes the frame (see parallel.c).
+ *
+ * With -stream, the frames go to the stream instead (in order, from the
+ * main thread), and no PNG files are written.
+ */
+
+#include "ncview.includes.h"
+#include "ncview.defines.h"
+#include "ncview.protos.h"
+
+#include <errno.h>
+
+extern View		*view;
+extern Options		options;
+extern NCVar		*variables;
+extern ncv_pixel	*pixel_transform;
+
+/* One frame of a batch */
+typedef struct {
+	View	v;		/* Copy of the view, with its own data and pixels */
+	size_t	frameno;
+	int	err;		/* Nonzero if the frame couldn't be made or written */
+} BatchFrame;
+
+typedef struct {
+	BatchFrame	*frames;
+	char		*file_var_name;	/* Variable name, as it goes in the file names */
+	XColor		*color_list;
+	size_t		pnx, pny;
+} BatchInfo;
+
+static void	batch_set_colors( XColor **color_list );
+static int	batch_do_var( NCVar *var, XColor *color_list );
+static void	batch_render_frames( long first, long last, void *arg );
+static void	batch_read_frame( View *v, size_t frameno );
+
+/*******************************************************************************
+ * Doesn't return.
+ */
+	void
+batch_run( void )
+{
+	NCVar	*var;
+	XColor	*color_list;
+	long	n_vars;
+
+#ifndef HAVE_PNG
+	if( options.stream_file == NULL ) {
+		fprintf( stderr, "ncview: -batch: this ncview was built without the PNG library, so it can only -stream\n" );
+		exit( -1 );
+		}
+#endif
+
+	/* What the user interface would otherwise set up */
+	options.timing       = FALSE;
+	options.autoscale    = FALSE;
+	options.save_frames  = FALSE;
+	options.blowup       = options.batch_blowup;
+	options.display_type = TrueColor;
+	batch_set_colors( &color_list );
+
+	if( (options.stream_file == NULL) && (mkdir( options.batch_dir, 0777 ) != 0) && (errno != EEXIST) ) {
+		fprintf( stderr, "ncview: -batch: can't make the directory %s\n", options.batch_dir );
+		exit( -1 );
+		}
+
+	if( options.batch_var != NULL ) {
+		if( (var = get_var( options.batch_var )) == NULL ) {
+			fprintf( stderr, "ncview: -batch: no variable named %s\n", options.batch_var );
+			exit( -1 );
+			}
+		if( batch_do_var( var, color_list ) != 0 )
+			exit( -1 );
+		exit( 0 );
+		}
+
+	n_vars = 0L;
+	for( var=variables; var != NULL; var=var->next )
+		if( (var->effective_dimensionality >= 2) && (batch_do_var( var, color_list ) == 0) )
+			n_vars++;
+	if( n_vars == 0L ) {
+		fprintf( stderr, "ncview: -batch: no variable could be shown as a 2-D field\n" );
+		exit( -1 );
+		}
+
+	exit( 0 );
+}
+
+/*******************************************************************************
+ * With no display there are no colormaps, so make the pixel values the
+ * same as the color levels (as on a TrueColor display), and the colors the
+ * ones the named built-in colormap would have.
+ */
+	static void
+batch_set_colors( XColor **color_list )
+{
+	int		i, n;
+	unsigned char	r[256], g[256], b[256];
+
+	if( builtin_colormap_rgb( options.batch_cmap, r, g, b ) != 0 ) {
+		fprintf( stderr, "ncview: -batch: no built-in colormap named %s\n", options.batch_cmap );
+		exit( -1 );
+		}
+
+	n = options.n_colors + options.n_extra_colors;
+	pixel_transform = (ncv_pixel *)malloc( n*sizeof(ncv_pixel) );
+	*color_list     = (XColor *)malloc( n*sizeof(XColor) );
+	if( (pixel_transform == NULL) || (*color_list == NULL) ) {
+		fprintf( stderr, "ncview: -batch: can't allocate colors\n" );
+		exit( -1 );
+		}
+	for( i=0; i<n; i++ ) {
+		pixel_transform[i]     = (ncv_pixel)i;
+		(*color_list)[i].pixel = i;
+		}
+	set_colormap_colors( *color_list, r, g, b );
+}
+
+/*******************************************************************************
+ * Write out the frames of one variable.  Returns -1 if the variable can't
+ * be shown.
+ */
+	static int
+batch_do_var( NCVar *var, XColor *color_list )
+{
+	BatchInfo	bi;
+	BatchFrame	*f;
+	size_t		nx, ny, nt, first, last, frameno, n_done;
+	long		n_slots, k, i;
+	char		*s;
+	struct timeval	t0;
+
+	if( options.batch_have_range ) {
+		var->user_min       = options.batch_min;
+		var->user_max       = options.batch_max;
+		var->have_set_range = TRUE;
+		}
+
+	if( view_init_headless( var ) < 0 ) {
+		fprintf( stderr, "ncview: -batch: variable %s can't be shown as a 2-D field\n", var->name );
+		return( -1 );
+		}
+	if( var->user_min == var->user_max ) {
+		fprintf( stderr, "ncview: -batch: variable %s has the same value everywhere (%g); use -batch_range\n",
+			var->name, var->user_min );
+		return( -1 );
+		}
+	if( (options.batch_overlay != NULL) && (overlay_by_name( options.batch_overlay ) < 0) ) {
+		fprintf( stderr, "ncview: -batch: couldn't make the overlay \"%s\"\n", options.batch_overlay );
+		exit( -1 );
+		}
+
+	nx = *(var->size + view->x_axis_id);
+	ny = *(var->size + view->y_axis_id);
+	nt = (view->scan_axis_id == -1) ? 1L : *(var->size + view->scan_axis_id);
+	view_get_scaled_size( options.blowup, nx, ny, &(bi.pnx), &(bi.pny) );
+
+	first = (size_t)options.batch_first;
+	if( (options.batch_last < 0L) || ((size_t)options.batch_last >= nt) )
+		last = nt - 1L;
+	else
+		last = (size_t)options.batch_last;
+	if( first > last ) {
+		fprintf( stderr, "ncview: -batch: variable %s has only %ld frames; skipping it\n", var->name, nt );
+		return( -1 );
+		}
+
+	/* Group names have slashes in them, which can't go in a file name */
+	bi.file_var_name = (char *)malloc( strlen(var->name)+1 );
+	strcpy( bi.file_var_name, var->name );
+	for( s=bi.file_var_name; *s != '\0'; s++ )
+		if( *s == '/' )
+			*s = '_';
+	bi.color_list = color_list;
+
+	n_slots = par_n_threads();
+	if( (size_t)n_slots > last-first+1 )
+		n_slots = last-first+1;
+	bi.frames = (BatchFrame *)malloc( n_slots*sizeof(BatchFrame) );
+	if( bi.frames == NULL ) {
+		fprintf( stderr, "ncview: -batch: can't allocate %ld frames\n", n_slots );
+		exit( -1 );
+		}
+	for( k=0; k<n_slots; k++ ) {
+		f = bi.frames+k;
+		f->v                 = *view;
+		f->v.data            = malloc( nx*ny*sizeof(float) );
+		f->v.pixels          = (unsigned char *)malloc( bi.pnx*bi.pny );
+		f->v.var_place       = (size_t *)malloc( var->n_dims*sizeof(size_t) );
+		f->v.render_nx       = 0L;
+		f->v.shrink_levels   = NULL;
+		f->v.n_shrink_levels = 0;
+		if( (f->v.data == NULL) || (f->v.pixels == NULL) || (f->v.var_place == NULL) ) {
+			fprintf( stderr, "ncview: -batch: can't allocate space for %ld frames of %ld x %ld\n",
+				n_slots, bi.pnx, bi.pny );
+			exit( -1 );
+			}
+		for( i=0; i<var->n_dims; i++ )
+			f->v.var_place[i] = view->var_place[i];
+		}
+
+	if( options.debug )
+		fprintf( stderr, "ncview: -batch: %s, frames %ld to %ld, %ld x %ld pixels, %ld at a time\n",
+			var->name, first, last, bi.pnx, bi.pny, n_slots );
+
+	gettimeofday( &t0, NULL );
+	n_done = 0L;
+	for( frameno=first; frameno<=last; frameno += n_slots ) {
+		k = ((last-frameno+1) < (size_t)n_slots) ? (long)(last-frameno+1) : n_slots;
+
+		for( i=0; i<k; i++ ) {
+			bi.frames[i].frameno = frameno + i;
+			batch_read_frame( &(bi.frames[i].v), frameno + i );
+			}
+
+		par_for( k, 1L, batch_render_frames, &bi );
+
+		for( i=0; i<k; i++ ) {
+			if( bi.frames[i].err ) {
+				fprintf( stderr, "ncview: -batch: couldn't make frame %ld of %s\n",
+					bi.frames[i].frameno, var->name );
+				exit( -1 );
+				}
+			if( (options.stream_file != NULL) &&
+			    (stream_frame( bi.frames[i].v.pixels, bi.pnx, bi.pny, color_list,
+			    		options.n_colors + options.n_extra_colors ) != 0) )
+				exit( -1 );
+			}
+
+		n_done += k;
+		fprintf( stderr, "\rncview: -batch: %s: %ld of %ld frames (%.1f frames/s)",
+			var->name, n_done, last-first+1, 1000.0*n_done/ms_since( &t0 ) );
+		}
+	fprintf( stderr, "\n" );
+
+	for( k=0; k<n_slots; k++ ) {
+		f = bi.frames+k;
+		invalidate_shrink_levels( &(f->v) );
+		free( f->v.data );
+		free( f->v.pixels );
+		free( f->v.var_place );
+		}
+	free( bi.frames );
+	free( bi.file_var_name );
+
+	return( 0 );
+}
+
+/*******************************************************************************
+ * Read frame 'frameno' into v->data.  This must be done in the main thread.
+ */
+	static void
+batch_read_frame( View *v, size_t frameno )
+{
+	size_t	*count;
+	int	i;
+
+	count = (size_t *)malloc( v->variable->n_dims * sizeof(size_t) );
+	for( i=0; i<v->variable->n_dims; i++ )
+		count[i] = 1L;
+	count[ v->x_axis_id ] = *(v->variable->size + v->x_axis_id);
+	count[ v->y_axis_id ] = *(v->variable->size + v->y_axis_id);
+	if( v->scan_axis_id != -1 )
+		v->var_place[ v->scan_axis_id ] = frameno;
+
+	fi_get_data( v->variable, v->var_place, count, v->data );
+	invalidate_shrink_levels( v );
+	v->data_status = VDS_VALID;
+
+	free( count );
+}
+
+/*******************************************************************************
+ * Turn frames first through last-1 of the batch into pixels and write them
+ * out.  This runs in several threads at once, so it must not read the file
+ * or touch the display.
+ */
+	static void
+batch_render_frames( long first, long last, void *arg )
+{
+	BatchInfo	*bi;
+	BatchFrame	*f;
+	char		fname[2048];
+	long		k;
+
+	bi = (BatchInfo *)arg;
+	for( k=first; k<last; k++ ) {
+		f = bi->frames+k;
+		f->err = (data_to_pixels( &(f->v) ) != 0);
+		if( f->err || (options.stream_file != NULL) )	/* Streamed frames go out in order */
+			continue;
+		snprintf( fname, 2047, "%s/%s.%06ld.png", options.batch_dir, bi->file_var_name, f->frameno );
+#ifdef HAVE_PNG
+		f->err = (write_png_frame( fname, f->v.pixels, bi->pnx, bi->pny, bi->color_list,
+				options.n_colors + options.n_extra_colors ) != 0);
+#endif
+		}
+}
@@ -0,0 +1,216 @@
+/*
+ * Ncview by David W. Pierce.  A visual netCDF file viewer.
+ * Copyright (C) 1993 through 2010 David W. Pierce
+ *
+ * This program  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License, version 3, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * David W. Pierce
+ * 6259 Caminito Carrena
+ * San Diego, CA  92122
+ * dpierce@ucsd.edu
+ */
+
+/* The "-bench N" mode: play N frames of a variable through the same code
+ * that makes frames for the display (reading, scale and offset, blowing
+ * up or shrinking, color levels, overlays, and TrueColor conversion),
+ * without opening the display at all, and print how fast it went.  The
+ * stage times come from timing.c.
+ *
+ * The output is in "key=value" form, one record per line, so that it's
+ * easy to pick out with a script:
+ *
+ *   bench file=... var=... frames=... data_nx=... ... frames_per_s=...
+ *   stage name=read total_ms=... avg_ms=... p50_ms=... p95_ms=... max_ms=...
+ *
+ * Nothing is sent to an X server, so there is no "put" stage, and the
+ * frames aren't saved in the framestore.  The TrueColor conversion is
+ * done as for a 32 bit display, with a grey color ramp; the colors in the
+ * colormap don't change how long that takes.
+ */
+
+#include "ncview.includes.h"
+#include "ncview.defines.h"
+#include "ncview.protos.h"
+
+extern View		*view;
+extern Options		options;
+extern NCVar		*variables;
+extern ncv_pixel	*pixel_transform;
+extern Server_Info	server;
+
+static NCVar	*bench_find_var( void );
+static void	bench_set_colors( XColor **color_list );
+
+/*******************************************************************************
+ * Doesn't return.
+ */
+	void
+bench_run( Stringlist *input_files )
+{
+	NCVar		*var;
+	size_t		nx, ny, pnx, pny, nt, frameno;
+	long		n_frames, k;
+	int		i;
+	float		*ms, *sorted, avg, p50, p95, max;
+	double		wall_ms, read_ms, render_ms, mb_read, mpix, sum;
+	struct timeval	t0;
+	XColor		*color_list;
+	unsigned char	*tc_data;
+
+	var = bench_find_var();
+
+	/* What the user interface would otherwise set up */
+	options.timing       = TRUE;
+	options.save_frames  = FALSE;
+	options.blowup       = options.bench_blowup;
+	options.display_type = TrueColor;
+	bench_set_colors( &color_list );
+
+	if( view_init_headless( var ) < 0 ) {
+		fprintf( stderr, "ncview: -bench: variable %s can't be shown as a 2-D field\n", var->name );
+		exit( -1 );
+		}
+	if( var->user_min == var->user_max ) {
+		fprintf( stderr, "ncview: -bench: variable %s has the same value everywhere (%g)\n",
+			var->name, var->user_min );
+		exit( -1 );
+		}
+	if( (options.bench_overlay != NULL) && (overlay_by_name( options.bench_overlay ) < 0) ) {
+		fprintf( stderr, "ncview: -bench: couldn't make the overlay \"%s\"\n", options.bench_overlay );
+		exit( -1 );
+		}
+
+	nx = *(var->size + view->x_axis_id);
+	ny = *(var->size + view->y_axis_id);
+	nt = (view->scan_axis_id == -1) ? 1L : *(var->size + view->scan_axis_id);
+	view_get_scaled_size( options.blowup, nx, ny, &pnx, &pny );
+
+	n_frames = (options.bench_frames > 0) ? options.bench_frames : (long)nt;
+
+	ms      = (float *)malloc( n_frames*(TIMING_N_STAGES+1)*sizeof(float) );
+	sorted  = (float *)malloc( n_frames*sizeof(float) );
+	tc_data = (unsigned char *)malloc( pnx*pny*4 );
+	if( (ms == NULL) || (sorted == NULL) || (tc_data == NULL) ) {
+		fprintf( stderr, "ncview: -bench: can't allocate space for %ld frames of %ld x %ld\n",
+			n_frames, pnx, pny );
+		exit( -1 );
+		}
+
+	/* Go round the frames as many times as it takes */
+	gettimeofday( &t0, NULL );
+	for( k=0; k<n_frames; k++ ) {
+		frameno = k % nt;
+		timing_frame_start();
+		if( view_render_headless( frameno ) < 0 ) {
+			fprintf( stderr, "ncview: -bench: couldn't make frame %ld\n", frameno );
+			exit( -1 );
+			}
+		timing_start( TIMING_TRUECOLOR );
+		make_tc_data( view->pixels, pnx, pny, color_list, tc_data );
+		timing_stop( TIMING_TRUECOLOR );
+		timing_frame_end();
+		timing_last_frame( ms + k*(TIMING_N_STAGES+1) );
+		}
+	wall_ms = ms_since( &t0 );
+
+	read_ms   = 0.0;
+	render_ms = 0.0;
+	for( k=0; k<n_frames; k++ )
+	for( i=0; i<TIMING_N_STAGES; i++ ) {
+		if( (i == TIMING_READ) || (i == TIMING_SCALE) )
+			read_ms += ms[ i + k*(TIMING_N_STAGES+1) ];
+		else
+			render_ms += ms[ i + k*(TIMING_N_STAGES+1) ];
+		}
+	mb_read = (double)n_frames * nx*ny*sizeof(float) / (1024.0*1024.0);
+	mpix    = (double)n_frames * pnx*pny / 1.0e6;
+
+	printf( "bench file=%s var=%s frames=%ld data_nx=%ld data_ny=%ld pixel_nx=%ld pixel_ny=%ld "
+		"blowup=%d zoom=%g threads=%d wall_s=%.4f frames_per_s=%.3f read_MB_per_s=%.3f "
+		"render_Mpixel_per_s=%.3f end_to_end_Mpixel_per_s=%.3f\n",
+		input_files->string, var->name, n_frames, nx, ny, pnx, pny,
+		options.blowup, options.zoom, par_n_threads(), wall_ms/1000.0, 1000.0*n_frames/wall_ms,
+		(read_ms > 0.0) ? 1000.0*mb_read/read_ms : 0.0,
+		(render_ms > 0.0) ? 1000.0*mpix/render_ms : 0.0,
+		1000.0*mpix/wall_ms );
+
+	for( i=0; i<=TIMING_N_STAGES; i++ ) {
+		if( i == TIMING_PUTIMAGE )	/* Nothing is drawn */
+			continue;
+		for( k=0; k<n_frames; k++ )
+			sorted[k] = ms[ i + k*(TIMING_N_STAGES+1) ];
+		timing_summarize( sorted, n_frames, &sum, &avg, &p50, &p95, &max );
+		printf( "stage name=%s total_ms=%.3f avg_ms=%.4f p50_ms=%.4f p95_ms=%.4f max_ms=%.4f\n",
+			timing_stage_name_of( i ), sum, avg, p50, p95, max );
+		}
+
+	exit( 0 );
+}
+
+/*******************************************************************************
+ * The variable given with -bench_var, or else the first one that can be
+ * shown as a 2-D field.
+ */
+	static NCVar *
+bench_find_var( void )
+{
+	NCVar	*var;
+
+	if( options.bench_var != NULL ) {
+		if( (var = get_var( options.bench_var )) == NULL ) {
+			fprintf( stderr, "ncview: -bench: no variable named %s\n", options.bench_var );
+			exit( -1 );
+			}
+		return( var );
+		}
+
+	for( var=variables; var != NULL; var=var->next )
+		if( var->effective_dimensionality >= 2 )
+			return( var );
+
+	fprintf( stderr, "ncview: -bench: no variable has 2 or more dimensions\n" );
+	exit( -1 );
+}
+
+/*******************************************************************************
+ * With no display there are no colormaps, so make the pixel values the
+ * same as the color levels (as on a TrueColor display), and a grey ramp
+ * to convert them with.
+ */
+	static void
+bench_set_colors( XColor **color_list )
+{
+	int	i, n;
+
+	n = options.n_colors + options.n_extra_colors;
+	pixel_transform = (ncv_pixel *)malloc( n*sizeof(ncv_pixel) );
+	*color_list     = (XColor *)malloc( n*sizeof(XColor) );
+	if( (pixel_transform == NULL) || (*color_list == NULL) ) {
+		fprintf( stderr, "ncview: -bench: can't allocate colors\n" );
+		exit( -1 );
+		}
+	for( i=0; i<n; i++ ) {
+		pixel_transform[i] = (ncv_pixel)i;
+		(*color_list)[i].pixel = i;
+		(*color_list)[i].red   = (unsigned short)((65535L*i)/n);
+		(*color_list)[i].green = (*color_list)[i].red;
+		(*color_list)[i].blue  = (*color_list)[i].red;
+		}
+
+	server.bytes_per_pixel = 4;
+	server.bits_per_pixel  = 32;
+	server.bitmap_pad      = 32;
+	server.byte_order      = LSBFirst;
+	server.rgb_order       = ORDER_RGB;
+}
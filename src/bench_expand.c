@@ -0,0 +1,532 @@
+/*
+ * Ncview by David W. Pierce.  A visual netCDF file viewer.
+ * Copyright (C) 1993 through 2010 David W. Pierce
+ *
+ * This program  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License, version 3, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * David W. Pierce
+ * 6259 Caminito Carrena
+ * San Diego, CA  92122
+ * dpierce@ucsd.edu
+ */
+
+/* bench_expand: times expand_block() (in expand.c) against the way the
+ * blowup used to be done, for blowups 2 through 16, and checks that the
+ * two give the same answer.  Run it with "make bench".
+ *
+ * The field is smooth, with a block of missing values, a missing corner
+ * and a sprinkling of single missing points, so that all the missing value
+ * and edge handling gets exercised.  The new way should give results that
+ * are identical to the old way.  The only exception is if the compiler
+ * fuses the multiply-adds in the two versions differently (which some
+ * compilers will do when allowed to use FMA instructions), in which case
+ * the interpolated values can differ in the last bit or so; we allow a
+ * relative difference of BENCH_TOLERANCE for that.
+ */
+
+#include <sys/time.h>
+
+#include "ncview.includes.h"
+#include "ncview.defines.h"
+#include "ncview.protos.h"
+
+#define BENCH_NX	250		/* Size of the field that gets blown up */
+#define BENCH_NY	180
+#define BENCH_FILL	1.0e20
+#define BENCH_TOLERANCE	1.0e-6
+#define BENCH_MIN_PIXELS 50000000.0	/* Each trial makes at least this many big points */
+#define BENCH_TRIALS	5
+
+static void   make_field( float *little, size_t nx, size_t ny, float fill );
+static double elapsed_ms( struct timeval *t0, struct timeval *t1 );
+static int    ref_close_enough( float data, float fill );
+static void   ref_expand_block( float *big_data, float *little, size_t nxl, size_t nyl, float fill_val,
+		int blowup, int blowup_type );
+
+/******************************************************************************/
+	int
+main( int argc, char **argv )
+{
+	float	*little, *big_ref, *big_new, fill, diff, max_diff, scale;
+	size_t	nxl, nyl, nbig, i;
+	long	n_diff, n_bad;
+	int	blowup, blowup_type, n_rep, rep, trial, status;
+	double	t, t_ref, t_new;
+	struct timeval t0, t1;
+	char	*type_name;
+
+	nxl  = BENCH_NX;
+	nyl  = BENCH_NY;
+	fill = BENCH_FILL;
+
+	little = (float *)malloc( nxl*nyl*sizeof(float) );
+	if( little == NULL ) {
+		fprintf( stderr, "bench_expand: can't allocate field\n" );
+		exit( -1 );
+		}
+	make_field( little, nxl, nyl, fill );
+
+	printf( "# bench_expand: field %ld x %ld, times are best ms per blowup\n", (long)nxl, (long)nyl );
+	printf( "# type      blowup   ref_ms   new_ms  speedup     max_diff   n_diff\n" );
+
+	status = 0;
+	for( blowup_type=BLOWUP_REPLICATE; blowup_type<=BLOWUP_BILINEAR; blowup_type++ )
+	for( blowup=2; blowup<=16; blowup++ ) {
+		type_name = (blowup_type == BLOWUP_REPLICATE) ? "replicate" : "bilinear";
+		nbig    = nxl*nyl*blowup*blowup;
+		big_ref = (float *)malloc( nbig*sizeof(float) );
+		big_new = (float *)malloc( nbig*sizeof(float) );
+		if( (big_ref == NULL) || (big_new == NULL) ) {
+			fprintf( stderr, "bench_expand: can't allocate %ld points for blowup %d\n", (long)nbig, blowup );
+			exit( -1 );
+			}
+
+		/* For very small fields, the edge extrapolation can look at
+		 * points that are never set, so start both off the same.
+		 */
+		memset( big_ref, 0, nbig*sizeof(float) );
+		memset( big_new, 0, nbig*sizeof(float) );
+
+		n_rep = (int)(BENCH_MIN_PIXELS / (double)nbig);
+		if( n_rep < 1 )
+			n_rep = 1;
+
+		/* Best of several trials, since other things running on the
+		 * machine can only make a trial slower
+		 */
+		t_ref = -1.0;
+		t_new = -1.0;
+		for( trial=0; trial<BENCH_TRIALS; trial++ ) {
+			gettimeofday( &t0, NULL );
+			for( rep=0; rep<n_rep; rep++ )
+				ref_expand_block( big_ref, little, nxl, nyl, fill, blowup, blowup_type );
+			gettimeofday( &t1, NULL );
+			t = elapsed_ms( &t0, &t1 ) / (double)n_rep;
+			if( (t_ref < 0.0) || (t < t_ref) )
+				t_ref = t;
+
+			gettimeofday( &t0, NULL );
+			for( rep=0; rep<n_rep; rep++ )
+				expand_block( big_new, little, nxl, nyl, fill, blowup, blowup_type, nbig );
+			gettimeofday( &t1, NULL );
+			t = elapsed_ms( &t0, &t1 ) / (double)n_rep;
+			if( (t_new < 0.0) || (t < t_new) )
+				t_new = t;
+			}
+
+		max_diff = 0.0;
+		n_diff   = 0;
+		n_bad    = 0;
+		for( i=0; i<nbig; i++ ) {
+			if( big_ref[i] == big_new[i] )
+				continue;
+			n_diff++;
+			diff  = fabs( big_ref[i] - big_new[i] );
+			scale = fabs( big_ref[i] );
+			if( scale < 1.0 )
+				scale = 1.0;
+			if( diff > max_diff )
+				max_diff = diff;
+			if( diff > BENCH_TOLERANCE*scale )
+				n_bad++;
+			}
+
+		printf( "%-10s %7d %8.3f %8.3f %8.2f %12.4g %8ld\n", type_name, blowup,
+			t_ref, t_new, t_ref/t_new, max_diff, n_diff );
+		if( n_bad > 0 ) {
+			printf( "bench_expand: FAILED, blowup %d (%s): %ld points differ by more than %g\n",
+				blowup, type_name, n_bad, BENCH_TOLERANCE );
+			status = 1;
+			}
+
+		free( big_ref );
+		free( big_new );
+		}
+
+	free( little );
+	return( status );
+}
+
+/******************************************************************************
+ * Make a smooth test field with missing values scattered around in it.
+ */
+	static void
+make_field( float *little, size_t nx, size_t ny, float fill )
+{
+	size_t	i, j;
+	unsigned long	seed;
+
+	seed = 12345;
+	for( j=0; j<ny; j++ )
+	for( i=0; i<nx; i++ ) {
+		little[i+j*nx] = 100.0*sin( 0.05*i ) * cos( 0.07*j ) + 0.3*i - 0.2*j;
+
+		/* A few percent of single missing points, from a fixed sequence */
+		seed = seed*1103515245 + 12345;
+		if( ((seed >> 16) % 100) < 3 )
+			little[i+j*nx] = fill;
+		}
+
+	/* A missing block in the middle, and the upper right corner */
+	for( j=ny/3; j<ny/2; j++ )
+	for( i=nx/4; i<nx/2; i++ )
+		little[i+j*nx] = fill;
+	for( j=ny-5; j<ny; j++ )
+	for( i=nx-7; i<nx; i++ )
+		little[i+j*nx] = fill;
+}
+
+/******************************************************************************/
+	static double
+elapsed_ms( struct timeval *t0, struct timeval *t1 )
+{
+	return( (t1->tv_sec - t0->tv_sec)*1000.0 + (t1->tv_usec - t0->tv_usec)*0.001 );
+}
+
+/******************************************************************************
+ * Copy of close_enough() from util.c, which can't be linked in here.
+ */
+	static int
+ref_close_enough( float data, float fill )
+{
+	float	criterion, diff;
+
+	if( fill == 0.0 )
+		criterion = 1.0e-5;
+	else if( fill < 0.0 )
+		criterion = -1.0e-5*fill;
+	else
+		criterion = 1.0e-5*fill;
+
+	diff = data - fill;
+	if( diff < 0.0 )
+		diff = -diff;
+
+	return( diff <= criterion );
+}
+
+
+/******************************************************************************
+ * The blowup the way it was done before expand.c, a pass at a time over
+ * the whole big array.  This is the reference that expand_block() is
+ * timed and checked against.
+ */
+	static void
+ref_expand_block( float *big_data, float *little, size_t nxl, size_t nyl, float fill_val,
+		int blowup, int blowup_type )
+{
+	size_t	idx, nxb, nyb;
+	long	line, il, jl, i2b, j2b;
+	int	offset_xb, offset_yb, miss_base, miss_right, miss_below;
+	float	step, final_est, extrap_fact;
+	float	base_val, right_val, below_val, val, bupr;
+	float	base_x, base_y, del_x, del_y;
+	float	est1, est2, frac_x, frac_y;
+	float 	cval;
+
+	/*--------------------------------------------------------------------------------
+	 * See my notebook entry of 2010-08-23. 
+	 * In general we draw a distinction between indices that are valid in the
+	 * original (little) array, indicazted by a "l" (little) suffix (such as il or jl),
+	 * and indices valid in the destination (big) array, which have a suffix of "b".
+	 *---------------------------------------------------------------------------------*/
+	nxb = nxl*blowup;				/* # of X entries in big array */
+	nyb = nyl*blowup;				/* # of Y entries in big array */
+
+	if( (nxb < blowup) || (nxb*nyb < blowup) ) {
+		fprintf( stderr, "ncview: data_to_pixels: too much magnification\n" );
+		fprintf( stderr, "nxb=%ld\n", nxb );
+		exit( -1 );
+		}
+
+	if( (blowup == 1) || (blowup_type == BLOWUP_REPLICATE)) { 
+		for( jl=0; jl<nyl; jl++ ) {
+			for( il=0; il<nxl; il++ )
+				for( i2b=0; i2b<blowup; i2b++ ) {
+					*(big_data + il*blowup + jl*nxb*blowup + i2b) = *(little+il+jl*nxl);
+					}
+			for( line=1; line<blowup; line++ )
+				for( i2b=0; i2b<nxb; i2b++ ) {
+					*(big_data + i2b + jl*nxb*blowup + line*nxb) =
+						*(big_data + i2b + jl*nxb*blowup);
+					}
+			}
+		} 
+
+	else 	{ /* BLOWUP_BILINEAR */
+		bupr = 1.0/(float)blowup;
+
+		/* Offset where we will put the center value into the big array. These are offsets
+		 * into the big array.
+		 */
+		offset_xb = (blowup - 1)/2;
+		offset_yb = offset_xb;
+
+		/* Horizontal base lines */
+		for( jl=0; jl<nyl; jl++ ) {
+			for( il=0; il<nxl-1; il++ ) {
+				base_val  = *(little + il   + jl*nxl);
+				right_val = *(little + il+1 + jl*nxl);
+
+				miss_base  = ref_close_enough(base_val,  fill_val);
+				miss_right = ref_close_enough(right_val, fill_val);
+				if( miss_base ) {
+					if( miss_right ) {
+						/* BOTH missing */
+						step = 0.0;
+						val = base_val;		/* missing value */
+						}
+					else
+						{
+						/* base missing, but right is there */
+						step = 0.0;
+						val = right_val;	/* an OK value */
+						}
+					}
+				else if( miss_right ) {
+					/* ONLY right is missing, checked for both missing above */
+					val = base_val;
+					step = 0.0;
+					}
+				else
+					{
+					/* NEITHER missing */
+					step = (right_val-base_val)*bupr;
+					val = base_val;
+					}
+
+				for( i2b=0; i2b < blowup; i2b++ ) {
+					*(big_data + il*blowup+i2b+offset_xb + jl*blowup*nxb + offset_yb*nxb ) = val;
+					val += step;
+					}
+				}
+			/* Fill in the last center value on the right, which was left unfilled by the above alg */
+			*(big_data + (nxl-1)*blowup+offset_xb + jl*blowup*nxb + offset_yb*nxb ) = *(little + (nxl-1) + jl*nxl);
+			}
+
+		/* Vertical base lines */
+		for( jl=0; jl<nyl-1; jl++ ) 
+		for( il=0; il<nxl;   il++ ) {
+			base_val  = *(little + il + jl*nxl);
+			below_val = *(little + il + (jl+1)*nxl);
+
+			miss_base  = ref_close_enough(base_val,  fill_val);
+			miss_below = ref_close_enough(below_val, fill_val);
+
+			if( miss_base ) {
+				if( miss_below ) {
+					/* BOTH missing */
+					step = 0.0;
+					val = base_val;		/* missing value */
+					}
+				else
+					{
+					/* base missing, but below is there */
+					step = 0.0;
+					val = below_val;	/* an OK value */
+					}
+				}
+			else if( miss_below ) {
+				/* ONLY below is missing, checked for both missing above */
+				val = base_val;
+				step = 0.0;
+				}
+			else
+				{
+				/* NEITHER missing */
+				step = (below_val-base_val)*bupr;
+				val = base_val;
+				}
+
+			for( j2b=0; j2b < blowup; j2b++ ) {
+				*(big_data + il*blowup+offset_xb + jl*blowup*nxb + (j2b+offset_yb)*nxb ) = val;
+				val += step;
+				}
+			}
+		/* Fill in the last center value along the top, which was left unfilled by the above alg */
+		for( il=0; il<nxl; il++ ) {
+			*(big_data + il*blowup+offset_xb + (nyl-1)*blowup*nxb + offset_yb*nxb) = *(little + il + (nyl-1)*nxl);
+			}
+
+		/* Now, fill in the interior of the interior squares by 
+		 * interpolating from the horizontal and vertical
+		 * base lines.
+		 */
+		for( jl=0; jl<nyl-1; jl++ )
+		for( il=0; il<nxl-1; il++ ) {
+			for( j2b=1; j2b<blowup; j2b++ )
+			for( i2b=1; i2b<blowup; i2b++ ) {
+				frac_x = (float)i2b*bupr;
+				frac_y = (float)j2b*bupr;
+
+				base_x    = *(big_data +  il   *blowup+offset_xb + jl*blowup*nxb +(j2b+offset_yb)*nxb);
+				right_val = *(big_data + (il+1)*blowup+offset_xb + jl*blowup*nxb+ (j2b+offset_yb)*nxb);
+				base_y    = *(big_data + il*blowup+i2b+offset_xb +  jl   *blowup*nxb + offset_yb*nxb);
+				below_val = *(big_data + il*blowup+i2b+offset_xb + (jl+1)*blowup*nxb + offset_yb*nxb);
+
+				if( ref_close_enough(base_x,    fill_val) || 
+				    ref_close_enough(right_val, fill_val) || 
+				    (il == nxl-1) )
+					del_x = 0.0;
+				else
+					del_x  = right_val - base_x;
+				if( ref_close_enough(base_y,    fill_val) || 
+				    ref_close_enough(below_val, fill_val) || 
+				    (jl == nyl-1) )
+					del_y = 0.0;
+				else
+					del_y  = below_val - base_y;
+				est1 = frac_x*del_x + base_x;
+				est2 = frac_y*del_y + base_y;
+
+				if( ref_close_enough( est1, fill_val )) {
+					if( ref_close_enough( est2, fill_val ))
+						final_est = fill_val;
+					else
+						final_est = est2;
+					}
+				else if( ref_close_enough( est2, fill_val ))
+					final_est = est1;
+				else
+					final_est = (est1 + est2)*.5;
+
+				*(big_data + il*blowup+i2b+offset_xb + jl*blowup*nxb + (j2b+offset_yb)*nxb ) = final_est;
+				}
+			}
+
+		/* It is a tricky and undetermined question as to whether we want to allow
+		 * extrema on the boundaries.  As a complete and total hack, we use only 
+		 * some fraction of the linear projection when extrapolating out to the 
+		 * edges.  If this is set to 1, then full linear extrapolation is used;
+		 * if set to 0, no extrapolation is done.
+		 */
+		extrap_fact = 0.2;
+
+		/* Fill in right hand side by extrapolating the gradient from the interior square fill.
+		 * This goes from y=the first center point to y=the last center point.
+		 */
+		il = nxl-1;
+		for( j2b=0; j2b<=blowup*(nyl-1); j2b++ ) {
+			idx = il*blowup+offset_xb + (j2b+offset_yb)*nxb;	
+			step = (*(big_data + idx - 1) - *(big_data + idx - 2));
+			val  = *(big_data + idx) + step;
+			for( i2b=1; i2b<(blowup-offset_xb+1); i2b++ ) {
+				*(big_data + idx + i2b) = val;
+				val += step*extrap_fact;
+				}
+			}
+
+		/* Fill in left hand side */
+		il = 0;
+		for( j2b=0; j2b<=blowup*(nyl-1); j2b++ ) {
+			idx = il*blowup+offset_xb + (j2b+offset_yb)*nxb;
+			step = (*(big_data + idx + 2) - *(big_data + idx + 1));
+			val  = *(big_data + idx) - step;
+			for( i2b=1; i2b<=(blowup-1)/2; i2b++ ) {
+				*(big_data + idx - i2b) = val;
+				val -= step*extrap_fact;
+				}
+			}
+
+		/* Fill in bottom */
+		jl = 0;
+		for( i2b=0; i2b<=blowup*(nxl-1); i2b++ ) {
+			idx = i2b+offset_xb + jl*blowup*nxb + offset_yb*nxb;
+			step = (*(big_data + idx + 2*nxb) - *(big_data + idx + nxb));   /* big(,y+2) - big(,y+1) */
+			val  = *(big_data + idx) - step;
+			for( j2b=1; j2b<=(blowup-1)/2; j2b++ ) {
+				*(big_data + idx - j2b*nxb) = val;
+				val -= step*extrap_fact;
+				}
+			}
+
+		/* Fill in top */
+		jl = nyl-1;
+		for( i2b=0; i2b<blowup*(nxl-1); i2b++ ) {
+			idx = i2b+offset_xb + jl*blowup*nxb + offset_yb*nxb;
+			step = (*(big_data + idx - nxb) - *(big_data + idx - 2*nxb));  /* big(,y-1) - big(,y-2) */
+			val  = *(big_data + idx) + step;
+			for( j2b=1; j2b<=blowup/2; j2b++ ) {
+				*(big_data + idx + j2b*nxb) = val;
+				val += step*extrap_fact;
+				}
+			}
+
+		/* Still have to fill in the four corners at this point.   Because of the
+		 * extrapolation issue noted above, we take a simple approach.  Just fill
+		 * in the corner blocks with the center data value.
+		 */
+
+		/* Lower left corner */
+		il = 0;
+		jl = 0;
+		cval = *(little + il + jl*nxl);          /* Data value in lower left corner */
+		if( ! ref_close_enough( cval, fill_val )) {
+			/* Fill in lower left corner */
+			for( j2b=0; j2b<=offset_yb; j2b++ )
+			for( i2b=0; i2b<=offset_xb; i2b++ ) {
+				*(big_data + i2b + j2b*nxb) = cval;
+				}
+			}
+			
+		/* Lower right corner */
+		il = nxl - 1;
+		jl = 0;
+		cval = *(little + il + jl*nxl);          /* Data value in lower left corner */
+		if( ! ref_close_enough( cval, fill_val )) {
+			/* Fill in lower right corner */
+			for( j2b=0; j2b<=offset_yb; j2b++ )
+			for( i2b=offset_xb; i2b<blowup; i2b++ ) {
+				*(big_data + il*blowup + i2b + j2b*nxb) = cval;
+				}
+			}
+
+		/* Upper right corner */
+		il = nxl - 1;
+		jl = nyl - 1;
+		cval = *(little + il + jl*nxl);          /* Data value in lower left corner */
+		if( ! ref_close_enough( cval, fill_val )) {
+			/* Fill in upper right corner */
+			for( j2b=offset_yb; j2b<blowup; j2b++ )
+			for( i2b=offset_xb; i2b<blowup; i2b++ ) {
+				*(big_data + il*blowup + i2b + jl*blowup*nxb + j2b*nxb) = cval;
+				}
+			}
+
+		/* Upper left corner */
+		il = 0;
+		jl = nyl - 1;
+		cval = *(little + il + jl*nxl);          /* Data value in lower left corner */
+		if( ! ref_close_enough( cval, fill_val )) {
+			/* Fill in upper left corner */
+			for( j2b=offset_yb; j2b<blowup; j2b++ )
+			for( i2b=0; i2b<=offset_xb; i2b++ ) {
+				*(big_data + il*blowup + i2b + jl*blowup*nxb + j2b*nxb) = cval;
+				}
+			}
+
+		/* Paint missing value blocks */
+		for( jl=0; jl<nyl; jl++ )
+		for( il=0; il<nxl; il++ ) {
+			base_val  = *(little + il   + jl*nxl);
+			if( ref_close_enough( base_val, fill_val )) {
+				for( j2b=0; j2b<blowup; j2b++ )
+				for( i2b=0; i2b<blowup; i2b++ ) {
+					*(big_data + il*blowup+i2b + jl*nxb*blowup + j2b*nxb ) = base_val;
+					}
+				}
+			}
+
+		}	/* end of BLOWUP_BILINEAR case */
+}
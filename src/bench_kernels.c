@@ -0,0 +1,428 @@
+/*
+ * Ncview by David W. Pierce.  A visual netCDF file viewer.
+ * Copyright (C) 1993 through 2010 David W. Pierce
+ *
+ * This program  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License, version 3, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * David W. Pierce
+ * 6259 Caminito Carrena
+ * San Diego, CA  92122
+ * dpierce@ucsd.edu
+ */
+
+/* bench_kernels: times the loops that most of the time of making a frame
+ * goes into, one at a time, on made-up fields of a few sizes and with a
+ * few different amounts of missing values.  No file or display is needed.
+ * Run it with "make bench"; it is linked with the rest of ncview (see
+ * ncview_nomain.c), but isn't part of the ncview program.  The kernels are:
+ *
+ *	data_to_pixels		at blowup 1 (turning data into color levels)
+ *	expand_data		blowup 3, replicated and bilinear
+ *	contract_data		blowup -3, mean and mode
+ *	make_tc_data		16, 24, and 32 bit TrueColor
+ *	min_max_of		the loop that finds the range of a frame
+ *	coord_lookup		putting overlay points onto the grid, by
+ *				binary search and (for comparison) by
+ *				looking at every coordinate
+ *	netcdf_fix_data		NaNs, scale_factor and add_offset after reading
+ *
+ * The fields are made the same way every time, so runs can be compared
+ * with each other.  Each case is run over and over for at least KB_MIN_MS,
+ * and the best time per run from KB_TRIALS such trials is kept.
+ * The output is one line per case:
+ *
+ *	kernel  variant  nx  ny  miss_pct  best_ms  Mpoints_per_s
+ *
+ * where a "point" is a point of the data, except for make_tc_data (a
+ * pixel) and coord_lookup (a location looked up).  The kernels that don't
+ * care about missing values are only run once for each size, with a
+ * miss_pct of "-".
+ */
+
+#include "ncview.includes.h"
+#include "ncview.defines.h"
+#include "ncview.protos.h"
+
+#define KB_FILL		1.0e20
+#define KB_MIN_MS	200.0	/* Each trial runs for at least this long */
+#define KB_TRIALS	3
+#define KB_BLOWUP	3	/* For expand_data and (as -KB_BLOWUP) contract_data */
+#define KB_N_LOOKUPS	20000	/* Locations looked up by coord_lookup */
+
+extern Options		options;
+extern Server_Info	server;
+
+static size_t	kb_sizes[][2] = { {256, 256}, {1024, 512}, {2048, 1024} };
+static int	kb_missing_pct[]  = { 0, 10, 50 };
+
+/* Everything a case needs; made once for each size and missing density */
+typedef struct {
+	size_t	nx, ny;
+	int	missing_pct;
+	float	*field,		/* The made-up field, with KB_FILL for missing */
+		*big,		/* Space for the blown up or shrunk data */
+		*dimvals,	/* Coordinate values for coord_lookup */
+		*lookups;
+	CoordIndex *coord_index;	/* Onto dimvals */
+	size_t	*sizes;
+	unsigned char *tc_data;
+	XColor	*color_list;
+	NCVar	var;
+	View	v;
+	NetCDFOptions nc_opts;
+	int	variant;
+} KBCase;
+
+typedef void (*KBFunc)( KBCase *c );
+
+static void	kb_make_case( KBCase *c, size_t nx, size_t ny, int missing_pct );
+static void	kb_free_case( KBCase *c );
+static void	kb_time( char *kernel, char *variant, KBCase *c, int uses_missing, double n_points,
+			KBFunc setup, KBFunc run );
+static void	kb_run_cases( KBCase *c, int first_density );
+static void	kb_setup_nans( KBCase *c );
+static void	kb_setup_shrink( KBCase *c );
+static void	kb_data_to_pixels( KBCase *c );
+static void	kb_expand( KBCase *c );
+static void	kb_contract( KBCase *c );
+static void	kb_make_tc_data( KBCase *c );
+static void	kb_min_max( KBCase *c );
+static void	kb_coord_lookup( KBCase *c );
+static void	kb_fix_data( KBCase *c );
+static void	kb_set_server( int bytes_per_pixel );
+
+/*******************************************************************************/
+	int
+main( int argc, char **argv )
+{
+	KBCase	c;
+	int	i, is, im;
+
+	initialize_misc();
+
+	/* The only option that means anything here is -threads */
+	for( i=1; i<argc-1; i++ )
+		if( strcmp( argv[i], "-threads" ) == 0 )
+			sscanf( argv[i+1], "%d", &(options.n_threads) );
+
+	options.display_type = TrueColor;
+	options.zoom         = 0.0;
+
+	printf( "# ncview kernel benchmarks: best of %d trials, threads=%d\n", KB_TRIALS, par_n_threads() );
+	printf( "# %-16s %-10s %6s %6s %8s %10s %14s\n", "kernel", "variant", "nx", "ny", "miss_pct",
+		"best_ms", "Mpoints_per_s" );
+
+	for( is=0; is<sizeof(kb_sizes)/sizeof(kb_sizes[0]); is++ )
+	for( im=0; im<sizeof(kb_missing_pct)/sizeof(int); im++ ) {
+		kb_make_case( &c, kb_sizes[is][0], kb_sizes[is][1], kb_missing_pct[im] );
+		kb_run_cases( &c, (im == 0) );
+		kb_free_case( &c );
+		}
+
+	return( 0 );
+}
+
+/*******************************************************************************/
+	static void
+kb_run_cases( KBCase *c, int first_density )
+{
+	double	n;
+
+	n = (double)c->nx * c->ny;
+
+	options.blowup = 1;
+	kb_time( "data_to_pixels", "blowup1", c, TRUE, n, NULL, kb_data_to_pixels );
+
+	options.blowup = KB_BLOWUP;
+	options.blowup_type = BLOWUP_REPLICATE;
+	kb_time( "expand_data", "replicate", c, TRUE, n, NULL, kb_expand );
+	options.blowup_type = BLOWUP_BILINEAR;
+	kb_time( "expand_data", "bilinear", c, TRUE, n, NULL, kb_expand );
+
+	/* contract_data keeps what it has done, so throw that away each time */
+	options.blowup = -KB_BLOWUP;
+	options.shrink_method = SHRINK_METHOD_MEAN;
+	kb_time( "contract_data", "mean", c, TRUE, n, kb_setup_shrink, kb_contract );
+	options.shrink_method = SHRINK_METHOD_MODE;
+	kb_time( "contract_data", "mode", c, TRUE, n, kb_setup_shrink, kb_contract );
+
+	kb_time( "min_max_of", "-", c, TRUE, n, NULL, kb_min_max );
+	kb_time( "netcdf_fix_data", "scale_off", c, TRUE, n, kb_setup_nans, kb_fix_data );
+
+	/* These don't look at the data values */
+	if( first_density ) {
+		options.blowup = 1;
+		kb_data_to_pixels( c );
+		for( c->variant=2; c->variant<=4; c->variant++ )
+			kb_time( "make_tc_data", (c->variant == 2) ? "16bit" : ((c->variant == 3) ? "24bit" : "32bit"),
+				c, FALSE, n, NULL, kb_make_tc_data );
+		c->coord_index->order = COORD_UNORDERED;
+		kb_time( "coord_lookup", "linear", c, FALSE, (double)KB_N_LOOKUPS, NULL, kb_coord_lookup );
+		c->coord_index->order = COORD_INCREASING;
+		kb_time( "coord_lookup", "bsearch", c, FALSE, (double)KB_N_LOOKUPS, NULL, kb_coord_lookup );
+		}
+}
+
+/*******************************************************************************
+ * Runs 'run' for at least KB_MIN_MS, KB_TRIALS times over, and prints the
+ * best time for one run.  'setup' (if not NULL) is called before each run,
+ * and isn't timed.
+ */
+	static void
+kb_time( char *kernel, char *variant, KBCase *c, int uses_missing, double n_points,
+		KBFunc setup, KBFunc run )
+{
+	int	n_rep, trial;
+	double	t, best_ms;
+	struct timeval t0;
+	char	miss[20];
+
+	best_ms = -1.0;
+	for( trial=0; trial<KB_TRIALS; trial++ ) {
+		t = 0.0;
+		for( n_rep=0; (n_rep == 0) || (t < KB_MIN_MS); n_rep++ ) {
+			if( setup != NULL )
+				setup( c );
+			gettimeofday( &t0, NULL );
+			run( c );
+			t += ms_since( &t0 );
+			}
+		t /= (double)n_rep;
+		if( (best_ms < 0.0) || (t < best_ms) )
+			best_ms = t;
+		}
+
+	if( uses_missing )
+		snprintf( miss, 19, "%d", c->missing_pct );
+	else
+		strcpy( miss, "-" );
+	printf( "  %-16s %-10s %6ld %6ld %8s %10.4f %14.2f\n", kernel, variant, (long)c->nx, (long)c->ny,
+		miss, best_ms, (best_ms > 0.0) ? n_points/(1000.0*best_ms) : 0.0 );
+	fflush( stdout );
+}
+
+/*******************************************************************************
+ * A smooth field with missing_pct percent of the points missing, some in
+ * a block and the rest scattered around, always made the same way.
+ */
+	static void
+kb_make_case( KBCase *c, size_t nx, size_t ny, int missing_pct )
+{
+	size_t	i, j, n, nbig, nsmall;
+	unsigned long	seed;
+	float	min, max;
+
+	c->nx          = nx;
+	c->ny          = ny;
+	c->missing_pct = missing_pct;
+	n      = nx*ny;
+	nbig   = n*KB_BLOWUP*KB_BLOWUP;
+	nsmall = ((nx+KB_BLOWUP-1)/KB_BLOWUP) * ((ny+KB_BLOWUP-1)/KB_BLOWUP);
+
+	c->field   = (float *)malloc( n*sizeof(float) );
+	c->big     = (float *)malloc( ((nbig > nsmall) ? nbig : nsmall)*sizeof(float) );
+	c->sizes   = (size_t *)malloc( 2*sizeof(size_t) );
+	c->tc_data = (unsigned char *)malloc( n*4 + ny*4 );	/* Room for padding too */
+	c->dimvals = (float *)malloc( nx*sizeof(float) );
+	c->lookups = (float *)malloc( KB_N_LOOKUPS*sizeof(float) );
+	c->v.pixels = (unsigned char *)malloc( n );
+	if( (c->field == NULL) || (c->big == NULL) || (c->sizes == NULL) ||
+	    (c->tc_data == NULL) || (c->dimvals == NULL) || (c->lookups == NULL) || (c->v.pixels == NULL) ) {
+		fprintf( stderr, "ncview: -bench_kernels: can't allocate space for a %ld x %ld field\n",
+			(long)nx, (long)ny );
+		exit( -1 );
+		}
+
+	seed = 12345;
+	for( j=0; j<ny; j++ )
+	for( i=0; i<nx; i++ ) {
+		c->field[i+j*nx] = 100.0*sin( 0.05*i ) * cos( 0.07*j ) + 0.3*i - 0.2*j;
+		seed = seed*1103515245 + 12345;
+		if( (int)((seed >> 16) % 100) < missing_pct/2 )
+			c->field[i+j*nx] = KB_FILL;
+		}
+	/* The other half of the missing points are a block in the middle */
+	for( j=0; j<ny/2; j++ )
+	for( i=0; i<(nx*missing_pct)/100; i++ )
+		c->field[i + (j+ny/4)*nx] = KB_FILL;
+
+	/* The variable and view, as view.c would set them up */
+	c->sizes[0] = ny;
+	c->sizes[1] = nx;
+	memset( &(c->var), 0, sizeof(NCVar) );
+	c->var.name           = "synthetic";
+	c->var.n_dims         = 2;
+	c->var.size           = c->sizes;
+	c->var.fill_value     = KB_FILL;
+	c->var.effective_dimensionality = 2;
+	min = 1.0e30;
+	max = -1.0e30;
+	min_max_of( c->field, n, KB_FILL, &min, &max );
+	c->var.user_min       = min;
+	c->var.user_max       = max;
+	c->var.have_set_range = TRUE;
+
+	c->v.variable        = &(c->var);
+	c->v.data            = c->field;
+	c->v.data_status     = VDS_VALID;
+	c->v.render_nx       = 0L;
+	c->v.shrink_levels   = NULL;
+	c->v.n_shrink_levels = 0;
+	c->v.x_axis_id       = 1;
+	c->v.y_axis_id       = 0;
+	c->v.scan_axis_id    = -1;
+
+	/* coord_lookup looks up longitudes on the X axis */
+	for( i=0; i<nx; i++ )
+		c->dimvals[i] = (360.0*i)/nx;
+	for( i=0; i<KB_N_LOOKUPS; i++ ) {
+		seed = seed*1103515245 + 12345;
+		c->lookups[i] = 360.0*(float)((seed >> 16) % 32768)/32768.0;
+		}
+	c->coord_index = coord_index_new( c->dimvals, nx );
+	if( c->coord_index == NULL ) {
+		fprintf( stderr, "ncview: -bench_kernels: can't allocate space for a coordinate index\n" );
+		exit( -1 );
+		}
+
+	memset( &(c->nc_opts), 0, sizeof(NetCDFOptions) );
+	c->nc_opts.scale_factor     = 0.01;
+	c->nc_opts.add_offset       = 273.15;
+	c->nc_opts.scale_factor_set = TRUE;
+	c->nc_opts.add_offset_set   = TRUE;
+
+	/* A grey ramp, as for -bench */
+	n = options.n_colors + options.n_extra_colors;
+	c->color_list = (XColor *)malloc( n*sizeof(XColor) );
+	for( i=0; i<n; i++ ) {
+		c->color_list[i].pixel = i;
+		c->color_list[i].red   = (unsigned short)((65535L*i)/n);
+		c->color_list[i].green = c->color_list[i].red;
+		c->color_list[i].blue  = c->color_list[i].red;
+		}
+}
+
+/*******************************************************************************/
+	static void
+kb_free_case( KBCase *c )
+{
+	invalidate_shrink_levels( &(c->v) );
+	free( c->field );
+	free( c->big );
+	free( c->sizes );
+	free( c->tc_data );
+	free( c->dimvals );
+	free( c->lookups );
+	coord_index_free( c->coord_index );
+	free( c->color_list );
+	free( c->v.pixels );
+}
+
+/*******************************************************************************
+ * The data as it comes from the file: missing points are NaNs.  The field
+ * itself is used by the other kernels, so this goes in c->big.
+ */
+	static void
+kb_setup_nans( KBCase *c )
+{
+	size_t	i, n;
+
+	n = c->nx*c->ny;
+	for( i=0; i<n; i++ )
+		c->big[i] = (c->field[i] == KB_FILL) ? NAN : c->field[i];
+}
+
+/*******************************************************************************/
+	static void
+kb_setup_shrink( KBCase *c )
+{
+	invalidate_shrink_levels( &(c->v) );
+}
+
+/*******************************************************************************/
+	static void
+kb_data_to_pixels( KBCase *c )
+{
+	data_to_pixels( &(c->v) );
+}
+
+/*******************************************************************************/
+	static void
+kb_expand( KBCase *c )
+{
+	expand_data( c->big, &(c->v), c->nx*c->ny*KB_BLOWUP*KB_BLOWUP );
+}
+
+/*******************************************************************************/
+	static void
+kb_contract( KBCase *c )
+{
+	contract_data( c->big, &(c->v), KB_FILL );
+}
+
+/*******************************************************************************/
+	static void
+kb_make_tc_data( KBCase *c )
+{
+	kb_set_server( c->variant );
+	make_tc_data( c->v.pixels, c->nx, c->ny, c->color_list, c->tc_data );
+}
+
+/*******************************************************************************/
+	static void
+kb_min_max( KBCase *c )
+{
+	float	min, max;
+
+	min = 1.0e30;
+	max = -1.0e30;
+	min_max_of( c->field, c->nx*c->ny, KB_FILL, &min, &max );
+}
+
+/*******************************************************************************/
+	static void
+kb_coord_lookup( KBCase *c )
+{
+	int	i;
+	static long sum = 0;	/* So the calls aren't optimized away */
+
+	for( i=0; i<KB_N_LOOKUPS; i++ )
+		sum += coord_index_lookup( c->coord_index, c->lookups[i] );
+}
+
+/*******************************************************************************/
+	static void
+kb_fix_data( KBCase *c )
+{
+	netcdf_fix_data( c->big, c->nx*c->ny, &(c->nc_opts) );
+}
+
+/*******************************************************************************
+ * Describe a little-endian TrueColor server with the given bytes per pixel
+ * (5-6-5 for 16 bits), for make_tc_data.
+ */
+	static void
+kb_set_server( int bytes_per_pixel )
+{
+	server.bytes_per_pixel = bytes_per_pixel;
+	server.bits_per_pixel  = 8*bytes_per_pixel;
+	server.bitmap_pad      = 32;
+	server.byte_order      = LSBFirst;
+	server.rgb_order       = ORDER_RGB;
+
+	server.shift_red         = 8;	server.mask_red         = 0xf8;
+	server.shift_green_upper = 13;	server.mask_green_upper = 0x07;
+	server.shift_green_lower = 5;	server.mask_green_lower = 0xe0;
+	server.shift_blue        = 11;	server.mask_blue        = 0x1f;
+}
@@ -35,11 +35,31 @@
 
 #define DELAY_DELTA	350.0
 #define DELAY_OFFSET	10L
+#define FPS_WINDOW_MS	1000.0	/* Frame rate is measured over about this long */
 
 extern Options options;
 
 static int cur_button = BUTTON_PAUSE;
 
+/* Animation timing.  The speed scrollbar sets how long each frame should
+ * be up, and we aim for that much wall-clock time between the starts of
+ * frames, rather than waiting that long after each frame is drawn, so the
+ * rate doesn't depend on how long the frames take to draw.  If drawing
+ * can't keep up, then with -drop_frames we skip ahead to the frame that
+ * should be showing; otherwise we just go as fast as we can.
+ */
+static struct timeval	play_deadline,	/* When the next frame should go up */
+			fps_start;	/* Start of the current frame rate measurement */
+static long	fps_n_shown, fps_n_dropped;
+static float	fps_measured = -1.0;	/* < 0 until we have a measurement */
+static long	fps_dropped;
+
+static double		play_interval_ms( void );
+static void		play_start( int button );
+static void		play_stop( void );
+static int		play_frames_due( void );
+static unsigned long	play_frame_shown( void );
+
 /*===========================================================================================*/
 	int
 which_button_pressed( void )
@@ -69,9 +89,7 @@ do_dimset( int modifier )
 	void
 do_restart( int modifier )
 {
-	cur_button = BUTTON_PAUSE;
-
-	in_timer_clear();
+	play_stop();
 
 	set_scan_view( 0 );
 	view_draw    ( TRUE, FALSE );
@@ -83,23 +101,21 @@ do_restart( int modifier )
 	void
 do_rewind( int modifier )
 {
-	unsigned long delay_millisec;
+	int	n_frames;
 
-	cur_button = BUTTON_REWIND;
+	if( modifier != MOD_2 )
+		modifier = MOD_1;
 
-	delay_millisec = (long)(DELAY_DELTA * options.frame_delay) + DELAY_OFFSET;
- 
+	play_start( BUTTON_REWIND );
 	in_timer_clear();
 
-	if( modifier == MOD_2 ) {
-		change_view( -10, FRAMES );
-		in_timer_set( (XtTimerCallbackProc)do_rewind, (XtPointer)(MOD_2), delay_millisec );
-		}
+	n_frames = play_frames_due();
+	if( modifier == MOD_2 )
+		change_view( -10*n_frames, FRAMES );
 	else
-		{
-		change_view( -1, FRAMES );
-		in_timer_set( (XtTimerCallbackProc)do_rewind, (XtPointer)(MOD_1), delay_millisec );
-		}
+		change_view( -n_frames, FRAMES );
+
+	in_timer_set( (XtTimerCallbackProc)do_rewind, (XtPointer)(long)modifier, play_frame_shown() );
 }
 
 /*===========================================================================================*/
@@ -113,30 +129,26 @@ do_quit( int modifier )
 	void
 do_backwards( int modifier )
 {
-	in_timer_clear();
+	play_stop();
 
 	if( modifier == MOD_2 )
 		change_view( -10, PERCENT );
 	else
 		change_view( -1, FRAMES );
-
-	cur_button = BUTTON_PAUSE;
 }
 
 /*===========================================================================================*/
 	void
 do_pause( int modifier )
 {
-	cur_button = BUTTON_PAUSE;
-	in_timer_clear();
+	play_stop();
 }
 
 /*===========================================================================================*/
 	void
 do_forward( int modifier )
 {
-	cur_button = BUTTON_PAUSE;
-	in_timer_clear();
+	play_stop();
 
 	if( modifier == MOD_2 )
 		change_view( 10, PERCENT );
@@ -148,23 +160,20 @@ do_forward( int modifier )
 	void
 do_fastforward( int modifier )
 {
-	unsigned long	delay_millisec;
+	int	n_frames, step;
 
-	cur_button = BUTTON_FASTFORWARD;
+	if( modifier != MOD_2 )
+		modifier = MOD_1;
 
+	play_start( BUTTON_FASTFORWARD );
 	in_timer_clear();
 
-	delay_millisec = (long)(DELAY_DELTA * options.frame_delay) + DELAY_OFFSET;
-
-	if( modifier == MOD_2 ) {
-		if( change_view( 10, FRAMES ) == 0 )
-			in_timer_set( (XtTimerCallbackProc)do_fastforward, (XtPointer)(MOD_2), delay_millisec );
-		}
+	step     = (modifier == MOD_2) ? 10 : 1;
+	n_frames = play_frames_due();
+	if( change_view( step*n_frames, FRAMES ) == 0 )
+		in_timer_set( (XtTimerCallbackProc)do_fastforward, (XtPointer)(long)modifier, play_frame_shown() );
 	else
-		{
-		if( change_view( 1, FRAMES ) == 0 )
-			in_timer_set( (XtTimerCallbackProc)do_fastforward, (XtPointer)(MOD_1), delay_millisec );
-		}
+		play_stop();
 }
 		
 /*===========================================================================================*/
@@ -231,6 +240,21 @@ do_blowup( int modifier )
 {
 	int view_var_is_valid = TRUE;
 
+	/* Middle button switches between fitting the image to the window
+	 * and integer blowups.  The others go back to integer blowups from
+	 * a non-integer zoom, starting with the nearest one.
+	 */
+	if( modifier == MOD_5 ) {
+		if( options.zoom_fit )
+			view_set_zoom( 0.0, FALSE, TRUE );
+		else
+			view_set_zoom( 0.0, TRUE, TRUE );
+		resize_saveframes();
+		return;
+		}
+	if( options.zoom > 0.0 )
+		view_set_zoom( 0.0, FALSE, FALSE );
+
 	if( modifier == MOD_3 )
 		view_change_blowup( -1, TRUE, view_var_is_valid );
 
@@ -256,7 +280,7 @@ do_blowup( int modifier )
 	/* If we are shrinking magnification, then try re-saving
 	 * the frames because now there might be enough room.
 	 */
-	init_saveframes();
+	resize_saveframes();
 	if( modifier == MOD_3 )
 		options.save_frames = TRUE;
 }
@@ -276,7 +300,7 @@ do_transform( int modifier )
 	void
 do_blowup_type( int modifier )
 {
-	init_saveframes();
+	resize_saveframes();
 	if( options.blowup_type == BLOWUP_REPLICATE )
 		set_blowup_type( BLOWUP_BILINEAR );
 	else
@@ -297,3 +321,137 @@ do_options( int modifier )
 {
 	set_options();
 }
+
+/*===========================================================================================
+ * How long each frame of the animation should be up, from the speed scrollbar
+ */
+	static double
+play_interval_ms( void )
+{
+	return( DELAY_DELTA * options.frame_delay + DELAY_OFFSET );
+}
+
+/*===========================================================================================
+ * Called each time an animation button (or its timer) goes off.  If the
+ * animation wasn't already going this way, start the clock.
+ */
+	static void
+play_start( int button )
+{
+	if( cur_button == button )
+		return;
+
+	cur_button = button;
+	gettimeofday( &play_deadline, NULL );
+	fps_start     = play_deadline;
+	fps_n_shown   = 0L;
+	fps_n_dropped = 0L;
+	fps_measured  = -1.0;
+}
+
+/*===========================================================================================*/
+	static void
+play_stop( void )
+{
+	int	was_playing;
+
+	was_playing = (cur_button != BUTTON_PAUSE);
+
+	cur_button = BUTTON_PAUSE;
+	in_timer_clear();
+
+	if( was_playing ) {
+		fps_measured = -1.0;
+		view_flush_scan_labels();
+		view_update_scan_label();
+		}
+}
+
+/*===========================================================================================
+ * How many frames to step for this tick of the animation.  This is one,
+ * unless we are dropping frames and have fallen a whole frame or more
+ * behind.  Moves the deadline on to when the frame after this is due.
+ */
+	static int
+play_frames_due( void )
+{
+	double	interval, late;
+	int	n;
+
+	interval = play_interval_ms();
+	late     = ms_since( &play_deadline );
+
+	n = 1;
+	if( options.drop_frames && (late >= interval) )
+		n += (int)(late/interval);
+	fps_n_dropped += n - 1;
+
+	play_deadline.tv_sec  += (long)(n*interval/1000.0);
+	play_deadline.tv_usec += (long)(fmod( n*interval, 1000.0 )*1000.0);
+	if( play_deadline.tv_usec >= 1000000L ) {
+		play_deadline.tv_sec++;
+		play_deadline.tv_usec -= 1000000L;
+		}
+
+	return( n );
+}
+
+/*===========================================================================================
+ * Called after a frame of the animation has been drawn.  Keeps the frame
+ * rate measurement up to date, and returns how long to wait before the
+ * next frame.
+ */
+	static unsigned long
+play_frame_shown( void )
+{
+	double	elapsed, wait;
+
+	fps_n_shown++;
+	elapsed = ms_since( &fps_start );
+	if( elapsed >= FPS_WINDOW_MS ) {
+		fps_measured  = 1000.0*fps_n_shown/elapsed;
+		fps_dropped   = fps_n_dropped;
+		fps_n_shown   = 0L;
+		fps_n_dropped = 0L;
+		gettimeofday( &fps_start, NULL );
+		if( options.debug )
+			fprintf( stderr, "play_frame_shown: %.1f fps (want %.1f), %ld dropped\n",
+				fps_measured, 1000.0/play_interval_ms(), fps_dropped );
+		view_update_scan_label();
+		}
+
+	wait = -ms_since( &play_deadline );
+
+	/* If we are more than a frame behind and not dropping frames,
+	 * don't try to catch up by showing a burst of frames later on
+	 */
+	if( (! options.drop_frames) && (wait < -play_interval_ms()) )
+		gettimeofday( &play_deadline, NULL );
+
+	/* Always wait a little, so user input gets a look in */
+	if( wait < 1.0 )
+		wait = 1.0;
+
+	return( (unsigned long)wait );
+}
+
+/*===========================================================================================
+ * Returns a string to put after the scan place, giving the frame rate
+ * we are getting and the one we want, or an empty string if no
+ * animation is going.
+ */
+	char *
+play_status( void )
+{
+	static char	status[100];
+
+	if( (cur_button == BUTTON_PAUSE) || (fps_measured < 0.0) )
+		return( "" );
+
+	if( fps_dropped > 0 )
+		snprintf( status, 99, " [%.1f of %.1f fps, %ld dropped]", fps_measured,
+			1000.0/play_interval_ms(), fps_dropped );
+	else
+		snprintf( status, 99, " [%.1f of %.1f fps]", fps_measured, 1000.0/play_interval_ms() );
+	return( status );
+}
@@ -48,12 +48,34 @@
 
 #define	ID_FONT_SIZE_SCALE	0.7	/* How much smaller ID font size is than regular */
 
+#define PS_BUF_SIZE		65536	/* Bytes of encoded image to collect before writing */
+#define PS_LINE_LEN		75	/* Characters per line of ASCII85 */
+
+/* The image goes out run-length encoded (RunLengthDecode) and then in
+ * ASCII85 (ASCII85Decode), both PostScript level 2 filters, so it is
+ * plain text that any level 2 printer can take.  The pixels are indexes
+ * into a palette of the colormap's colors, so each takes one byte rather
+ * than the six hex digits of RGB the level 1 colorimage needs.
+ */
+typedef struct {
+	FILE		*f;
+	unsigned char	buf[PS_BUF_SIZE];	/* Encoded text waiting to be written */
+	size_t		n;
+	unsigned char	tuple[4];		/* Bytes waiting to be ASCII85 encoded */
+	int		n_tuple,
+			col;			/* Characters on the current line */
+} PSImageOut;
+
 extern View 	*view;
 extern Options 	options;
 
 static PrintOptions printopts;
 
 static void print_header( FILE *out_file, float scale, size_t x, size_t y, size_t top_of_image );
+static void print_image( FILE *f, unsigned char *pixels, size_t n );
+static void ps_put_byte( PSImageOut *o, unsigned char c );
+static void ps_put_char( PSImageOut *o, unsigned char c );
+static void ps_flush_tuple( PSImageOut *o, int n );
 static void calc_scale( float *scale, size_t x, size_t y );
 static void set_font( FILE *outf, char *name, int size );
 static void do_outline( FILE *f, size_t x, size_t y );
@@ -96,15 +118,12 @@ print_init( void )
 	void
 do_print( void )
 {
-	long	i, j;
 	size_t	x_size, y_size, scaled_x_size, scaled_y_size, top_of_image, bot_of_image, 
 		center_x, center_y, left_of_image, right_of_image;
 	char	outfname[1024], tstr[1500];
 	int     outfid;
 	FILE	*outf;
 	float	output_scale;
-	int	r, g, b, n_print;
-	ncv_pixel pix;
 
 #ifdef DEBUG
 	fprintf( stderr, "entering do_print()\n" );
@@ -146,6 +165,15 @@ do_print( void )
 	}
 	
 	in_set_cursor_busy();
+
+	/* The whole frame being shown, without drawing it again */
+	if( (! printopts.test_only) && (view_get_whole_frame() != 0) ) {
+		fclose( outf );
+		in_set_cursor_normal();
+		in_error( "Error making the image to print\n" );
+		return;
+		}
+
 	calc_scale( &output_scale, scaled_x_size, scaled_y_size );
 
 	/* These are all in absolute points in the default coordinate system */
@@ -161,21 +189,8 @@ do_print( void )
 
 	/***** dump out the color image *****/
 	if( ! printopts.test_only ) {
-		view_draw( FALSE, FALSE ); /* Don't allow saveframes -- force reload of image data */
-		n_print = 0;
-		for( j=0; j<scaled_y_size; j++ ) {
-			for( i=0; i<scaled_x_size; i++ ) {
-				pix = *(view->pixels + j*scaled_x_size + i);
-				pix_to_rgb( pix, &r, &g, &b );
-				fprintf( outf, "%02x%02x%02x", (r>>8), (g>>8), (b>>8)); 
-				n_print += 6;
-				if( n_print > 70 ) {
-					fprintf( outf, "\n" );
-					n_print = 0;
-					}
-				}
-			}
-		fprintf( outf, "\n\n" );
+		print_image( outf, view->pixels, scaled_x_size*scaled_y_size );
+		fprintf( outf, "\n" );
 		}
 	
 	/* Outline the color contour with lines */
@@ -438,8 +453,9 @@ do_outline( FILE *f, size_t x, size_t y )
 	static void
 print_header( FILE *f, float scale, size_t x, size_t y, size_t top_of_image )
 {
+	int	i, n_colors, r, g, b;
+
 	fprintf( f, "%%!\n" );
-	fprintf( f, "/picstr %ld string def\n", x*3 );
 	fprintf( f, "gsave\n" );
 
 	/* This sets the position of the output image on the page */
@@ -463,11 +479,133 @@ print_header( FILE *f, float scale, size_t x, size_t y, size_t top_of_image )
 		}
 	else
 		{
-		fprintf( f, "%ld %ld 8\n", x, y );
-		fprintf( f, "[1 0 0 -1 0 1]\n" );
-		fprintf( f, "{currentfile picstr readhexstring pop}\n" );
-		fprintf( f, "false 3\n" );
-		fprintf( f, "colorimage\n\n" );
+		/* Palette of all 256 pixel values; ones that aren't colors are black */
+		n_colors = options.n_colors + options.n_extra_colors;
+		fprintf( f, "[/Indexed /DeviceRGB 255 <" );
+		for( i=0; i<256; i++ ) {
+			if( i%8 == 0 )
+				fprintf( f, "\n" );
+			if( i < n_colors )
+				pix_to_rgb( (ncv_pixel)i, &r, &g, &b );
+			else
+				r = g = b = 0;
+			fprintf( f, "%02x%02x%02x", (r>>8), (g>>8), (b>>8) );
+			}
+		fprintf( f, "\n>] setcolorspace\n" );
+		fprintf( f, "<< /ImageType 1 /Width %ld /Height %ld /BitsPerComponent 8\n", x, y );
+		fprintf( f, "   /Decode [0 255] /ImageMatrix [1 0 0 -1 0 1]\n" );
+		fprintf( f, "   /DataSource currentfile /ASCII85Decode filter /RunLengthDecode filter >>\n" );
+		fprintf( f, "image\n" );
 		}
 }
 
+/*************************************************************************
+ * Write n pixels as the data of the image that print_header started:
+ * run-length encoded, then ASCII85.  Runs of 2 to 128 of the same
+ * byte are a count byte (257 - length) and the byte; anything else goes
+ * in literal blocks of up to 128 bytes, a count byte (length - 1) and the
+ * bytes.
+ */
+	static void
+print_image( FILE *f, unsigned char *pixels, size_t n )
+{
+	PSImageOut	*o;
+	size_t		i, k, run, lit_start;
+
+	if( (o = (PSImageOut *)malloc( sizeof(PSImageOut) )) == NULL ) {
+		fprintf( stderr, "ncview: do_print: can't allocate output buffer\n" );
+		return;
+		}
+	o->f       = f;
+	o->n       = 0L;
+	o->n_tuple = 0;
+	o->col     = 0;
+
+	i = 0L;
+	while( i < n ) {
+		run = 1L;
+		while( (i+run < n) && (run < 128L) && (pixels[i+run] == pixels[i]) )
+			run++;
+		if( run >= 2L ) {
+			ps_put_byte( o, (unsigned char)(257L - run) );
+			ps_put_byte( o, pixels[i] );
+			i += run;
+			continue;
+			}
+
+		/* A literal block goes until a run of 3 or more starts */
+		lit_start = i;
+		while( (i < n) && (i-lit_start < 128L) ) {
+			if( (i+2 < n) && (pixels[i] == pixels[i+1]) && (pixels[i] == pixels[i+2]) )
+				break;
+			i++;
+			}
+		ps_put_byte( o, (unsigned char)(i - lit_start - 1L) );
+		for( k=lit_start; k<i; k++ )
+			ps_put_byte( o, pixels[k] );
+		}
+	ps_put_byte( o, 128 );		/* End of the run-length data */
+
+	/* End of the ASCII85 data */
+	if( o->n_tuple > 0 )
+		ps_flush_tuple( o, o->n_tuple );
+	ps_put_char( o, '~' );
+	ps_put_char( o, '>' );
+
+	fwrite( o->buf, 1, o->n, f );
+	free( o );
+}
+
+/*************************************************************************/
+	static void
+ps_put_byte( PSImageOut *o, unsigned char c )
+{
+	o->tuple[ o->n_tuple++ ] = c;
+	if( o->n_tuple == 4 )
+		ps_flush_tuple( o, 4 );
+}
+
+/*************************************************************************
+ * ASCII85 encode the n (1 to 4) bytes in o->tuple.  A whole tuple of
+ * zeros is just "z"; a partial one at the end gives n+1 characters.
+ */
+	static void
+ps_flush_tuple( PSImageOut *o, int n )
+{
+	unsigned long	v;
+	unsigned char	c[5];
+	int		i;
+
+	for( i=n; i<4; i++ )
+		o->tuple[i] = 0;
+	v = ((unsigned long)o->tuple[0] << 24) | ((unsigned long)o->tuple[1] << 16) |
+	    ((unsigned long)o->tuple[2] <<  8) |  (unsigned long)o->tuple[3];
+	o->n_tuple = 0;
+
+	if( (v == 0L) && (n == 4) ) {
+		ps_put_char( o, 'z' );
+		return;
+		}
+
+	for( i=4; i>=0; i-- ) {
+		c[i] = (unsigned char)(v % 85L) + '!';
+		v /= 85L;
+		}
+	for( i=0; i<=n; i++ )
+		ps_put_char( o, c[i] );
+}
+
+/*************************************************************************/
+	static void
+ps_put_char( PSImageOut *o, unsigned char c )
+{
+	if( o->n+2 > PS_BUF_SIZE ) {
+		fwrite( o->buf, 1, o->n, o->f );
+		o->n = 0L;
+		}
+	o->buf[ o->n++ ] = c;
+	if( ++(o->col) == PS_LINE_LEN ) {
+		o->buf[ o->n++ ] = '\n';
+		o->col = 0;
+		}
+}
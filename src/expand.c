@@ -0,0 +1,490 @@
+/*
+ * Ncview by David W. Pierce.  A visual netCDF file viewer.
+ * Copyright (C) 1993 through 2010 David W. Pierce
+ *
+ * This program  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License, version 3, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * David W. Pierce
+ * 6259 Caminito Carrena
+ * San Diego, CA  92122
+ * dpierce@ucsd.edu
+ */
+
+/* The kernel that blows up a block of floating point data by either
+ * replication or bilinear interpolation.  This is kept apart from the
+ * rest of the program, and uses no global state, so that the benchmark
+ * program (bench_expand) can link to it directly.
+ */
+
+#include "ncview.includes.h"
+#include "ncview.defines.h"
+#include "ncview.protos.h"
+
+/* Bilinear interpolation is done in strips of the big array that are
+ * about this many points wide, so that the rows of the strip we are
+ * working on stay in the cache.
+ */
+#define EXPAND_STRIP_NX	2048
+
+static int  is_fill( float data, float fill, float criterion );
+static void bilinear_interior( float *big_data, float *little, size_t nxl, size_t nyl,
+		float fill_val, float criterion, int blowup, int offset_xb, int offset_yb );
+
+/******************************************************************************
+ * Blow up 'little', which is nxl by nyl, by a factor of 'blowup' (which
+ * must be positive) into 'big_data', which must hold nxl*nyl*blowup*blowup
+ * values.  'blowup_type' is BLOWUP_REPLICATE or BLOWUP_BILINEAR.
+ */
+	void
+expand_block( float *big_data, float *little, size_t nxl, size_t nyl, float fill_val,
+		int blowup, int blowup_type, size_t array_size )
+{
+	size_t	idx, nxb, nyb;
+	long	line, il, jl, i2b, j2b;
+	int	offset_xb, offset_yb;
+	float	step, extrap_fact, criterion;
+	float	base_val, val;
+	float 	cval, *col_val, *col_step, *row;
+
+#ifdef CHECK_MEM
+	printf( "...CHECK_MEM is on!!\n" );
+#endif
+
+	/*--------------------------------------------------------------------------------
+	 * See my notebook entry of 2010-08-23.
+	 * In general we draw a distinction between indices that are valid in the
+	 * original (little) array, indicazted by a "l" (little) suffix (such as il or jl),
+	 * and indices valid in the destination (big) array, which have a suffix of "b".
+	 *---------------------------------------------------------------------------------*/
+	nxb = nxl*blowup;				/* # of X entries in big array */
+	nyb = nyl*blowup;				/* # of Y entries in big array */
+
+	if( (nxb < blowup) || (nxb*nyb < blowup) ) {
+		fprintf( stderr, "ncview: data_to_pixels: too much magnification\n" );
+		fprintf( stderr, "nxb=%ld\n", nxb );
+		exit( -1 );
+		}
+
+	if( (blowup == 1) || (blowup_type == BLOWUP_REPLICATE)) {
+		for( jl=0; jl<nyl; jl++ ) {
+			for( il=0; il<nxl; il++ )
+				for( i2b=0; i2b<blowup; i2b++ ) {
+#ifdef CHECK_MEM
+					if( il*blowup + jl*nxb*blowup + i2b >= array_size ) { fprintf( stderr, "mem error 001\n" ); exit(-1); }
+#endif
+					*(big_data + il*blowup + jl*nxb*blowup + i2b) = *(little+il+jl*nxl);
+					}
+			for( line=1; line<blowup; line++ )
+				memcpy( big_data + jl*nxb*blowup + line*nxb, big_data + jl*nxb*blowup, nxb*sizeof(float) );
+			}
+		}
+
+	else 	{ /* BLOWUP_BILINEAR */
+
+		/* Same test as close_enough(), but with the criterion worked out once */
+		if( fill_val == 0.0 )
+			criterion = 1.0e-5;
+		else if( fill_val < 0.0 )
+			criterion = -1.0e-5*fill_val;
+		else
+			criterion = 1.0e-5*fill_val;
+
+		/* Offset where we will put the center value into the big array. These are offsets
+		 * into the big array.
+		 */
+		offset_xb = (blowup - 1)/2;
+		offset_yb = offset_xb;
+
+		/* The base lines through the centers, and the interior of the interior squares */
+		bilinear_interior( big_data, little, nxl, nyl, fill_val, criterion,
+				blowup, offset_xb, offset_yb );
+
+		/* It is a tricky and undetermined question as to whether we want to allow
+		 * extrema on the boundaries.  As a complete and total hack, we use only
+		 * some fraction of the linear projection when extrapolating out to the
+		 * edges.  If this is set to 1, then full linear extrapolation is used;
+		 * if set to 0, no extrapolation is done.
+		 */
+		extrap_fact = 0.2;
+
+		/* Fill in right hand side by extrapolating the gradient from the interior square fill.
+		 * This goes from y=the first center point to y=the last center point.
+		 */
+		il = nxl-1;
+		for( j2b=0; j2b<=blowup*(nyl-1); j2b++ ) {
+			idx = il*blowup+offset_xb + (j2b+offset_yb)*nxb;
+			step = (*(big_data + idx - 1) - *(big_data + idx - 2));
+			val  = *(big_data + idx) + step;
+			for( i2b=1; i2b<(blowup-offset_xb+1); i2b++ ) {
+#ifdef CHECK_MEM
+				if( idx + i2b >= array_size ) { fprintf( stderr, "mem error 008\n" ); exit(-1); }
+#endif
+				*(big_data + idx + i2b) = val;
+				val += step*extrap_fact;
+				}
+			}
+
+		/* Fill in left hand side */
+		il = 0;
+		for( j2b=0; j2b<=blowup*(nyl-1); j2b++ ) {
+			idx = il*blowup+offset_xb + (j2b+offset_yb)*nxb;
+			step = (*(big_data + idx + 2) - *(big_data + idx + 1));
+			val  = *(big_data + idx) - step;
+			for( i2b=1; i2b<=(blowup-1)/2; i2b++ ) {
+#ifdef CHECK_MEM
+				if( idx - i2b >= array_size ) { fprintf( stderr, "mem error 009\n" ); exit(-1); }
+#endif
+				*(big_data + idx - i2b) = val;
+				val -= step*extrap_fact;
+				}
+			}
+
+		/* The bottom and top are filled a row at a time rather than a column
+		 * at a time, so col_val and col_step hold the extrapolated value and
+		 * the gradient for each column.
+		 */
+		col_val = (float *)malloc( 2*nxb*sizeof(float) );
+		if( col_val == NULL ) {
+			fprintf( stderr, "ncview: expand_block: failed to allocate %ld bytes\n", 2*nxb*sizeof(float) );
+			exit( -1 );
+			}
+		col_step = col_val + nxb;
+
+		/* Fill in bottom */
+		jl = 0;
+		row = big_data + jl*blowup*nxb + offset_yb*nxb + offset_xb;
+		for( i2b=0; i2b<=blowup*(nxl-1); i2b++ ) {
+			col_step[i2b] = (*(row + i2b + 2*nxb) - *(row + i2b + nxb));   /* big(,y+2) - big(,y+1) */
+			col_val [i2b] = *(row + i2b) - col_step[i2b];
+			}
+		for( j2b=1; j2b<=(blowup-1)/2; j2b++ )
+		for( i2b=0; i2b<=blowup*(nxl-1); i2b++ ) {
+#ifdef CHECK_MEM
+			if( (row - big_data) + i2b - j2b*nxb >= array_size ) { fprintf( stderr, "mem error 010\n" ); exit(-1); }
+#endif
+			*(row + i2b - j2b*nxb) = col_val[i2b];
+			col_val[i2b] -= col_step[i2b]*extrap_fact;
+			}
+
+		/* Fill in top */
+		jl = nyl-1;
+		row = big_data + jl*blowup*nxb + offset_yb*nxb + offset_xb;
+		for( i2b=0; i2b<blowup*(nxl-1); i2b++ ) {
+			col_step[i2b] = (*(row + i2b - nxb) - *(row + i2b - 2*nxb));  /* big(,y-1) - big(,y-2) */
+			col_val [i2b] = *(row + i2b) + col_step[i2b];
+			}
+		for( j2b=1; j2b<=blowup/2; j2b++ )
+		for( i2b=0; i2b<blowup*(nxl-1); i2b++ ) {
+#ifdef CHECK_MEM
+			if( (row - big_data) + i2b + j2b*nxb >= array_size ) { fprintf( stderr, "mem error 011\n" ); exit(-1); }
+#endif
+			*(row + i2b + j2b*nxb) = col_val[i2b];
+			col_val[i2b] += col_step[i2b]*extrap_fact;
+			}
+
+		free( col_val );
+
+		/* Still have to fill in the four corners at this point.   Because of the
+		 * extrapolation issue noted above, we take a simple approach.  Just fill
+		 * in the corner blocks with the center data value.
+		 */
+
+		/* Lower left corner */
+		il = 0;
+		jl = 0;
+		cval = *(little + il + jl*nxl);          /* Data value in lower left corner */
+		if( ! is_fill( cval, fill_val, criterion )) {
+			/* Fill in lower left corner */
+			for( j2b=0; j2b<=offset_yb; j2b++ )
+			for( i2b=0; i2b<=offset_xb; i2b++ ) {
+#ifdef CHECK_MEM
+				if( i2b + j2b*nxb >= array_size ) { fprintf( stderr, "mem error 012\n" ); exit(-1); }
+#endif
+				*(big_data + i2b + j2b*nxb) = cval;
+				}
+			}
+
+		/* Lower right corner */
+		il = nxl - 1;
+		jl = 0;
+		cval = *(little + il + jl*nxl);          /* Data value in lower right corner */
+		if( ! is_fill( cval, fill_val, criterion )) {
+			/* Fill in lower right corner */
+			for( j2b=0; j2b<=offset_yb; j2b++ )
+			for( i2b=offset_xb; i2b<blowup; i2b++ ) {
+#ifdef CHECK_MEM
+				if( il*blowup + i2b + j2b*nxb >= array_size ) { fprintf( stderr, "mem error 013\n" ); exit(-1); }
+#endif
+				*(big_data + il*blowup + i2b + j2b*nxb) = cval;
+				}
+			}
+
+		/* Upper right corner */
+		il = nxl - 1;
+		jl = nyl - 1;
+		cval = *(little + il + jl*nxl);          /* Data value in upper right corner */
+		if( ! is_fill( cval, fill_val, criterion )) {
+			/* Fill in upper right corner */
+			for( j2b=offset_yb; j2b<blowup; j2b++ )
+			for( i2b=offset_xb; i2b<blowup; i2b++ ) {
+#ifdef CHECK_MEM
+				if( il*blowup + i2b + jl*blowup*nxb + j2b*nxb >= array_size ) { fprintf( stderr, "mem error 014\n" ); exit(-1); }
+#endif
+				*(big_data + il*blowup + i2b + jl*blowup*nxb + j2b*nxb) = cval;
+				}
+			}
+
+		/* Upper left corner */
+		il = 0;
+		jl = nyl - 1;
+		cval = *(little + il + jl*nxl);          /* Data value in upper left corner */
+		if( ! is_fill( cval, fill_val, criterion )) {
+			/* Fill in upper left corner */
+			for( j2b=offset_yb; j2b<blowup; j2b++ )
+			for( i2b=0; i2b<=offset_xb; i2b++ ) {
+#ifdef CHECK_MEM
+				if(  il*blowup + i2b + jl*blowup*nxb + j2b*nxb >= array_size ) { fprintf( stderr, "mem error 015\n" ); exit(-1); }
+#endif
+				*(big_data + il*blowup + i2b + jl*blowup*nxb + j2b*nxb) = cval;
+				}
+			}
+
+		/* Paint missing value blocks */
+		for( jl=0; jl<nyl; jl++ )
+		for( il=0; il<nxl; il++ ) {
+			base_val  = *(little + il   + jl*nxl);
+			if( is_fill( base_val, fill_val, criterion )) {
+				for( j2b=0; j2b<blowup; j2b++ )
+				for( i2b=0; i2b<blowup; i2b++ ) {
+#ifdef CHECK_MEM
+					if( il*blowup+i2b + jl*nxb*blowup + j2b*nxb >= array_size ) { fprintf( stderr, "mem error 016\n" ); exit(-1); }
+#endif
+					*(big_data + il*blowup+i2b + jl*nxb*blowup + j2b*nxb ) = base_val;
+					}
+				}
+			}
+
+		}	/* end of BLOWUP_BILINEAR case */
+}
+
+/******************************************************************************
+ * Same as close_enough( data, fill ), given close_enough's criterion for
+ * this fill value.  This is simple enough to be inlined, which lets the
+ * loops below vectorize.
+ */
+	static int
+is_fill( float data, float fill, float criterion )
+{
+	float	diff;
+
+	diff = data - fill;
+	diff = (diff < 0.0f) ? -diff : diff;
+
+	return( diff <= criterion );
+}
+
+/******************************************************************************
+ * Bilinear interpolation for the part of the big array that lies between
+ * the center points of the little array's cells.
+ *
+ * This gives exactly the same values as the old way of doing it, which was
+ * to draw "horizontal base lines" (rows through the centers, linearly
+ * interpolated between centers), then "vertical base lines" (the same for
+ * columns), then to estimate each interior point both from the vertical base
+ * lines on either side of it (est1) and the horizontal ones above and below
+ * it (est2), and average the two.  But that meant reading four scattered
+ * values from the big array for each point.  Instead, once the horizontal
+ * base lines are done, we go up the big array a row at a time, keeping the
+ * current value of each vertical base line in vval and the vertical change
+ * between the two horizontal base lines in del_y.  Then each row is a pass
+ * that reads and writes contiguous memory, with no function calls or
+ * branches in the inner loop.  The rows are done in strips of about
+ * EXPAND_STRIP_NX points so that the two horizontal base lines and the rows
+ * between them stay in the cache.
+ */
+	static void
+bilinear_interior( float *big_data, float *little, size_t nxl, size_t nyl,
+		float fill_val, float criterion, int blowup, int offset_xb, int offset_yb )
+{
+	size_t	nxb, strip_nxl, il0, il1, x0, x1, x, work_size;
+	long	il, jl, i2b, j2b;
+	int	miss_base, miss_right, miss_below, m1, m2;
+	float	*work, *vval, *vstep, *frac, *del_y;
+	float	*row, *row0, *row1;
+	float	base_val, right_val, below_val, val, step, bupr, frac_y;
+	float	est1, est2, avg, bx, dx;
+
+	nxb  = nxl*blowup;
+	bupr = 1.0/(float)blowup;
+
+	/* Horizontal base lines */
+	for( jl=0; jl<nyl; jl++ ) {
+		row = big_data + jl*blowup*nxb + offset_yb*nxb + offset_xb;
+		for( il=0; il<nxl-1; il++ ) {
+			base_val  = *(little + il   + jl*nxl);
+			right_val = *(little + il+1 + jl*nxl);
+
+			miss_base  = is_fill(base_val,  fill_val, criterion);
+			miss_right = is_fill(right_val, fill_val, criterion);
+			if( miss_base ) {
+				/* If both are missing, this leaves the missing value */
+				step = 0.0;
+				val  = (miss_right ? base_val : right_val);
+				}
+			else if( miss_right ) {
+				/* ONLY right is missing, checked for both missing above */
+				val = base_val;
+				step = 0.0;
+				}
+			else
+				{
+				/* NEITHER missing */
+				step = (right_val-base_val)*bupr;
+				val = base_val;
+				}
+
+			for( i2b=0; i2b < blowup; i2b++ ) {
+				*(row + il*blowup + i2b) = val;
+				val += step;
+				}
+			}
+		/* Fill in the last center value on the right, which was left unfilled by the above alg */
+		*(row + (nxl-1)*blowup) = *(little + (nxl-1) + jl*nxl);
+		}
+
+	/* Work arrays for one strip.  del_y is indexed by the distance
+	 * from the strip's first center point.
+	 */
+	strip_nxl = EXPAND_STRIP_NX/blowup;
+	if( strip_nxl < 1 )
+		strip_nxl = 1;
+	if( strip_nxl > nxl )
+		strip_nxl = nxl;
+	work_size = 2*(strip_nxl+1) + blowup + strip_nxl*blowup;
+	work = (float *)malloc( work_size*sizeof(float) );
+	if( work == NULL ) {
+		fprintf( stderr, "ncview: bilinear_interior: failed to allocate %ld bytes\n", work_size*sizeof(float) );
+		exit( -1 );
+		}
+	vval   = work;
+	vstep  = vval   + strip_nxl+1;
+	frac   = vstep  + strip_nxl+1;
+	del_y  = frac   + blowup;
+
+	for( i2b=0; i2b<blowup; i2b++ )
+		frac[i2b] = (float)i2b*bupr;
+
+	for( jl=0; jl<nyl-1; jl++ ) {
+		/* The horizontal base lines along the bottom and top of this row of squares */
+		row0 = big_data + jl*blowup*nxb + offset_yb*nxb + offset_xb;
+		row1 = row0 + blowup*nxb;
+
+		for( il0=0; il0<nxl; il0 += strip_nxl ) {
+			/* This strip has the vertical base lines il0 through il1-1,
+			 * and the squares between them and the next one over.
+			 * x0 and x1 are the big array offsets (from row0) to do,
+			 * at least for squares that have a right hand side.
+			 */
+			il1 = il0 + strip_nxl;
+			if( il1 > nxl )
+				il1 = nxl;
+			x0 = il0*blowup;
+			x1 = ((il1 < nxl) ? il1 : nxl-1)*blowup;
+
+			/* Vertical base lines.  There is one more of these than
+			 * we have squares, since each square needs the one on its right.
+			 */
+			for( il=il0; il<=il1 && il<nxl; il++ ) {
+				base_val  = *(little + il + jl*nxl);
+				below_val = *(little + il + (jl+1)*nxl);
+
+				miss_base  = is_fill(base_val,  fill_val, criterion);
+				miss_below = is_fill(below_val, fill_val, criterion);
+				if( miss_base ) {
+					/* If both are missing, this leaves the missing value */
+					step = 0.0;
+					val  = (miss_below ? base_val : below_val);
+					}
+				else if( miss_below ) {
+					/* ONLY below is missing, checked for both missing above */
+					val = base_val;
+					step = 0.0;
+					}
+				else
+					{
+					/* NEITHER missing */
+					step = (below_val-base_val)*bupr;
+					val = base_val;
+					}
+				vval [il-il0] = val;
+				vstep[il-il0] = step;
+				}
+
+			/* Vertical change between the horizontal base lines */
+			for( x=x0; x<x1; x++ ) {
+				if( is_fill(row0[x], fill_val, criterion) || is_fill(row1[x], fill_val, criterion))
+					del_y[x-x0] = 0.0;
+				else
+					del_y[x-x0] = row1[x] - row0[x];
+				}
+
+			/* The bottom row of the squares is the horizontal base line,
+			 * except at the centers, where the vertical base lines win.
+			 */
+			for( il=il0; il<il1; il++ )
+				row0[il*blowup] = vval[il-il0];
+
+			for( j2b=1; j2b<blowup; j2b++ ) {
+				row    = row0 + j2b*nxb;
+				frac_y = frac[j2b];
+
+				for( il=il0; il<=il1 && il<nxl; il++ )
+					vval[il-il0] += vstep[il-il0];
+
+				/* A square at a time, getting est1 from the vertical base
+				 * lines on either side and est2 from the horizontal ones
+				 * below and above
+				 */
+				for( il=il0; il<il1 && il<nxl-1; il++ ) {
+					bx = vval[il-il0];
+					if( is_fill(bx, fill_val, criterion) || is_fill(vval[il-il0+1], fill_val, criterion))
+						dx = 0.0;
+					else
+						dx = vval[il-il0+1] - bx;
+					x = il*blowup;
+					for( i2b=1; i2b<blowup; i2b++ ) {
+						est1 = frac[i2b]*dx + bx;
+						est2 = frac_y*del_y[x+i2b-x0] + row0[x+i2b];
+						avg  = (est1 + est2)*.5f;
+
+						m1 = is_fill( est1, fill_val, criterion );
+						m2 = is_fill( est2, fill_val, criterion );
+						row[x+i2b] = m1 ? (m2 ? fill_val : est2) : (m2 ? est1 : avg);
+						}
+					}
+
+				/* The centers are on the vertical base lines */
+				for( il=il0; il<il1; il++ )
+					row[il*blowup] = vval[il-il0];
+				}
+			}
+		}
+
+	/* Fill in the last center value along the top, which was left unfilled by the above alg */
+	row = big_data + (nyl-1)*blowup*nxb + offset_yb*nxb + offset_xb;
+	for( il=0; il<nxl; il++ )
+		row[il*blowup] = *(little + il + (nyl-1)*nxl);
+
+	free( work );
+}
@@ -44,6 +44,7 @@ extern NCVar *variables;
 extern Options options;
 
 static void fi_get_data_iterate( NCVar *var, size_t *virt_start_pos, size_t *count, void *data );
+static size_t dim_map_offset( NCVar *var, NCDim_map_info *dmi, size_t *complete_ndim_virt_place, int skip1, int skip2 );
 
 /************************************************************************************/
 /* return TRUE if passed the name of a file which these routines were designed
@@ -326,6 +327,7 @@ fi_get_data( NCVar *var, size_t *virt_start_pos, size_t *count, void *data )
 		}
 	virt_to_actual_place( var, virt_start_pos, act_start_pos, &file );
 
+	trace_begin( "fi_get_data", "io", file->filename );
 	if( file_type == FILE_TYPE_NETCDF )
 		netcdf_fi_get_data( file->id, var->name, act_start_pos, 
 			  count, data, (NetCDFOptions *)var->first_file->aux_data );
@@ -335,6 +337,7 @@ fi_get_data( NCVar *var, size_t *virt_start_pos, size_t *count, void *data )
 			file_type );
 		exit( -1 );
 		}
+	trace_end( "fi_get_data", "io" );
 
 	free( act_start_pos );
 }
@@ -368,6 +371,7 @@ fi_get_data_iterate( NCVar *var, size_t *virt_start_pos, size_t *count, void *da
 	for( it=virt_start_pos[0]; it<(virt_start_pos[0]+count[0]); it++ ) {
 		start2[0] = it;
 		virt_to_actual_place( var, start2, act_start_pos, &file );
+		trace_begin( "fi_get_data", "io", file->filename );
 		if( file_type == FILE_TYPE_NETCDF )
 			netcdf_fi_get_data( file->id, var->name, act_start_pos, 
 				  count2, ((float *)data)+it*prod_lower_dims, 
@@ -378,6 +382,7 @@ fi_get_data_iterate( NCVar *var, size_t *virt_start_pos, size_t *count, void *da
 				file_type );
 			exit( -1 );
 			}
+		trace_end( "fi_get_data", "io" );
 		}
 
 	free( act_start_pos );
@@ -486,11 +491,7 @@ for( i=0; i<var->n_dims; i++ ) {
 	dmi = var->dim_map_info[dim_id];
 	if( dmi != NULL ) {
 		/* It IS 2-d mapped, calculate entry in data cache where val is */
-		idx_map = 0L;
-		for( i=0; i<var->n_dims; i++ ) {
-			idx_map += complete_ndim_virt_place[i] * dmi->index_place_factor[i];
-/*printf( "dimidx=%d  place=%ld  factor=%ld  idx_so_far=%ld\n", i, complete_ndim_virt_place[i], dmi->index_place_factor[i], idx_map );*/
-			}
+		idx_map = dim_map_offset( var, dmi, complete_ndim_virt_place, -1, -1 );
 		*return_val_double = dmi->data_cache[idx_map];
 /*printf( "mapped, dim=%s loc=%ld  val=%lf\n", var->dim[dim_id]->name, idx_map, *return_val_double );*/
 		return( NC_DOUBLE );
@@ -547,6 +548,89 @@ for( i=0; i<var->n_dims; i++ ) {
 	return( ret_val );
 }
 
+/*************************************************************************************
+ * Where the value of mapped dim 'dmi' is in its data cache, for the given
+ * (complete, virtual) place.  The places along dims skip1 and skip2 are
+ * taken to be zero; either can be -1 to not skip anything.
+ */
+	static size_t
+dim_map_offset( NCVar *var, NCDim_map_info *dmi, size_t *complete_ndim_virt_place, int skip1, int skip2 )
+{
+	size_t	idx_map;
+	int	i;
+
+	idx_map = 0L;
+	for( i=0; i<var->n_dims; i++ )
+		if( (i != skip1) && (i != skip2) )
+			idx_map += complete_ndim_virt_place[i] * dmi->index_place_factor[i];
+
+	return( idx_map );
+}
+
+/*************************************************************************************
+ * Fill 'dest' with the values of dimension dim_id over a whole X-Y plane of
+ * variable var, at the (virtual) place given for the other dims.  dest[i+j*nx]
+ * gets the value at place i along x_axis_id and j along y_axis_id, where nx
+ * is the size of the X axis.  y_axis_id can be -1, in which case only the
+ * nx values along the X axis are filled in.
+ *
+ * For dims that are 2-d mapped this copies straight from the mapping var's
+ * data cache, so it's a lot quicker than calling fi_dim_value for every
+ * point.  Other dims use the values in the NCDim (as float).  Returns -1 if
+ * the dim has no values to give, 0 otherwise.
+ */
+	int
+fi_dim_values_2d( NCVar *var, int dim_id, int x_axis_id, int y_axis_id, size_t *complete_ndim_virt_place,
+		float *dest )
+{
+	NCDim_map_info	*dmi;
+	NCDim	*d;
+	size_t	nx, ny, ii, jj, fx, fy;
+	float	*src, val;
+
+	nx = var->size[x_axis_id];
+	ny = (y_axis_id < 0) ? 1L : var->size[y_axis_id];
+
+	dmi = var->dim_map_info[dim_id];
+	if( dmi == NULL ) {
+		d = var->dim[dim_id];
+		if( (d == NULL) || (d->values == NULL) )
+			return( -1 );
+		if( dim_id == x_axis_id ) {
+			for( jj=0; jj<ny; jj++ )
+				memcpy( dest + jj*nx, d->values, nx*sizeof(float) );
+			}
+		else
+			{
+			for( jj=0; jj<ny; jj++ ) {
+				val = d->values[ (dim_id == y_axis_id) ? jj : complete_ndim_virt_place[dim_id] ];
+				for( ii=0; ii<nx; ii++ )
+					dest[ii + jj*nx] = val;
+				}
+			}
+		return( 0 );
+		}
+
+	src = dmi->data_cache + dim_map_offset( var, dmi, complete_ndim_virt_place, x_axis_id, y_axis_id );
+	fx  = dmi->index_place_factor[x_axis_id];
+	fy  = (y_axis_id < 0) ? 0L : dmi->index_place_factor[y_axis_id];
+
+	if( (fx == 1L) && ((fy == nx) || (ny == 1L)) )
+		memcpy( dest, src, nx*ny*sizeof(float) );
+	else if( fx == 1L ) {
+		for( jj=0; jj<ny; jj++ )
+			memcpy( dest + jj*nx, src + jj*fy, nx*sizeof(float) );
+		}
+	else
+		{
+		for( jj=0; jj<ny; jj++ )
+		for( ii=0; ii<nx; ii++ )
+			dest[ii + jj*nx] = src[ii*fx + jj*fy];
+		}
+
+	return( 0 );
+}
+
 /*************************************************************************************
  * Does this data file have *values* for the dimensions?
  */
@@ -584,7 +584,9 @@ void netcdf_fi_get_data( int fileid, char *var_name, size_t *start_pos,
 			fprintf( stderr, "[%d]: %ld %ld\n", i, *(start_pos+i), *(count+i) );
 		}
 
+	timing_start( TIMING_READ );
 	err = nc_get_vara_float( gid, varid, start_pos, count, data );
+	timing_stop( TIMING_READ );
 	if( err != NC_NOERR ) {
 		fprintf( stderr, "netcdf_fi_get_data: error on nc_get_vara_float call\n" );
 		fprintf( stderr, "cdfid=%d   variable=%s\n", fileid, var_name );
@@ -596,6 +598,22 @@ void netcdf_fi_get_data( int fileid, char *var_name, size_t *start_pos,
 		exit( -1 );
 		}
 
+	netcdf_fix_data( data, tot_size, aux_data );
+
+	if( options.debug ) 
+		fprintf( stderr, "returning from netcdf_fi_get_data\n" );
+}
+
+/*******************************************************************************************
+ * The data straight from nc_get_vara_float: turn NaNs into the fill value,
+ * and apply the scale_factor and add_offset attributes.
+ */
+void netcdf_fix_data( float *data, size_t tot_size, NetCDFOptions *aux_data )
+{
+	size_t	i;
+
+	timing_start( TIMING_SCALE );
+
 	/* Eliminate nans */
         for( i=0L; i<tot_size; i++ ) {
 		if( isnan(data[i]))
@@ -649,8 +667,7 @@ void netcdf_fi_get_data( int fileid, char *var_name, size_t *start_pos,
 				*(data+i) = *(data+i) * aux_data->scale_factor;
 		}
 
-	if( options.debug ) 
-		fprintf( stderr, "returning from netcdf_fi_get_data\n" );
+	timing_stop( TIMING_SCALE );
 }
 
 /*******************************************************************************************/
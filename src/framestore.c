@@ -0,0 +1,524 @@
+/*
+ * Ncview by David W. Pierce.  A visual netCDF file viewer.
+ * Copyright (C) 1993 through 2010 David W. Pierce
+ *
+ * This program  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License, version 3, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * David W. Pierce
+ * 6259 Caminito Carrena
+ * San Diego, CA  92122
+ * dpierce@ucsd.edu
+ */
+
+/* The framestore: frames that have already been converted to pixels,
+ * kept so that going back to them (when animating, for instance) doesn't
+ * mean reading and converting the data again.
+ *
+ * Frames are kept both as shown and at the resolution of the data (see
+ * FrameStore in ncview.defines.h), so that changing the blowup doesn't
+ * lose them.  Each frame is stored on its own, run-length encoded.  The frames are
+ * mostly long runs of the same color (especially when blown up), so this
+ * usually makes them several times smaller, and both packing and unpacking
+ * are fast.  Frames are kept in memory up to options.framestore_mb; when
+ * that is full, the least recently used frame is dropped to make room.
+ * If options.framestore_spill_mb is set, dropped frames go into a
+ * memory-mapped temporary file of that size instead, which is used as a
+ * ring: when it fills up, the oldest spilled frames are overwritten.
+ */
+
+#include "ncview.includes.h"
+#include "ncview.defines.h"
+#include "ncview.protos.h"
+
+#include <sys/mman.h>
+
+extern Options    options;
+extern FrameStore framestore;
+
+static int		spill_fd   = -1;
+static unsigned char	*spill_map = NULL;	/* The spill file, mapped into memory */
+static size_t		spill_size = 0L,
+			spill_pos  = 0L;	/* Where the next spilled frame goes */
+static unsigned char	*scratch   = NULL;	/* Room for one compressed frame */
+static size_t		scratch_size = 0L;
+
+static void	framestore_free_entry( FrameStoreEntry *fe );
+static void	framestore_evict( size_t nbytes_needed );
+static void	framestore_spill( FrameStoreEntry *fe );
+static int	framestore_open_spill( void );
+static size_t	rle_encode( unsigned char *src, size_t n, unsigned char *dest );
+static void	rle_decode( unsigned char *src, size_t nsrc, unsigned char *dest, size_t n );
+
+/*******************************************************************************
+ * Throw away everything in the framestore, and set it up to hold 'nt'
+ * frames of nx by ny pixels.  The size of the frames kept at data
+ * resolution is set by the first one that is saved.
+ */
+	void
+framestore_init( size_t nx, size_t ny, size_t nt )
+{
+	int	k;
+	size_t	i;
+
+	for( k=0; k<FRAMES_N_SETS; k++ ) {
+		if( framestore.set[k].entry != NULL ) {
+			for( i=0; i<framestore.nt; i++ )
+				framestore_free_entry( framestore.set[k].entry+i );
+			free( framestore.set[k].entry );
+			}
+		framestore.set[k].entry = (FrameStoreEntry *)malloc( nt*sizeof(FrameStoreEntry) );
+		if( framestore.set[k].entry == NULL ) {
+			fprintf( stderr, "ncview: framestore_init: failed to allocate list of %ld frames\n", nt );
+			exit( -1 );
+			}
+		for( i=0; i<nt; i++ ) {
+			framestore.set[k].entry[i].where = FRAME_NONE;
+			framestore.set[k].entry[i].data  = NULL;
+			}
+		}
+
+	framestore.nt         = nt;
+	framestore.bytes_used = 0L;
+	framestore.set[FRAMES_DATA].nx = 0L;
+	framestore.set[FRAMES_DATA].ny = 0L;
+	spill_pos             = 0L;
+
+	framestore.valid = TRUE;
+	framestore_resize( nx, ny );
+
+	if( options.debug )
+		fprintf( stderr, "framestore_init: %ld frames of %ld x %ld, budget %d MB, spill %d MB\n",
+			nt, nx, ny, options.framestore_mb, options.framestore_spill_mb );
+}
+
+/*******************************************************************************
+ * The frames being shown are now nx by ny pixels (because the blowup has
+ * changed).  This throws away the saved frames of the old size, but keeps
+ * the ones at data resolution.
+ */
+	void
+framestore_resize( size_t nx, size_t ny )
+{
+	FrameSet *fs;
+	size_t	i;
+
+	if( ! framestore.valid )
+		return;
+
+	fs = framestore.set + FRAMES_DISPLAY;
+	for( i=0; i<framestore.nt; i++ )
+		framestore_free_entry( fs->entry+i );
+	fs->nx = nx;
+	fs->ny = ny;
+}
+
+/*******************************************************************************
+ * Make room for 'nt' frames, keeping the ones we already have.  This is
+ * used when the file grows while we are looking at it.
+ */
+	void
+framestore_grow( size_t nt )
+{
+	int	k;
+	size_t	i;
+
+	if( (! framestore.valid) || (nt <= framestore.nt) )
+		return;
+
+	for( k=0; k<FRAMES_N_SETS; k++ ) {
+		framestore.set[k].entry = (FrameStoreEntry *)realloc( framestore.set[k].entry, 
+				nt*sizeof(FrameStoreEntry) );
+		if( framestore.set[k].entry == NULL ) {
+			fprintf( stderr, "ncview: framestore_grow: failed to allocate list of %ld frames\n", nt );
+			exit( -1 );
+			}
+		for( i=framestore.nt; i<nt; i++ ) {
+			framestore.set[k].entry[i].where = FRAME_NONE;
+			framestore.set[k].entry[i].data  = NULL;
+			}
+		}
+	framestore.nt = nt;
+}
+
+/*******************************************************************************
+ * Forget all the saved frames, without changing the size of the framestore.
+ */
+	void
+framestore_invalidate( void )
+{
+	int	k;
+	size_t	i;
+
+	if( ! framestore.valid )
+		return;
+
+	for( k=0; k<FRAMES_N_SETS; k++ )
+		for( i=0; i<framestore.nt; i++ )
+			framestore_free_entry( framestore.set[k].entry+i );
+	framestore.bytes_used = 0L;
+	spill_pos             = 0L;
+}
+
+/*******************************************************************************
+ * Returns TRUE if we have frame number 'frameno' of the indicated kind
+ * (FRAMES_DISPLAY or FRAMES_DATA).
+ */
+	int
+framestore_has( int which, size_t frameno )
+{
+	if( (! framestore.valid) || (frameno >= framestore.nt) )
+		return( FALSE );
+
+	return( framestore.set[which].entry[frameno].where != FRAME_NONE );
+}
+
+/*******************************************************************************
+ * If we have frame number 'frameno' of the indicated kind at size nx by ny,
+ * unpack it into 'pixels' and return TRUE.  Otherwise, return FALSE.
+ */
+	int
+framestore_get( int which, size_t frameno, size_t nx, size_t ny, ncv_pixel *pixels )
+{
+	FrameSet	*fs;
+	FrameStoreEntry *fe;
+	unsigned char	*src;
+	size_t		n;
+
+	if( (! framestore.valid) || (frameno >= framestore.nt) )
+		return( FALSE );
+
+	fs = framestore.set + which;
+	if( (nx != fs->nx) || (ny != fs->ny) )
+		return( FALSE );
+
+	fe = fs->entry + frameno;
+	if( fe->where == FRAME_NONE )
+		return( FALSE );
+
+	src = (fe->where == FRAME_IN_CORE) ? fe->data : spill_map + fe->spill_offset;
+	n   = nx*ny*sizeof(ncv_pixel);
+	if( fe->compressed )
+		rle_decode( src, fe->nbytes, (unsigned char *)pixels, n );
+	else
+		memcpy( pixels, src, n );
+
+	fe->last_used = ++framestore.clock;
+	return( TRUE );
+}
+
+/*******************************************************************************
+ * Save frame number 'frameno' of the indicated kind, which is nx by ny.
+ * A frame at data resolution that is a different size from the ones we
+ * have means the data has changed shape, so the old ones are dropped.
+ * Returns the number of bytes the frame takes in the store, or 0 if it
+ * wasn't saved.
+ */
+	size_t
+framestore_put( int which, size_t frameno, size_t nx, size_t ny, ncv_pixel *pixels )
+{
+	FrameSet	*fs;
+	FrameStoreEntry *fe;
+	unsigned char	*src;
+	size_t		i, n, nbytes, budget;
+	int		compressed;
+
+	if( (! framestore.valid) || (frameno >= framestore.nt) )
+		return( 0L );
+
+	fs = framestore.set + which;
+	if( (nx != fs->nx) || (ny != fs->ny) ) {
+		if( which == FRAMES_DISPLAY )
+			return( 0L );
+		for( i=0; i<framestore.nt; i++ )
+			framestore_free_entry( fs->entry+i );
+		fs->nx = nx;
+		fs->ny = ny;
+		}
+
+	/* Worst case for the run-length encoding is one extra byte per 128 */
+	n = nx*ny*sizeof(ncv_pixel);
+	if( scratch_size < n + n/64 + 16 ) {
+		if( scratch != NULL )
+			free( scratch );
+		scratch_size = n + n/64 + 16;
+		scratch = (unsigned char *)malloc( scratch_size );
+		if( scratch == NULL ) {
+			fprintf( stderr, "ncview: framestore_put: failed to allocate %ld bytes\n", scratch_size );
+			exit( -1 );
+			}
+		}
+
+	fe = fs->entry + frameno;
+	framestore_free_entry( fe );
+
+	nbytes = rle_encode( (unsigned char *)pixels, n, scratch );
+	if( nbytes < n ) {
+		compressed = TRUE;
+		src        = scratch;
+		}
+	else
+		{
+		compressed = FALSE;
+		nbytes     = n;
+		src        = (unsigned char *)pixels;
+		}
+
+	budget = (size_t)options.framestore_mb * 1024L * 1024L;
+	if( nbytes > budget )
+		return( 0L );
+	framestore_evict( nbytes );
+
+	fe->data = (unsigned char *)malloc( nbytes );
+	if( fe->data == NULL ) {
+		if( options.debug )
+			fprintf( stderr, "framestore_put: can't allocate %ld bytes for frame %ld\n", nbytes, frameno );
+		return( 0L );
+		}
+	memcpy( fe->data, src, nbytes );
+	fe->where      = FRAME_IN_CORE;
+	fe->compressed = compressed;
+	fe->nbytes     = nbytes;
+	fe->last_used  = ++framestore.clock;
+	framestore.bytes_used += nbytes;
+
+	if( options.debug )
+		fprintf( stderr, "framestore_put: frame %ld (set %d), %ld bytes (%.1f%%), %ld bytes in core\n",
+			frameno, which, nbytes, 100.0*(double)nbytes/(double)n, framestore.bytes_used );
+
+	return( nbytes );
+}
+
+/*******************************************************************************
+ * How much more can be put in memory before frames start being evicted.
+ */
+	size_t
+framestore_bytes_free( void )
+{
+	size_t	budget;
+
+	budget = (size_t)options.framestore_mb * 1024L * 1024L;
+	if( framestore.bytes_used >= budget )
+		return( 0L );
+	return( budget - framestore.bytes_used );
+}
+
+/*******************************************************************************
+ * Move the least recently used frames out of memory until there is room
+ * for 'nbytes_needed' more.
+ */
+	static void
+framestore_evict( size_t nbytes_needed )
+{
+	FrameStoreEntry *oldest, *fe;
+	size_t		i, budget;
+	int		k;
+
+	budget = (size_t)options.framestore_mb * 1024L * 1024L;
+
+	while( framestore.bytes_used + nbytes_needed > budget ) {
+		oldest = NULL;
+		for( k=0; k<FRAMES_N_SETS; k++ )
+		for( i=0; i<framestore.nt; i++ ) {
+			fe = framestore.set[k].entry + i;
+			if( (fe->where == FRAME_IN_CORE) &&
+			    ((oldest == NULL) || (fe->last_used < oldest->last_used)))
+				oldest = fe;
+			}
+		if( oldest == NULL )
+			break;
+		if( options.framestore_spill_mb > 0 )
+			framestore_spill( oldest );
+		else
+			framestore_free_entry( oldest );
+		}
+}
+
+/*******************************************************************************
+ * Move a frame from memory to the spill file.  If it can't be done, the
+ * frame is just thrown away.
+ */
+	static void
+framestore_spill( FrameStoreEntry *fe )
+{
+	size_t	i, end;
+	int	k;
+	FrameStoreEntry *other;
+
+	if( (spill_map == NULL) && (! framestore_open_spill()) ) {
+		framestore_free_entry( fe );
+		return;
+		}
+	if( fe->nbytes > spill_size ) {
+		framestore_free_entry( fe );
+		return;
+		}
+
+	/* The spill file is a ring.  Anything spilled earlier that is in
+	 * the way of this frame gets overwritten.
+	 */
+	if( spill_pos + fe->nbytes > spill_size )
+		spill_pos = 0L;
+	end = spill_pos + fe->nbytes;
+	for( k=0; k<FRAMES_N_SETS; k++ )
+	for( i=0; i<framestore.nt; i++ ) {
+		other = framestore.set[k].entry + i;
+		if( (other->where == FRAME_SPILLED) &&
+		    (other->spill_offset < end) && (other->spill_offset + other->nbytes > spill_pos) )
+			other->where = FRAME_NONE;
+		}
+
+	memcpy( spill_map + spill_pos, fe->data, fe->nbytes );
+
+	framestore.bytes_used -= fe->nbytes;
+	free( fe->data );
+	fe->data         = NULL;
+	fe->where        = FRAME_SPILLED;
+	fe->spill_offset = spill_pos;
+	spill_pos        = end;
+}
+
+/*******************************************************************************
+ * Make the spill file and map it into memory.  The file is removed right
+ * away, so it goes away by itself when ncview exits.  Returns TRUE on
+ * success; on failure, spilling is turned off.
+ */
+	static int
+framestore_open_spill( void )
+{
+	char	*tmpdir, fname[1024];
+	void	*map;
+
+	tmpdir = getenv( "TMPDIR" );
+	if( (tmpdir == NULL) || (strlen(tmpdir) == 0) )
+		tmpdir = "/tmp";
+	snprintf( fname, 1023, "%s/ncview_frames_XXXXXX", tmpdir );
+
+	spill_size = (size_t)options.framestore_spill_mb * 1024L * 1024L;
+	spill_fd   = mkstemp( fname );
+	if( spill_fd < 0 ) {
+		fprintf( stderr, "ncview: can't make frame spill file in %s; not spilling frames\n", tmpdir );
+		options.framestore_spill_mb = 0;
+		return( FALSE );
+		}
+	unlink( fname );
+
+	if( ftruncate( spill_fd, (off_t)spill_size ) != 0 ) {
+		fprintf( stderr, "ncview: can't make %d MB frame spill file in %s; not spilling frames\n",
+			options.framestore_spill_mb, tmpdir );
+		close( spill_fd );
+		spill_fd = -1;
+		options.framestore_spill_mb = 0;
+		return( FALSE );
+		}
+
+	map = mmap( NULL, spill_size, PROT_READ | PROT_WRITE, MAP_SHARED, spill_fd, 0 );
+	if( map == MAP_FAILED ) {
+		fprintf( stderr, "ncview: can't map frame spill file; not spilling frames\n" );
+		close( spill_fd );
+		spill_fd = -1;
+		options.framestore_spill_mb = 0;
+		return( FALSE );
+		}
+	spill_map = (unsigned char *)map;
+	spill_pos = 0L;
+
+	if( options.debug )
+		fprintf( stderr, "framestore_open_spill: %d MB spill file in %s\n", options.framestore_spill_mb, tmpdir );
+
+	return( TRUE );
+}
+
+/*******************************************************************************/
+	static void
+framestore_free_entry( FrameStoreEntry *fe )
+{
+	if( fe->where == FRAME_IN_CORE ) {
+		framestore.bytes_used -= fe->nbytes;
+		free( fe->data );
+		}
+	fe->data  = NULL;
+	fe->where = FRAME_NONE;
+}
+
+/*******************************************************************************
+ * Run-length encode n bytes from src into dest, returning the number of
+ * bytes put in dest.  This is the "PackBits" scheme: a control byte c below
+ * 128 is followed by c+1 bytes to copy as they are; a control byte of 128
+ * or more is followed by one byte to repeat c-125 times.  'dest' must have
+ * room for n + n/128 + 1 bytes.
+ */
+	static size_t
+rle_encode( unsigned char *src, size_t n, unsigned char *dest )
+{
+	size_t	i, run, lit_start, nout;
+
+	nout = 0L;
+	i    = 0L;
+	while( i < n ) {
+		/* A run of 3 or more the same is worth encoding as a run */
+		run = 1;
+		while( (i+run < n) && (run < 130) && (src[i+run] == src[i]) )
+			run++;
+		if( run >= 3 ) {
+			dest[nout++] = (unsigned char)(run + 125);
+			dest[nout++] = src[i];
+			i += run;
+			continue;
+			}
+
+		/* Otherwise, copy bytes as they are until the next such run */
+		lit_start = i;
+		while( (i < n) && (i - lit_start < 128) ) {
+			if( (i+2 < n) && (src[i] == src[i+1]) && (src[i] == src[i+2]) )
+				break;
+			i++;
+			}
+		dest[nout++] = (unsigned char)(i - lit_start - 1);
+		memcpy( dest+nout, src+lit_start, i - lit_start );
+		nout += i - lit_start;
+		}
+
+	return( nout );
+}
+
+/*******************************************************************************
+ * Undo rle_encode(), unpacking nsrc bytes from src into the n bytes of dest.
+ */
+	static void
+rle_decode( unsigned char *src, size_t nsrc, unsigned char *dest, size_t n )
+{
+	size_t	i, nout, len;
+	unsigned char c;
+
+	i    = 0L;
+	nout = 0L;
+	while( (i < nsrc) && (nout < n) ) {
+		c = src[i++];
+		if( c < 128 ) {
+			len = (size_t)c + 1;
+			if( nout + len > n )
+				len = n - nout;
+			memcpy( dest+nout, src+i, len );
+			i += (size_t)c + 1;
+			}
+		else
+			{
+			len = (size_t)c - 125;
+			if( nout + len > n )
+				len = n - nout;
+			memset( dest+nout, src[i++], len );
+			}
+		nout += len;
+		}
+}
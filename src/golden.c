@@ -0,0 +1,471 @@
+/*
+ * Ncview by David W. Pierce.  A visual netCDF file viewer.
+ * Copyright (C) 1993 through 2010 David W. Pierce
+ *
+ * This program  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License, version 3, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * David W. Pierce
+ * 6259 Caminito Carrena
+ * San Diego, CA  92122
+ * dpierce@ucsd.edu
+ */
+
+/* Golden images (the "-golden_write DIR" and "-golden_check DIR" options,
+ * run by "make golden" and "make golden_check").  A set of made-up fields
+ * are turned into pixels by data_to_pixels, without the display, and the
+ * pixel values (which are the color levels, since the colors themselves
+ * don't come into it) are written to DIR as 8-bit PGM files, or compared
+ * with the ones already there.  Any change in how the data are blown up,
+ * shrunk, zoomed, or turned into color levels shows up as a difference.
+ * To use it, write the images with a version of ncview that is known to
+ * be right, make the change, and then check against them.  The blowup and
+ * shrink images in src/golden were made by the renderer from before that
+ * code was rewritten.  The zoom and overlay ones only pin down what the
+ * current code does; see Makefile.am.
+ *
+ * The fields have a block of missing values, a missing corner, scattered
+ * missing points, and a row and column of missing values along two of the
+ * edges, since that is where the blowup and shrinking code is trickiest.
+ * They go through netcdf_fix_data first, with the missing points as NaNs,
+ * the way data read from a file would.  Every field is done at every
+ * blowup, shrink, and zoom method, right side up and upside down, with
+ * an overlay, and some of them with the other color transforms and
+ * inverted colors.  Where view_draw would make the frame from the color
+ * levels kept in the framestore (see levels_match_data), that is done
+ * too, and has to give the same image as the data does.
+ */
+
+#include "ncview.includes.h"
+#include "ncview.defines.h"
+#include "ncview.protos.h"
+
+extern Options		options;
+extern ncv_pixel	*pixel_transform;
+
+static size_t	golden_sizes[][2] = { {37, 23}, {64, 48} };
+
+/* How the data are scaled.  blowup is what options.blowup gets; if zoom
+ * isn't 0, that is used instead.  'type' is a BLOWUP_ value for blowups,
+ * and a SHRINK_METHOD_ value for shrinking.  The color transforms are
+ * only tried with the scalings that have all_colors set.
+ */
+typedef struct {
+	char	*name;
+	int	blowup, type;
+	float	zoom;
+	int	all_colors;
+} GoldenScale;
+
+static GoldenScale golden_scales[] = {
+	{ "b1",		1,  BLOWUP_REPLICATE,	 0.0, TRUE  },
+	{ "b2_repl",	2,  BLOWUP_REPLICATE,	 0.0, FALSE },
+	{ "b2_bilin",	2,  BLOWUP_BILINEAR,	 0.0, FALSE },
+	{ "b3_repl",	3,  BLOWUP_REPLICATE,	 0.0, FALSE },
+	{ "b3_bilin",	3,  BLOWUP_BILINEAR,	 0.0, TRUE  },
+	{ "b4_repl",	4,  BLOWUP_REPLICATE,	 0.0, FALSE },
+	{ "b4_bilin",	4,  BLOWUP_BILINEAR,	 0.0, FALSE },
+	{ "s2_mean",	-2, SHRINK_METHOD_MEAN,	 0.0, FALSE },
+	{ "s2_mode",	-2, SHRINK_METHOD_MODE,	 0.0, FALSE },
+	{ "s3_mean",	-3, SHRINK_METHOD_MEAN,	 0.0, TRUE  },
+	{ "s3_mode",	-3, SHRINK_METHOD_MODE,	 0.0, FALSE },
+	{ "z1.5_repl",	1,  BLOWUP_REPLICATE,	 1.5, FALSE },
+	{ "z1.5_bilin",	1,  BLOWUP_BILINEAR,	 1.5, TRUE  },
+	{ "z0.6_mean",	1,  SHRINK_METHOD_MEAN,	 0.6, FALSE },
+	{ NULL,		0,  0,			 0.0, FALSE }
+};
+
+static int	golden_render( size_t nx, size_t ny, GoldenScale *gs, int transform, int invert_physical,
+			int invert_colors, int overlay, int from_levels, unsigned char **pixels,
+			size_t *pnx, size_t *pny );
+static int	golden_compare( char *cname, char *fname, unsigned char *pixels, size_t pnx, size_t pny );
+static void	golden_make_field( float *data, size_t nx, size_t ny );
+static unsigned char *golden_make_overlay( size_t nx, size_t ny );
+static void	golden_write_pgm( char *fname, unsigned char *pixels, size_t nx, size_t ny );
+static unsigned char *golden_read_pgm( char *fname, size_t *nx, size_t *ny );
+
+/*******************************************************************************
+ * Doesn't return.  Exits with status 1 if any image is different from
+ * (or missing from) what is in the directory, when checking.
+ */
+	void
+golden_run( int argc, char **argv )
+{
+	char		*dir, fname[2048], cname[200], lname[220];
+	int		i, is, ig, iv, writing, transform, inv_phys, inv_col, ovl,
+			n_cases, n_ok, n_diff, n_missing, result;
+	size_t		nx, ny, pnx, pny;
+	unsigned char	*pixels;
+	static char	*transform_name[] = { "", "lin", "low", "hi" };
+
+	dir     = NULL;
+	writing = FALSE;
+	for( i=1; i<argc-1; i++ ) {
+		if( strcmp( argv[i], "-golden_write" ) == 0 ) {
+			writing = TRUE;
+			dir     = argv[i+1];
+			}
+		else if( strcmp( argv[i], "-golden_check" ) == 0 )
+			dir = argv[i+1];
+		}
+	if( dir == NULL ) {
+		fprintf( stderr, "Error, -golden_write and -golden_check must be followed by the directory of images\n" );
+		exit( -1 );
+		}
+
+	/* As on a TrueColor display, the pixel values are the color levels */
+	options.display_type = TrueColor;
+	pixel_transform = (ncv_pixel *)malloc( (options.n_colors + options.n_extra_colors)*sizeof(ncv_pixel) );
+	for( i=0; i<options.n_colors + options.n_extra_colors; i++ )
+		pixel_transform[i] = (ncv_pixel)i;
+
+	n_cases   = 0;
+	n_ok      = 0;
+	n_diff    = 0;
+	n_missing = 0;
+	for( is=0; is<sizeof(golden_sizes)/sizeof(golden_sizes[0]); is++ )
+	for( ig=0; golden_scales[ig].name != NULL; ig++ )
+	for( iv=0; iv<6; iv++ ) {
+		nx = golden_sizes[is][0];
+		ny = golden_sizes[is][1];
+
+		/* Every scaling right side up, upside down, and with an overlay;
+		 * the color transforms and inverted colors only with a few of them
+		 */
+		if( (iv >= 2) && (iv <= 4) && (! golden_scales[ig].all_colors) )
+			continue;
+		transform = TRANSFORM_NONE;
+		inv_phys  = FALSE;
+		inv_col   = FALSE;
+		ovl       = FALSE;
+		switch( iv ) {
+			case 0: break;
+			case 1: inv_phys  = TRUE; 		break;
+			case 2: transform = TRANSFORM_LOW;	break;
+			case 3: transform = TRANSFORM_HI;	break;
+			case 4: inv_col   = TRUE;		break;
+			case 5: ovl       = TRUE;		break;
+			}
+
+		snprintf( cname, 199, "%ldx%ld_%s_%s%s%s%s", (long)nx, (long)ny, golden_scales[ig].name,
+			transform_name[transform], inv_phys ? "_invphys" : "", inv_col ? "_invcol" : "",
+			ovl ? "_ovl" : "" );
+		snprintf( fname, 2047, "%s/%s.pgm", dir, cname );
+
+		if( golden_render( nx, ny, golden_scales+ig, transform, inv_phys, inv_col, ovl, FALSE,
+				&pixels, &pnx, &pny ) < 0 ) {
+			fprintf( stderr, "ncview: golden: couldn't make image %s\n", cname );
+			exit( -1 );
+			}
+		n_cases++;
+
+		if( writing ) {
+			golden_write_pgm( fname, pixels, pnx, pny );
+			printf( "golden: %-40s wrote %ld x %ld\n", cname, (long)pnx, (long)pny );
+			free( pixels );
+			continue;
+			}
+
+		result = golden_compare( cname, fname, pixels, pnx, pny );
+		n_ok      += (result == 0);
+		n_diff    += (result > 0);
+		n_missing += (result < 0);
+		free( pixels );
+
+		/* The same image again, from the color levels.  golden_render
+		 * has set the options, so we can ask if view_draw would do this.
+		 */
+		if( levels_match_data() ) {
+			snprintf( lname, 219, "%s (levels)", cname );
+			golden_render( nx, ny, golden_scales+ig, transform, inv_phys, inv_col, ovl, TRUE,
+				&pixels, &pnx, &pny );
+			n_cases++;
+			result = golden_compare( lname, fname, pixels, pnx, pny );
+			n_ok      += (result == 0);
+			n_diff    += (result > 0);
+			n_missing += (result < 0);
+			free( pixels );
+			}
+		}
+
+	if( writing ) {
+		printf( "golden: wrote %d images to %s\n", n_cases, dir );
+		exit( 0 );
+		}
+	printf( "golden: %d images, %d ok, %d different, %d missing\n", n_cases, n_ok, n_diff, n_missing );
+	exit( ((n_diff > 0) || (n_missing > 0)) ? 1 : 0 );
+}
+
+/*******************************************************************************
+ * Compares an image with the one in fname, and says how it went.  Returns
+ * 0 if they are the same, 1 if they are different, and -1 if there is no
+ * image to compare with.
+ */
+	static int
+golden_compare( char *cname, char *fname, unsigned char *pixels, size_t pnx, size_t pny )
+{
+	unsigned char	*gold;
+	size_t		gnx, gny, k, n_pix_diff, first_diff;
+	int		max_diff, d;
+
+	if( (gold = golden_read_pgm( fname, &gnx, &gny )) == NULL ) {
+		printf( "golden: %-40s MISSING (no %s)\n", cname, fname );
+		return( -1 );
+		}
+	if( (gnx != pnx) || (gny != pny) ) {
+		printf( "golden: %-40s DIFFERENT size: %ld x %ld, golden image is %ld x %ld\n",
+			cname, (long)pnx, (long)pny, (long)gnx, (long)gny );
+		free( gold );
+		return( 1 );
+		}
+
+	n_pix_diff = 0L;
+	first_diff = 0L;
+	max_diff   = 0;
+	for( k=0; k<pnx*pny; k++ ) {
+		if( pixels[k] == gold[k] )
+			continue;
+		if( n_pix_diff++ == 0L )
+			first_diff = k;
+		d = abs( (int)pixels[k] - (int)gold[k] );
+		if( d > max_diff )
+			max_diff = d;
+		}
+	free( gold );
+
+	if( n_pix_diff == 0L ) {
+		printf( "golden: %-40s ok\n", cname );
+		return( 0 );
+		}
+	printf( "golden: %-40s DIFFERENT pixels=%ld of %ld max_level_diff=%d first=(%ld,%ld)\n",
+		cname, (long)n_pix_diff, (long)(pnx*pny), max_diff,
+		(long)(first_diff%pnx), (long)(first_diff/pnx) );
+	return( 1 );
+}
+
+/*******************************************************************************
+ * Make one image, from the data the way data_to_pixels does, or (if
+ * from_levels) from the color levels the way view_draw does when the frame
+ * is in the framestore.  Returns -1 if data_to_pixels couldn't do it.
+ */
+	static int
+golden_render( size_t nx, size_t ny, GoldenScale *gs, int transform, int invert_physical,
+		int invert_colors, int overlay, int from_levels, unsigned char **pixels,
+		size_t *pnx, size_t *pny )
+{
+	NCVar		var;
+	View		v;
+	size_t		sizes[2];
+	float		*data, min, max;
+	NetCDFOptions	nc_opts;
+	int		err, old_doit;
+	unsigned char	*old_overlay;
+	ncv_pixel	*levels;
+
+	options.blowup          = gs->blowup;
+	options.zoom            = gs->zoom;
+	options.zoom_filter     = ZOOM_FILTER_AUTO;
+	options.transform       = transform;
+	options.invert_physical = invert_physical;
+	options.invert_colors   = invert_colors;
+	if( (gs->blowup < 0) || ((gs->zoom > 0.0) && (gs->zoom < 1.0)) )
+		options.shrink_method = gs->type;
+	else
+		options.blowup_type   = gs->type;
+
+	old_doit    = options.overlay->doit;
+	old_overlay = options.overlay->overlay;
+	options.overlay->doit    = overlay;
+	options.overlay->overlay = overlay ? golden_make_overlay( nx, ny ) : NULL;
+
+	/* The data as it would come from a file, with a scale and offset */
+	data = (float *)malloc( nx*ny*sizeof(float) );
+	if( data == NULL ) {
+		fprintf( stderr, "ncview: golden: can't allocate space for a %ld x %ld field\n", (long)nx, (long)ny );
+		exit( -1 );
+		}
+	golden_make_field( data, nx, ny );
+	memset( &nc_opts, 0, sizeof(NetCDFOptions) );
+	nc_opts.scale_factor     = 0.5;
+	nc_opts.add_offset       = 10.0;
+	nc_opts.scale_factor_set = TRUE;
+	nc_opts.add_offset_set   = TRUE;
+	netcdf_fix_data( data, nx*ny, &nc_opts );
+
+	sizes[0] = ny;
+	sizes[1] = nx;
+	memset( &var, 0, sizeof(NCVar) );
+	var.name       = "golden";
+	var.n_dims     = 2;
+	var.size       = sizes;
+	var.fill_value = FILL_FLOAT;
+	var.effective_dimensionality = 2;
+	min = 1.0e30;
+	max = -1.0e30;
+	min_max_of( data, nx*ny, FILL_FLOAT, &min, &max );
+	var.user_min       = min;
+	var.user_max       = max;
+	var.have_set_range = TRUE;
+
+	memset( &v, 0, sizeof(View) );
+	v.variable     = &var;
+	v.data         = data;
+	v.data_status  = VDS_VALID;
+	v.x_axis_id    = 1;
+	v.y_axis_id    = 0;
+	v.scan_axis_id = -1;
+
+	view_get_scaled_size( options.blowup, nx, ny, pnx, pny );
+	v.pixels = (unsigned char *)malloc( (*pnx)*(*pny) );
+	if( v.pixels == NULL ) {
+		fprintf( stderr, "ncview: golden: can't allocate space for a %ld x %ld image\n",
+			(long)*pnx, (long)*pny );
+		exit( -1 );
+		}
+
+	if( from_levels ) {
+		levels = (ncv_pixel *)malloc( nx*ny*sizeof(ncv_pixel) );
+		if( levels == NULL ) {
+			fprintf( stderr, "ncview: golden: can't allocate space for a %ld x %ld field\n",
+				(long)nx, (long)ny );
+			exit( -1 );
+			}
+		data_to_levels( &v, levels );
+		levels_to_pixels( &v, levels, 0L, 0L, *pnx, *pny );
+		free( levels );
+		err = 0;
+		}
+	else
+		err = data_to_pixels( &v );
+
+	if( overlay )
+		free( options.overlay->overlay );
+	options.overlay->doit    = old_doit;
+	options.overlay->overlay = old_overlay;
+
+	invalidate_shrink_levels( &v );
+	free( data );
+	*pixels = v.pixels;
+	return( err );
+}
+
+/*******************************************************************************
+ * An overlay mask like a coastline: a diagonal line and a row, both one
+ * point wide, so that every blowup and shrink has to find them.
+ */
+	static unsigned char *
+golden_make_overlay( size_t nx, size_t ny )
+{
+	unsigned char	*mask;
+	size_t		i, j;
+
+	mask = (unsigned char *)calloc( OVERLAY_MASK_BYTES(nx*ny), 1 );
+	if( mask == NULL ) {
+		fprintf( stderr, "ncview: golden: can't allocate an overlay mask\n" );
+		exit( -1 );
+		}
+	for( j=0; j<ny; j++ )
+		OVERLAY_MASK_SET( mask, (j*(nx-1))/(ny-1) + j*nx );
+	for( i=0; i<nx; i++ )
+		OVERLAY_MASK_SET( mask, i + ((2*ny)/3)*nx );
+
+	return( mask );
+}
+
+/*******************************************************************************
+ * A smooth field with all the kinds of missing values we can think of.
+ * Missing points are NaNs, as netcdf_fix_data expects.
+ */
+	static void
+golden_make_field( float *data, size_t nx, size_t ny )
+{
+	size_t		i, j;
+	unsigned long	seed;
+
+	seed = 4321;
+	for( j=0; j<ny; j++ )
+	for( i=0; i<nx; i++ ) {
+		data[i+j*nx] = 40.0*sin( 0.21*i ) * cos( 0.17*j ) + 1.3*i - 0.7*j;
+
+		/* A few percent of single missing points, from a fixed sequence */
+		seed = seed*1103515245 + 12345;
+		if( ((seed >> 16) % 100) < 4 )
+			data[i+j*nx] = NAN;
+		}
+
+	/* A block in the middle, the upper right corner, the first row and
+	 * the last column
+	 */
+	for( j=ny/3; j<ny/2; j++ )
+	for( i=nx/4; i<nx/2; i++ )
+		data[i+j*nx] = NAN;
+	for( j=ny-4; j<ny; j++ )
+	for( i=nx-5; i<nx; i++ )
+		data[i+j*nx] = NAN;
+	for( i=0; i<nx; i++ )
+		data[i] = NAN;
+	for( j=0; j<ny; j++ )
+		data[nx-1+j*nx] = NAN;
+}
+
+/*******************************************************************************/
+	static void
+golden_write_pgm( char *fname, unsigned char *pixels, size_t nx, size_t ny )
+{
+	FILE	*f;
+
+	if( (f = fopen( fname, "wb" )) == NULL ) {
+		fprintf( stderr, "ncview: golden: can't open \"%s\" for writing\n", fname );
+		exit( -1 );
+		}
+	fprintf( f, "P5\n%ld %ld\n255\n", (long)nx, (long)ny );
+	if( fwrite( pixels, 1, nx*ny, f ) != nx*ny ) {
+		fprintf( stderr, "ncview: golden: error writing \"%s\"\n", fname );
+		exit( -1 );
+		}
+	fclose( f );
+}
+
+/*******************************************************************************
+ * Returns NULL if the file isn't there, or isn't a PGM file we wrote.
+ */
+	static unsigned char *
+golden_read_pgm( char *fname, size_t *nx, size_t *ny )
+{
+	FILE		*f;
+	long		lnx, lny;
+	int		maxval;
+	unsigned char	*pixels;
+
+	if( (f = fopen( fname, "rb" )) == NULL )
+		return( NULL );
+
+	if( (fscanf( f, "P5 %ld %ld %d", &lnx, &lny, &maxval ) != 3) || (maxval != 255) ||
+	    (lnx < 1) || (lny < 1) || (fgetc( f ) == EOF) ) {
+		fclose( f );
+		return( NULL );
+		}
+
+	*nx = lnx;
+	*ny = lny;
+	pixels = (unsigned char *)malloc( (*nx)*(*ny) );
+	if( (pixels == NULL) || (fread( pixels, 1, (*nx)*(*ny), f ) != (*nx)*(*ny)) ) {
+		if( pixels != NULL )
+			free( pixels );
+		fclose( f );
+		return( NULL );
+		}
+
+	fclose( f );
+	return( pixels );
+}
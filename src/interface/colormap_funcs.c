@@ -364,7 +364,6 @@ void x_create_colormap( char *name, unsigned char r[256], unsigned char g[256],
         Colormap        orig_colormap, new_colormap;
         Display         *display;
         int             i, status=0, enabled;
-        XColor          *color;
         unsigned long   plane_masks[1], pixels[1];
         Cmaplist        *cmaplist, *cml;
         static int      first_time_through = FALSE;
@@ -501,15 +500,34 @@ void x_create_colormap( char *name, unsigned char r[256], unsigned char g[256],
                         }
                 }
 
+        set_colormap_colors( cmaplist->color_list, r, g, b );
+
+        if( (options.display_type == PseudoColor) && first_time_through )
+                XStoreColors( XtDisplay(topLevel), current_colormap, current_colormap_list->color_list,
+                        options.n_colors+options.n_extra_colors );
+}
+
+/****************************************************************************************************
+ * Fill in the colors of a color list from a colormap's 256 r, g, b entries.
+ * The first options.n_extra_colors entries are white, except for entry 1,
+ * which is black (the color used for "Fill_Value" entries); the
+ * options.n_colors entries after that are interpolated from the colormap.
+ * The pixel values aren't touched.
+ */
+void set_colormap_colors( XColor *color_list, unsigned char r[256], unsigned char g[256], unsigned char b[256] )
+{
+	int	i;
+	XColor	*color;
+
         /* Set the first ten colors including black, the color used for "Fill_Value" entries */
         for( i=0; i<options.n_extra_colors; i++ ) {
-                color        = cmaplist->color_list+i;
+                color        = color_list+i;
                 color->flags = DoRed | DoGreen | DoBlue;
                 color->red   = 256*(unsigned int)255;
                 color->green = 256*(unsigned int)255;
                 color->blue  = 256*(unsigned int)255;
                 }
-        color        = cmaplist->color_list+1;
+        color        = color_list+1;
         color->flags = DoRed | DoGreen | DoBlue;
         color->red   = 256*(unsigned int)0;
         color->green = 256*(unsigned int)0;
@@ -517,7 +535,7 @@ void x_create_colormap( char *name, unsigned char r[256], unsigned char g[256],
 
         for( i=options.n_extra_colors; i<options.n_colors+options.n_extra_colors; i++ )
                 {
-                color        = cmaplist->color_list+i;
+                color        = color_list+i;
                 color->flags = DoRed | DoGreen | DoBlue;
                 color->red   = (unsigned int)
                                 (256*interp( i-options.n_extra_colors, options.n_colors, r, 256 ));
@@ -526,10 +544,6 @@ void x_create_colormap( char *name, unsigned char r[256], unsigned char g[256],
                 color->blue  = (unsigned int)
                                 (256*interp( i-options.n_extra_colors, options.n_colors, b, 256 ));
                 }
-
-        if( (options.display_type == PseudoColor) && first_time_through )
-                XStoreColors( XtDisplay(topLevel), current_colormap, current_colormap_list->color_list,
-                        options.n_colors+options.n_extra_colors );
 }
 
 /****************************************************************************************************
@@ -618,6 +632,12 @@ char *x_change_colormap( int delta, int do_widgets_flag )
                         options.n_colors+1 );
         pixel_transform = current_colormap_list->pixel_transform;
 
+	/* On a TrueColor display, frames kept on the server hold the
+	 * actual colors, so they are no good after the colormap changes
+	 */
+	if( options.display_type == TrueColor )
+		x_invalidate_pixmap_cache();
+
         return( current_colormap_list->name );
 }
 
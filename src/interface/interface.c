@@ -160,6 +160,55 @@ in_draw_2d_field( ncv_pixel *data, size_t width, size_t height,
 	x_draw_2d_field( data, width, height, timestep );
 }
 
+/****************************************************************************
+ * Same as in_draw_2d_field, but only the rectangle of the field that
+ * starts at (x0,y0) and is nx by ny in size is drawn.
+ */
+	void
+in_draw_2d_field_region( unsigned char *data, size_t width, size_t height, size_t timestep,
+		size_t x0, size_t y0, size_t nx, size_t ny )
+{
+	x_draw_2d_field_region( data, width, height, timestep, x0, y0, nx, ny );
+}
+
+/****************************************************************************
+ * Get the part of a 2-D field of the given size that is visible on
+ * the screen.  Returns FALSE if the whole field should be drawn.
+ */
+	int
+in_get_visible_region( size_t width, size_t height, size_t *x0, size_t *y0, size_t *nx, size_t *ny )
+{
+	return( x_get_visible_region( width, height, x0, y0, nx, ny ));
+}
+
+/****************************************************************************
+ * Get the largest image that can be shown without scrollbars.
+ */
+	void
+in_get_max_2d_size( size_t *width, size_t *height )
+{
+	x_get_max_2d_size( width, height );
+}
+
+/****************************************************************************
+ * Redraw the frame for the given timestep if it is still held by the
+ * display.  Returns TRUE if it was, FALSE if it must be drawn anew.
+ */
+	int
+in_draw_cached_2d_field( size_t width, size_t height, size_t timestep )
+{
+	return( x_draw_cached_2d_field( width, height, timestep ));
+}
+
+/****************************************************************************
+ * Forget all frames that the display is holding on to.
+ */
+	void
+in_invalidate_frame_cache( void )
+{
+	x_invalidate_pixmap_cache();
+}
+
 /****************************************************************************
  * Create a colormap and fill it with the passed values.  Note that the
  * 256 color values are always filled out, although the actual number
@@ -236,6 +285,11 @@ in_set_2d_size( size_t width, size_t height )
 	void
 in_button_pressed( int button_id, int modifier )
 {
+	char	detail[64];
+
+	snprintf( detail, 63, "button %d modifier %d", button_id, modifier );
+	trace_begin( "button", "ui", detail );
+
 	switch( button_id ) {
 		case BUTTON_RANGE:
 			do_range( modifier );
@@ -330,6 +384,8 @@ in_button_pressed( int button_id, int modifier )
 			fprintf( stderr, "button id: %d\n", button_id  );
 			exit( -1 );
 		}
+
+	trace_end( "button", "ui" );
 }
 
 /*****************************************************************************
@@ -363,6 +419,25 @@ in_timer_set( XtTimerCallbackProc procedure, XtPointer arg, unsigned long delay_
 	x_timer_set( procedure, arg, delay_millisec );
 }
 
+/*****************************************************************************
+ * Have the passed procedure called, with the passed argument, whenever
+ * the user interface is idle, until it returns True.
+ */
+	void
+in_work_proc_set( XtWorkProc procedure, XtPointer arg )
+{
+	x_work_proc_set( procedure, arg );
+}
+
+/*****************************************************************************
+ * Remove the work procedure set by in_work_proc_set, if there is one.
+ */
+	void
+in_work_proc_clear()
+{
+	x_work_proc_clear();
+}
+
 /*****************************************************************************
  * Set the sensitivity to the passed button_id to 'True'.  (I.e., 
  * it is currently "greyed out"; undo that.)
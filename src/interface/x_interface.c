@@ -35,11 +35,6 @@
 #include <X11/CoreP.h>
 #include <X11/CoreP.h>
 
-#ifdef HAVE_PNG
-#include <png.h>
-#include <setjmp.h>
-#endif
-
 #define DEFAULT_BUTTON_WIDTH	55
 #define DEFAULT_LABEL_WIDTH	400
 #define DEFAULT_DIMLABEL_WIDTH	95
@@ -49,6 +44,8 @@
 #define DEFAULT_VAR_COLORS	1
 #define DEFAULT_AUTO_OVERLAY	1
 #define CBAR_HEIGHT		24
+#define DAMAGE_TILE_SIZE	64	/* frames are compared and sent to the X server in tiles this big */
+#define VIEWPORT_MARGIN		64	/* pixels around the visible part of a large image to render as well */
 
 #define XtNlabelWidth 		"labelWidth"
 #define XtCLabelWidth		"LabelWidth"
@@ -125,6 +122,9 @@ Colormap		current_colormap = (Colormap)NULL;
 
 static AppData		app_data;
 static XtIntervalId	timer;
+static XtWorkProcId	work_proc;
+static XtWorkProc	work_proc_procedure;
+static int		work_proc_enabled = FALSE;
 
 static int		timer_enabled      = FALSE,
 			ccontour_popped_up = FALSE,
@@ -144,6 +144,48 @@ Pixmap 			open_circle_pixmap,
 
 static XEvent	event;
 
+/* Server-side cache of frames that have already been drawn (see the
+ * "-pixmap_cache" option).  Each entry is one frame, already converted
+ * and uploaded into a Pixmap on the X server, so that redrawing it 
+ * takes only an XCopyArea instead of sending the whole image again.
+ */
+typedef struct {
+	Pixmap		pixmap;
+	size_t		timestep, width, height, nbytes;
+	unsigned long	last_used;
+	int		valid;
+} PixmapCacheEntry;
+
+/* What to call when a timer goes off.  Each timer gets its own, passed
+ * to Xt as the client data, so two timers pending at once each call
+ * their own procedure.
+ */
+typedef struct {
+	XtTimerCallbackProc	procedure;
+	XtPointer		client_arg;
+} TimerCall;
+
+static TimerCall	*timer_call = NULL;	/* The one x_timer_clear removes */
+
+static PixmapCacheEntry	*pixmap_cache = NULL;
+static int		pixmap_cache_n_alloc = 0;
+static size_t		pixmap_cache_bytes_used = 0L;
+static unsigned long	pixmap_cache_clock = 0L;
+static GC		pixmap_cache_gc = NULL;	/* For copying frames to the window; fetched once */
+
+/* Copy of the frame that is currently in the ccontour window, so that
+ * only the tiles that differ from it have to be sent for the next frame.
+ */
+static ncv_pixel	*last_sent_frame = NULL;
+static char		*last_sent_tile_ok = NULL;	/* TRUE if that tile in the window matches last_sent_frame */
+static size_t		last_sent_width = 0L, last_sent_height = 0L;
+
+/* The part of the frame that was last drawn, so that we know when 
+ * scrolling the viewport has uncovered some of the image that isn't there
+ */
+static size_t		last_drawn_x0 = 0L, last_drawn_y0 = 0L, last_drawn_nx = 0L, last_drawn_ny = 0L;
+static int		last_drawn_whole = TRUE;
+
 static Widget
 	error_popup_widget = NULL,
 		error_popupcanvas_widget,
@@ -160,6 +202,7 @@ static Widget
 					vert_scroll_widget,
                 		ccontour_widget,
 			ccontour_info2_widget,
+			ccontour_timing_widget,
 	commandcanvas_widget,
                 buttonbox_widget,
 			label1_widget,		/* typically title */
@@ -424,6 +467,7 @@ void 	blowup_mod1	(Widget w, XtPointer client_data, XtPointer call_data );
 void 	blowup_mod2	(Widget w, XButtonEvent *e, String *p, Cardinal *n );
 void 	blowup_mod3	(Widget w, XButtonEvent *e, String *p, Cardinal *n );
 void 	blowup_mod4	(Widget w, XButtonEvent *e, String *p, Cardinal *n );
+void 	blowup_mod5	(Widget w, XButtonEvent *e, String *p, Cardinal *n );
 void 	varlist_mod1	(Widget w, XtPointer client_data, XtPointer call_data );
 void 	xdimlist_mod1	(Widget w, XtPointer client_data, XtPointer call_data );
 void 	ydimlist_mod1	(Widget w, XtPointer client_data, XtPointer call_data );
@@ -441,11 +485,26 @@ void 	do_set_dataedit_place  (Widget w, XButtonEvent *e, String *p, Cardinal *n
 void 	do_set_min_from_curdata(Widget w, XButtonEvent *e, String *p, Cardinal *n );
 void 	do_set_max_from_curdata(Widget w, XButtonEvent *e, String *p, Cardinal *n );
 void 	expose_ccontour();
+void	viewport_scrolled( Widget w, XtPointer client_data, XtPointer call_data );
 void 	expose_colorbar();
 
 void 	testf(Widget w, XButtonEvent *e, String *p, Cardinal *n );
 
 static void 	add_callbacks( void );
+static Pixmap	pixmap_cache_store( size_t timestep, size_t width, size_t height );
+static PixmapCacheEntry *pixmap_cache_lookup( size_t timestep );
+static void	pixmap_cache_free_entry( PixmapCacheEntry *pce );
+static Boolean	x_work_proc_call( XtPointer client_arg );
+static void	x_timer_call( XtPointer client_arg, XtIntervalId *id );
+static char	*x_event_name( int type );
+static size_t	put_changed_tiles( Display *display, GC gc, XImage *ximage, unsigned char *data, 
+			size_t width, size_t height, size_t x0, size_t y0, size_t nx, size_t ny, int bytes_per_pixel );
+static void	sent_frame_set_size( size_t width, size_t height );
+static void	remember_sent_region( unsigned char *data, size_t width, size_t height, 
+			size_t x0, size_t y0, size_t nx, size_t ny );
+static void	forget_sent_frame( void );
+static void	get_viewport_rect( long *x, long *y, long *width, long *height );
+static void	get_max_2d_size( int *max_width, int *max_height );
 
 #ifdef HAVE_PNG
 static void 	dump_to_png( unsigned char *data, size_t width, size_t height,
@@ -631,6 +690,7 @@ void x_initialize()
 		{"blowup_mod2",		(XtActionProc)blowup_mod2	},
 		{"blowup_mod3",		(XtActionProc)blowup_mod3	},
 		{"blowup_mod4",		(XtActionProc)blowup_mod4	},
+		{"blowup_mod5",		(XtActionProc)blowup_mod5	},
 		{"do_plot_xy",		(XtActionProc)do_plot_xy	},
 		{"testf",		(XtActionProc)testf		},
 		{"do_quit_app",            (XtActionProc)do_quit_app             },
@@ -812,6 +872,7 @@ void x_init_widgets_ccontourpanel( Widget top )
 	ccontour_widget->core.widget_class->core_class.compress_exposure = TRUE;
 	XtAddEventHandler( ccontour_widget, ExposureMask, FALSE,
 		(XtEventHandler)expose_ccontour, NULL );
+	XtAddCallback( ccontour_viewport_widget, XtNreportCallback, viewport_scrolled, NULL );
 
 	if( options.want_extra_info )
 		ccontour_info2_widget = XtVaCreateManagedWidget(
@@ -824,6 +885,17 @@ void x_init_widgets_ccontourpanel( Widget top )
 			XtNborderWidth, 0,
 			NULL );
 
+	if( options.timing )
+		ccontour_timing_widget = XtVaCreateManagedWidget(
+			"ccontourtiming",
+			labelWidgetClass,
+			ccontour_form_widget,
+			XtNlabel, "no frames timed yet",
+			XtNwidth, 300,
+			XtNfromVert, options.want_extra_info ? ccontour_info2_widget : ccontour_widget,
+			XtNborderWidth, 0,
+			NULL );
+
 	XtAugmentTranslations( ccontour_widget,
 		XtParseTranslationTable( 
 			"#augment\n\
@@ -1106,6 +1178,7 @@ void x_init_widgets_optionbox( Widget parent )
 		XtParseTranslationTable( 
 			"Ctrl<Btn3Down>,<Btn3Up>: blowup_mod4()\n\
 			<Btn3Down>,<Btn3Up>: blowup_mod3()\n\
+			<Btn2Down>,<Btn2Up>: blowup_mod5()\n\
 			Ctrl<Btn1Down>,<Btn1Up>: blowup_mod2()" ));
 
 	transform_widget = XtVaCreateManagedWidget(
@@ -1866,42 +1939,86 @@ void create_pixmap( Widget shell_widget, Pixmap *pixmap, int id )
 
 /*************************************************************************************************/
 void x_draw_2d_field( unsigned char *data, size_t width, size_t height, size_t timestep )
+{
+	x_draw_2d_field_region( data, width, height, timestep, 0L, 0L, width, height );
+}
+
+/*************************************************************************************************
+ * Draw the rectangle of the frame that starts at (x0,y0) and is nx by ny
+ * pixels.  When only the visible part of a large image has been rendered 
+ * (see x_get_visible_region), that part is all that is valid in 'data'.
+ */
+void x_draw_2d_field_region( unsigned char *data, size_t width, size_t height, size_t timestep,
+		size_t x0, size_t y0, size_t nx, size_t ny )
 {
 	Display	*display;
 	Screen	*screen;
 	static XImage	*ximage;
 	XGCValues values;
 	GC	gc;
-	static	size_t last_width=0L, last_height=0L;
-	static 	unsigned char *tc_data=NULL;
+	static	size_t tc_n_alloc=0L, region_n_alloc=0L;
+	static 	unsigned char *tc_data=NULL, *region_data=NULL;
+	unsigned char *img_data;
+	Pixmap	pixmap;
+	size_t	nbytes, j, img_width, img_height;
+	int	bpp, whole_frame;
+
+	whole_frame = (x0 == 0) && (y0 == 0) && (nx == width) && (ny == height);
 
 #ifdef HAVE_PNG
-	if( options.dump_frames )
+	if( options.dump_frames && whole_frame )
 		dump_to_png( data, width, height, timestep );
 #endif
+	if( (options.stream_file != NULL) && whole_frame )
+		stream_frame( data, width, height, current_colormap_list->color_list,
+			options.n_colors + options.n_extra_colors );
 
 	display = XtDisplay( ccontour_widget );
 	screen  = XtScreen ( ccontour_widget );
 
+	/* The image we give to X is either the whole frame, or a copy
+	 * of just the region we are drawing
+	 */
+	if( whole_frame ) {
+		img_data   = data;
+		img_width  = width;
+		img_height = height;
+		}
+	else
+		{
+		if( region_n_alloc < nx*ny ) {
+			if( region_data != NULL )
+				free( region_data );
+			region_data = (unsigned char *)malloc( nx*ny );
+			if( region_data == NULL ) {
+				fprintf( stderr, "ncview: x_draw_2d_field_region: failed to allocate %ld bytes\n", nx*ny );
+				exit( -1 );
+				}
+			region_n_alloc = nx*ny;
+			}
+		for( j=0; j<ny; j++ )
+			memcpy( region_data + j*nx, data + (y0+j)*width + x0, nx );
+		img_data   = region_data;
+		img_width  = nx;
+		img_height = ny;
+		}
+
 	if( options.display_type == TrueColor ) {
 		/* If the TrueColor data array does not yet exist, 
-		 * or is the wrong size, then allocate it.
+		 * or is too small, then allocate it.
 		 */
-		if( tc_data == NULL ) {
-			tc_data=(unsigned char *)malloc( server.bitmap_unit*width*height );
-			last_width  = width;
-			last_height = height;
-			}
-		else if( (width!=last_width) || (height!=last_height)) {
-			free( tc_data );
-			last_width  = width;
-			last_height = height;
-			tc_data=(unsigned char *)malloc( server.bitmap_unit*width*height );
+		if( tc_n_alloc < server.bitmap_unit*img_width*img_height ) {
+			if( tc_data != NULL )
+				free( tc_data );
+			tc_n_alloc = server.bitmap_unit*img_width*img_height;
+			tc_data=(unsigned char *)malloc( tc_n_alloc );
 			}
 		/* Convert data to TrueColor representation, with
 		 * the proper number of bytes per pixel
 		 */
-		make_tc_data( data, width, height, current_colormap_list->color_list, tc_data );
+		timing_start( TIMING_TRUECOLOR );
+		make_tc_data( img_data, img_width, img_height, current_colormap_list->color_list, tc_data );
+		timing_stop( TIMING_TRUECOLOR );
 
 		ximage  = XCreateImage(
 			display,
@@ -1910,7 +2027,7 @@ void x_draw_2d_field( unsigned char *data, size_t width, size_t height, size_t t
 			ZPixmap,
 			0,
 			(char *)tc_data, 
-			(unsigned int)width, (unsigned int)height,
+			(unsigned int)img_width, (unsigned int)img_height,
 			32, 0 );
 		}
 	else /* display_type == PseudoColor */
@@ -1921,8 +2038,8 @@ void x_draw_2d_field( unsigned char *data, size_t width, size_t height, size_t t
 			XDefaultDepthOfScreen ( screen ),
 			ZPixmap,
 			0,
-			(char *)data,
-			(unsigned int)width, (unsigned int)height,
+			(char *)img_data,
+			(unsigned int)img_width, (unsigned int)img_height,
 			8, 0 );
 		}
 
@@ -1931,13 +2048,438 @@ void x_draw_2d_field( unsigned char *data, size_t width, size_t height, size_t t
 	if( !valid_display )
 		return;
 
-	XPutImage(
-		display,
-		XtWindow( ccontour_widget ),
-		gc,
-		ximage,
-		0, 0, 0, 0,
-		(unsigned int)width, (unsigned int)height );
+	/* If we are keeping frames on the server, upload this one into 
+	 * its pixmap and copy it to the window from there.  Partly
+	 * rendered frames are never kept.
+	 */
+	pixmap = None;
+	if( (options.pixmap_cache_mb > 0) && whole_frame )
+		pixmap = pixmap_cache_store( timestep, width, height );
+
+	bpp = (options.display_type == TrueColor) ? server.bytes_per_pixel : 1;
+
+	timing_start( TIMING_PUTIMAGE );
+	if( pixmap != None ) {
+		XPutImage( display, pixmap, gc, ximage,
+			0, 0, 0, 0,
+			(unsigned int)width, (unsigned int)height );
+		XCopyArea( display, pixmap, XtWindow( ccontour_widget ), gc,
+			0, 0, (unsigned int)width, (unsigned int)height, 0, 0 );
+		nbytes = width*height*bpp;
+		}
+	else
+		nbytes = put_changed_tiles( display, gc, ximage, data, width, height, x0, y0, nx, ny, bpp );
+
+	/* Wait for the server, so the time is how long it took to draw
+	 * rather than how long it took to queue the requests
+	 */
+	if( options.timing )
+		XSync( display, False );
+	timing_stop( TIMING_PUTIMAGE );
+
+	remember_sent_region( data, width, height, x0, y0, nx, ny );
+
+	last_drawn_x0 = x0;
+	last_drawn_y0 = y0;
+	last_drawn_nx = nx;
+	last_drawn_ny = ny;
+	last_drawn_whole = whole_frame;
+
+	if( options.debug )
+		fprintf( stderr, "x_draw_2d_field_region: frame %ld: sent %ld of %ld bytes to the X server\n",
+			timestep, nbytes, nx*ny*bpp );
+}
+
+/*************************************************************************************************
+ * Put the indicated region of the frame into the ccontour window, sending
+ * only those tiles that differ from what the window already holds.  Runs
+ * of such tiles along a row of tiles go out as a single request.  'ximage' 
+ * holds just the region (unless the region is the whole frame).  Returns 
+ * the number of image bytes that were sent.
+ */
+static size_t put_changed_tiles( Display *display, GC gc, XImage *ximage, unsigned char *data, 
+		size_t width, size_t height, size_t x0, size_t y0, size_t nx, size_t ny, int bytes_per_pixel )
+{
+	size_t	ktx, kty, ntiles_x, cx0, cx1, cy0, cy1, j, run_start, run_end, nbytes;
+	int	send, in_run;
+
+	sent_frame_set_size( width, height );
+	ntiles_x = (width + DAMAGE_TILE_SIZE - 1)/DAMAGE_TILE_SIZE;
+
+	nbytes = 0L;
+	for( kty=y0/DAMAGE_TILE_SIZE; kty*DAMAGE_TILE_SIZE < y0+ny; kty++ ) {
+		cy0 = kty*DAMAGE_TILE_SIZE;
+		if( cy0 < y0 )
+			cy0 = y0;
+		cy1 = (kty+1)*DAMAGE_TILE_SIZE;
+		if( cy1 > y0+ny )
+			cy1 = y0+ny;
+
+		in_run    = FALSE;
+		run_start = 0L;
+		run_end   = 0L;
+		/* Goes one tile past the region so that a run ending there gets sent */
+		for( ktx=x0/DAMAGE_TILE_SIZE; ; ktx++ ) {
+			cx0 = ktx*DAMAGE_TILE_SIZE;
+			if( cx0 < x0 )
+				cx0 = x0;
+			cx1 = (ktx+1)*DAMAGE_TILE_SIZE;
+			if( cx1 > x0+nx )
+				cx1 = x0+nx;
+
+			send = FALSE;
+			if( cx0 < x0+nx ) {
+				if( ! *(last_sent_tile_ok + kty*ntiles_x + ktx) )
+					send = TRUE;
+				for( j=cy0; (j<cy1) && (!send); j++ )
+					if( memcmp( data+j*width+cx0, last_sent_frame+j*width+cx0, cx1-cx0 ) != 0 )
+						send = TRUE;
+				}
+
+			if( send ) {
+				if( ! in_run ) {
+					in_run    = TRUE;
+					run_start = cx0;
+					}
+				run_end = cx1;
+				}
+			else if( in_run ) {
+				in_run = FALSE;
+				XPutImage( display, XtWindow( ccontour_widget ), gc, ximage,
+					(int)(run_start - x0), (int)(cy0 - y0), 
+					(int)run_start, (int)cy0,
+					(unsigned int)(run_end-run_start), (unsigned int)(cy1-cy0) );
+				nbytes += (run_end-run_start)*(cy1-cy0)*bytes_per_pixel;
+				}
+
+			if( cx0 >= x0+nx )
+				break;
+			}
+		}
+
+	return( nbytes );
+}
+
+/*************************************************************************************************
+ * Make sure the copy of what is in the ccontour window matches the 
+ * current frame size.  If it didn't, nothing in the window is known.
+ */
+static void sent_frame_set_size( size_t width, size_t height )
+{
+	size_t	ntiles;
+
+	if( (last_sent_frame != NULL) && (width == last_sent_width) && (height == last_sent_height))
+		return;
+
+	if( last_sent_frame != NULL ) {
+		free( last_sent_frame );
+		free( last_sent_tile_ok );
+		}
+
+	ntiles = ((width + DAMAGE_TILE_SIZE - 1)/DAMAGE_TILE_SIZE) *
+		 ((height + DAMAGE_TILE_SIZE - 1)/DAMAGE_TILE_SIZE);
+	last_sent_frame   = (ncv_pixel *)malloc( width*height*sizeof(ncv_pixel) );
+	last_sent_tile_ok = (char *)calloc( ntiles, sizeof(char) );
+	if( (last_sent_frame == NULL) || (last_sent_tile_ok == NULL) ) {
+		fprintf( stderr, "ncview: sent_frame_set_size: failed to allocate %ld bytes\n", 
+			width*height*sizeof(ncv_pixel) );
+		exit( -1 );
+		}
+	last_sent_width  = width;
+	last_sent_height = height;
+}
+
+/*************************************************************************************************
+ * Record that the indicated region of the frame is now in the ccontour
+ * window.  Only tiles that lie entirely inside the region become known.
+ */
+static void remember_sent_region( unsigned char *data, size_t width, size_t height, 
+		size_t x0, size_t y0, size_t nx, size_t ny )
+{
+	size_t	j, ktx, kty, ntiles_x, tx1, ty1;
+
+	sent_frame_set_size( width, height );
+	ntiles_x = (width + DAMAGE_TILE_SIZE - 1)/DAMAGE_TILE_SIZE;
+
+	for( j=y0; j<y0+ny; j++ )
+		memcpy( last_sent_frame+j*width+x0, data+j*width+x0, nx*sizeof(ncv_pixel) );
+
+	for( kty=0; kty*DAMAGE_TILE_SIZE < height; kty++ ) {
+		ty1 = (kty+1)*DAMAGE_TILE_SIZE;
+		if( ty1 > height )
+			ty1 = height;
+		if( (kty*DAMAGE_TILE_SIZE < y0) || (ty1 > y0+ny) )
+			continue;
+		for( ktx=0; ktx*DAMAGE_TILE_SIZE < width; ktx++ ) {
+			tx1 = (ktx+1)*DAMAGE_TILE_SIZE;
+			if( tx1 > width )
+				tx1 = width;
+			if( (ktx*DAMAGE_TILE_SIZE >= x0) && (tx1 <= x0+nx) )
+				*(last_sent_tile_ok + kty*ntiles_x + ktx) = TRUE;
+			}
+		}
+}
+
+/*************************************************************************************************/
+static void forget_sent_frame( void )
+{
+	if( last_sent_tile_ok != NULL )
+		memset( last_sent_tile_ok, 0, 
+			((last_sent_width  + DAMAGE_TILE_SIZE - 1)/DAMAGE_TILE_SIZE) *
+			((last_sent_height + DAMAGE_TILE_SIZE - 1)/DAMAGE_TILE_SIZE) );
+}
+
+/*************************************************************************************************
+ * Find the part of a width by height image that is showing in the ccontour
+ * viewport, plus a margin, rounded out to whole tiles.  Returns TRUE if that
+ * is less than the whole image, FALSE if the whole image should be drawn.
+ */
+int x_get_visible_region( size_t width, size_t height, size_t *x0, size_t *y0, size_t *nx, size_t *ny )
+{
+	long	vx, vy, vw, vh, rx0, ry0, rx1, ry1;
+
+	if( (!valid_display) || (! XtIsRealized( ccontour_widget )))
+		return( FALSE );
+
+	get_viewport_rect( &vx, &vy, &vw, &vh );
+
+	rx0 = ((vx - VIEWPORT_MARGIN)/DAMAGE_TILE_SIZE) * DAMAGE_TILE_SIZE;
+	ry0 = ((vy - VIEWPORT_MARGIN)/DAMAGE_TILE_SIZE) * DAMAGE_TILE_SIZE;
+	rx1 = ((vx + vw + VIEWPORT_MARGIN + DAMAGE_TILE_SIZE - 1)/DAMAGE_TILE_SIZE) * DAMAGE_TILE_SIZE;
+	ry1 = ((vy + vh + VIEWPORT_MARGIN + DAMAGE_TILE_SIZE - 1)/DAMAGE_TILE_SIZE) * DAMAGE_TILE_SIZE;
+	if( rx0 < 0 )
+		rx0 = 0;
+	if( ry0 < 0 )
+		ry0 = 0;
+	if( rx1 > (long)width )
+		rx1 = width;
+	if( ry1 > (long)height )
+		ry1 = height;
+
+	if( (rx0 == 0) && (ry0 == 0) && (rx1 == (long)width) && (ry1 == (long)height))
+		return( FALSE );
+
+	*x0 = rx0;
+	*y0 = ry0;
+	*nx = rx1 - rx0;
+	*ny = ry1 - ry0;
+
+	return( TRUE );
+}
+
+/*************************************************************************************************
+ * The part of the ccontour widget that is currently showing in the viewport
+ */
+static void get_viewport_rect( long *x, long *y, long *width, long *height )
+{
+	Widget		clip;
+	Position	cx, cy;
+	Dimension	cw, ch;
+
+	XtVaGetValues( ccontour_widget, 
+		XtNx, &cx, 
+		XtNy, &cy,
+		NULL );
+
+	clip = XtNameToWidget( ccontour_viewport_widget, "clip" );
+	if( clip == NULL )
+		clip = ccontour_viewport_widget;
+	XtVaGetValues( clip, 
+		XtNwidth,  &cw, 
+		XtNheight, &ch,
+		NULL );
+
+	*x      = -cx;	/* the child widget is moved up and to the left as we scroll */
+	*y      = -cy;
+	*width  = cw;
+	*height = ch;
+}
+
+/*************************************************************************************************
+ * Called when the ccontour viewport is scrolled.  If only part of the 
+ * image was drawn and we have scrolled outside of that part, draw again.
+ */
+void viewport_scrolled( Widget w, XtPointer client_data, XtPointer call_data )
+{
+	long	vx, vy, vw, vh;
+
+	if( last_drawn_whole || (!valid_display) )
+		return;
+
+	get_viewport_rect( &vx, &vy, &vw, &vh );
+	if( (vx < (long)last_drawn_x0) || (vy < (long)last_drawn_y0) ||
+	    (vx+vw > (long)(last_drawn_x0+last_drawn_nx)) || (vy+vh > (long)(last_drawn_y0+last_drawn_ny)) )
+		view_draw( TRUE, FALSE );
+}
+
+/*************************************************************************************************
+ * Draw the frame for the indicated timestep from the server-side pixmap
+ * cache.  Returns TRUE if it was drawn, FALSE if the frame is not in the
+ * cache (in which case the caller must render and send it).
+ */
+int x_draw_cached_2d_field( size_t width, size_t height, size_t timestep )
+{
+	PixmapCacheEntry *pce;
+	XGCValues	values;
+
+	if( (options.pixmap_cache_mb <= 0) || (!valid_display) || (! XtIsRealized( ccontour_widget )))
+		return( FALSE );
+
+	/* Frames being dumped to PNG files or streamed have to go through
+	 * x_draw_2d_field_region, which is where that happens
+	 */
+	if( options.dump_frames || (options.stream_file != NULL) )
+		return( FALSE );
+
+	pce = pixmap_cache_lookup( timestep );
+	if( (pce == NULL) || (pce->width != width) || (pce->height != height) )
+		return( FALSE );
+
+	if( options.debug )
+		fprintf( stderr, "x_draw_cached_2d_field: drawing frame %ld from server pixmap\n", timestep );
+
+	if( pixmap_cache_gc == NULL )
+		pixmap_cache_gc = XtGetGC( ccontour_widget, (XtGCMask)0, &values );
+	timing_start( TIMING_PUTIMAGE );
+	XCopyArea( XtDisplay( ccontour_widget ), pce->pixmap, XtWindow( ccontour_widget ), pixmap_cache_gc,
+		0, 0, (unsigned int)width, (unsigned int)height, 0, 0 );
+	if( options.timing )
+		XSync( XtDisplay( ccontour_widget ), False );
+	timing_stop( TIMING_PUTIMAGE );
+	pce->last_used = ++pixmap_cache_clock;
+
+	/* The window no longer holds the last frame that was sent, so the
+	 * next one can't be diffed against it
+	 */
+	forget_sent_frame();
+
+	return( TRUE );
+}
+
+/*************************************************************************************************
+ * Throw away all the frames held on the X server.  This must be called
+ * whenever the frames in the framestore are invalidated, and also when
+ * the colormap changes on a TrueColor display (since then the pixmaps
+ * hold actual colors rather than colormap indices).
+ */
+void x_invalidate_pixmap_cache( void )
+{
+	int	i;
+
+	/* Frames already in the window may have been drawn with other
+	 * colors, so the next one can't be diffed against them either
+	 */
+	forget_sent_frame();
+
+	if( pixmap_cache == NULL )
+		return;
+
+	for( i=0; i<pixmap_cache_n_alloc; i++ )
+		if( pixmap_cache[i].valid )
+			pixmap_cache_free_entry( pixmap_cache+i );
+
+	pixmap_cache_bytes_used = 0L;
+}
+
+/*************************************************************************************************/
+static PixmapCacheEntry *pixmap_cache_lookup( size_t timestep )
+{
+	int	i;
+
+	for( i=0; i<pixmap_cache_n_alloc; i++ )
+		if( pixmap_cache[i].valid && (pixmap_cache[i].timestep == timestep) )
+			return( pixmap_cache+i );
+
+	return( NULL );
+}
+
+/*************************************************************************************************/
+static void pixmap_cache_free_entry( PixmapCacheEntry *pce )
+{
+	XFreePixmap( XtDisplay( ccontour_widget ), pce->pixmap );
+	pixmap_cache_bytes_used -= pce->nbytes;
+	pce->pixmap = None;
+	pce->valid  = FALSE;
+}
+
+/*************************************************************************************************
+ * Returns the pixmap that the frame for the indicated timestep should be
+ * put into, making room in the cache by throwing out the least recently
+ * used frames if necessary.  Returns None if the frame can't be cached.
+ */
+static Pixmap pixmap_cache_store( size_t timestep, size_t width, size_t height )
+{
+	PixmapCacheEntry *pce, *oldest;
+	size_t		nbytes, budget;
+	int		i, bpp;
+
+	if( ! XtIsRealized( ccontour_widget ))
+		return( None );
+
+	bpp = (options.display_type == TrueColor) ? server.bytes_per_pixel : 1;
+	nbytes = width*height*bpp;
+	budget = (size_t)options.pixmap_cache_mb * 1024L * 1024L;
+	if( nbytes > budget )
+		return( None );
+
+	/* Reuse the old pixmap for this frame if it is the right size */
+	pce = pixmap_cache_lookup( timestep );
+	if( pce != NULL ) {
+		if( (pce->width == width) && (pce->height == height) ) {
+			pce->last_used = ++pixmap_cache_clock;
+			return( pce->pixmap );
+			}
+		pixmap_cache_free_entry( pce );
+		}
+
+	/* Evict least recently used frames until the new one fits */
+	while( pixmap_cache_bytes_used + nbytes > budget ) {
+		oldest = NULL;
+		for( i=0; i<pixmap_cache_n_alloc; i++ )
+			if( pixmap_cache[i].valid && 
+			    ((oldest == NULL) || (pixmap_cache[i].last_used < oldest->last_used)))
+				oldest = pixmap_cache+i;
+		if( oldest == NULL )
+			break;
+		if( options.debug )
+			fprintf( stderr, "pixmap_cache_store: evicting frame %ld\n", oldest->timestep );
+		pixmap_cache_free_entry( oldest );
+		}
+
+	/* Find an empty slot, growing the list if there is none */
+	pce = NULL;
+	for( i=0; i<pixmap_cache_n_alloc; i++ )
+		if( ! pixmap_cache[i].valid ) {
+			pce = pixmap_cache+i;
+			break;
+			}
+	if( pce == NULL ) {
+		pixmap_cache = (PixmapCacheEntry *)realloc( pixmap_cache, 
+				(pixmap_cache_n_alloc+32)*sizeof(PixmapCacheEntry) );
+		if( pixmap_cache == NULL ) {
+			fprintf( stderr, "ncview: pixmap_cache_store: failed to allocate pixmap cache list\n" );
+			exit( -1 );
+			}
+		for( i=pixmap_cache_n_alloc; i<pixmap_cache_n_alloc+32; i++ ) {
+			pixmap_cache[i].valid  = FALSE;
+			pixmap_cache[i].pixmap = None;
+			}
+		pce = pixmap_cache+pixmap_cache_n_alloc;
+		pixmap_cache_n_alloc += 32;
+		}
+
+	pce->pixmap = XCreatePixmap( XtDisplay( ccontour_widget ), XtWindow( ccontour_widget ),
+			(unsigned int)width, (unsigned int)height, 
+			XDefaultDepthOfScreen( XtScreen( ccontour_widget )));
+	pce->timestep  = timestep;
+	pce->width     = width;
+	pce->height    = height;
+	pce->nbytes    = nbytes;
+	pce->last_used = ++pixmap_cache_clock;
+	pce->valid     = TRUE;
+	pixmap_cache_bytes_used += nbytes;
+
+	return( pce->pixmap );
 }
 
 /*************************************************************************************************/
@@ -1949,6 +2491,48 @@ void x_set_speed_proc( Widget scrollbar, XtPointer client_data, XtPointer positi
 	options.frame_delay = f_pos;
 }
 
+/*************************************************************************************************
+ * The largest the window showing the image can be before we add scrollbars
+ */
+static void get_max_2d_size( int *max_width, int *max_height )
+{
+	/* options.maxsize is given in PERCENT of the maximum screen size in each direction */
+	if( options.maxsize_pct == -1 ) {
+		*max_width  = options.maxsize_width;
+		*max_height = options.maxsize_height;
+		}
+	else
+		{
+		*max_width  = (int)( ((double)options.maxsize_pct)/100.0 * (double)server.width  );
+		*max_height = (int)( ((double)options.maxsize_pct)/100.0 * (double)server.height );
+		}
+}
+
+/*************************************************************************************************
+ * The largest image (not counting the extra info lines, if any) that fits
+ * in the window without scrollbars.
+ */
+void x_get_max_2d_size( size_t *width, size_t *height )
+{
+	int		max_width, max_height;
+	Dimension	widget_height;
+
+	get_max_2d_size( &max_width, &max_height );
+	if( options.want_extra_info ) {
+		XtVaGetValues( ccontour_info1_widget, XtNheight, &widget_height, NULL );
+		max_height -= widget_height+4;
+		XtVaGetValues( ccontour_info2_widget, XtNheight, &widget_height, NULL );
+		max_height -= widget_height+4;
+		}
+	if( options.timing ) {
+		XtVaGetValues( ccontour_timing_widget, XtNheight, &widget_height, NULL );
+		max_height -= widget_height+4;
+		}
+
+	*width  = (max_width  > 1) ? max_width  : 1;
+	*height = (max_height > 1) ? max_height : 1;
+}
+
 /*************************************************************************************************/
 void x_set_2d_size( size_t width, size_t height )
 {
@@ -1959,16 +2543,7 @@ void x_set_2d_size( size_t width, size_t height )
 	int		max_width, max_height;
 	int		set_vp_coords;
 
-	/* options.maxsize is given in PERCENT of the maximum screen size in each direction */
-	if( options.maxsize_pct == -1 ) {
-		max_width  = options.maxsize_width;
-		max_height = options.maxsize_height;
-		}
-	else
-		{
-		max_width  = (int)( ((double)options.maxsize_pct)/100.0 * (double)server.width  );
-		max_height = (int)( ((double)options.maxsize_pct)/100.0 * (double)server.height );
-		}
+	get_max_2d_size( &max_width, &max_height );
 
 	horiz_scroll_widget =  XtNameToWidget( ccontour_viewport_widget, "horizontal" );
 	vert_scroll_widget  =  XtNameToWidget( ccontour_viewport_widget, "vertical"   );
@@ -1989,6 +2564,11 @@ void x_set_2d_size( size_t width, size_t height )
 					XtNheight, &widget_height, NULL );
 		new_height += widget_height+4L;
 		}
+	if( options.timing ) {
+		XtVaGetValues( ccontour_timing_widget, 
+					XtNheight, &widget_height, NULL );
+		new_height += widget_height+4L;
+		}
 	XtResizeWidget( ccontour_widget, (Dimension)new_width, (Dimension)new_height, 1 );
 
 	/* See if that is too big given our constraints */
@@ -2088,6 +2668,10 @@ void x_set_label( int id, char *string )
 			x_set_lab( ccontour_info2_widget, string, 0 );
 			break;
 
+		case LABEL_TIMING:
+			x_set_lab( ccontour_timing_widget, string, 0 );
+			break;
+
 		case LABEL_BLOWUP_TYPE:
 			x_set_lab( blowup_type_widget, string, app_data.button_width );
 			break;
@@ -2191,7 +2775,9 @@ void cmap_mod3( Widget w, XButtonEvent *event, String *params, Cardinal *num_par
 /*************************************************************************************************/
 void do_plot_xy( Widget w, XButtonEvent *event, String *params, Cardinal *num_params )
 {
+	trace_begin( "plot_XY", "compute", NULL );
 	plot_XY();
+	trace_end( "plot_XY", "compute" );
 }
 
 /*************************************************************************************************/
@@ -2408,6 +2994,12 @@ void blowup_mod4( Widget w, XButtonEvent *event, String *params, Cardinal *num_p
 	in_button_pressed( BUTTON_BLOWUP, MOD_4 );
 }
 
+/*************************************************************************************************/
+void blowup_mod5( Widget w, XButtonEvent *event, String *params, Cardinal *num_params )
+{
+	in_button_pressed( BUTTON_BLOWUP, MOD_5 );
+}
+
 /*************************************************************************************************/
 void blowup_mod3( Widget w, XButtonEvent *event, String *params, Cardinal *num_params )
 {
@@ -2500,30 +3092,122 @@ void x_process_user_input( void )
 	for(;;)
 		{
 		XtAppNextEvent( x_app_context, &event );
+		trace_begin( x_event_name( event.type ), "event", NULL );
 		XtDispatchEvent( &event );
+		trace_end( x_event_name( event.type ), "event" );
 		}
 }
+
+/*************************************************************************************************
+ * Name of an X event type, for the -trace output
+ */
+static char *x_event_name( int type )
+{
+	static char *names[] = { "", "", "KeyPress", "KeyRelease", "ButtonPress", "ButtonRelease",
+		"MotionNotify", "EnterNotify", "LeaveNotify", "FocusIn", "FocusOut", "KeymapNotify",
+		"Expose", "GraphicsExpose", "NoExpose", "VisibilityNotify", "CreateNotify",
+		"DestroyNotify", "UnmapNotify", "MapNotify", "MapRequest", "ReparentNotify",
+		"ConfigureNotify", "ConfigureRequest", "GravityNotify", "ResizeRequest",
+		"CirculateNotify", "CirculateRequest", "PropertyNotify", "SelectionClear",
+		"SelectionRequest", "SelectionNotify", "ColormapNotify", "ClientMessage",
+		"MappingNotify" };
+
+	if( (type < 2) || (type >= (int)(sizeof(names)/sizeof(names[0]))) )
+		return( "OtherEvent" );
+	return( names[type] );
+}
 	
 /*************************************************************************************************/
 void x_timer_set( XtTimerCallbackProc procedure, XtPointer client_arg, unsigned long delay_millisec )
 {
+	TimerCall *tc;
+
+	if( (tc = (TimerCall *)malloc( sizeof( TimerCall ))) == NULL ) {
+		fprintf( stderr, "ncview: x_timer_set: failed to allocate timer\n" );
+		exit( -1 );
+		}
+	tc->procedure  = procedure;
+	tc->client_arg = client_arg;
+
 	timer = XtAppAddTimeOut( 
 		x_app_context,
 		delay_millisec,
-		procedure,
-		client_arg );
+		x_timer_call,
+		(XtPointer)tc );
+	timer_call    = tc;
 	timer_enabled = TRUE;
 }
 
+/*************************************************************************************************
+ * Xt forgets about a timer once it goes off, so we do too; otherwise
+ * x_timer_clear would remove a timer that no longer exists.
+ */
+static void x_timer_call( XtPointer client_arg, XtIntervalId *id )
+{
+	TimerCall	*tc = (TimerCall *)client_arg;
+	TimerCall	call;
+
+	call = *tc;
+	if( tc == timer_call ) {
+		timer_call    = NULL;
+		timer_enabled = FALSE;
+		}
+	free( tc );
+
+	trace_begin( "timer", "xt", NULL );
+	(*call.procedure)( call.client_arg, id );
+	trace_end( "timer", "xt" );
+}
+
 /*************************************************************************************************/
 void x_timer_clear( void )
 {
 	if( timer_enabled ) {
 		XtRemoveTimeOut( timer );
+		free( timer_call );
+		timer_call    = NULL;
 		timer_enabled = FALSE;
 		}
 }
 
+/*************************************************************************************************
+ * Work procedures are called by Xt whenever there are no events waiting,
+ * until they return True.  Only one can be set at a time.
+ */
+void x_work_proc_set( XtWorkProc procedure, XtPointer client_arg )
+{
+	x_work_proc_clear();
+	work_proc_procedure = procedure;
+	work_proc = XtAppAddWorkProc( x_app_context, x_work_proc_call, client_arg );
+	work_proc_enabled = TRUE;
+}
+
+/*************************************************************************************************/
+void x_work_proc_clear( void )
+{
+	if( work_proc_enabled ) {
+		XtRemoveWorkProc( work_proc );
+		work_proc_enabled = FALSE;
+		}
+}
+
+/*************************************************************************************************
+ * Xt forgets about a work procedure by itself when it returns True, so
+ * keep track of that here.
+ */
+static Boolean x_work_proc_call( XtPointer client_arg )
+{
+	Boolean	done;
+
+	trace_begin( "work_proc", "xt", NULL );
+	done = work_proc_procedure( client_arg );
+	trace_end( "work_proc", "xt" );
+	if( done )
+		work_proc_enabled = FALSE;
+
+	return( done );
+}
+
 /*************************************************************************************************/
 void x_indicate_active_var( char *var_name )
 {
@@ -3466,8 +4150,14 @@ void expose_ccontour( Widget w, XtPointer client_data, XExposeEvent *event, Bool
 		return;
 		}
 
-	if( (event->count == 0) && (event->width > 1) && (event->height > 1))
+	/* Part of the window was lost, so the next frame must go out whole */
+	forget_sent_frame();
+
+	if( (event->count == 0) && (event->width > 1) && (event->height > 1)) {
+		trace_begin( "expose_ccontour", "xt", NULL );
 		view_draw( TRUE, FALSE );
+		trace_end( "expose_ccontour", "xt" );
+		}
 }
 
 /*************************************************************************************************/
@@ -3663,98 +4353,15 @@ void x_set_colormap_form_width( int width )
 void dump_to_png( unsigned char *data, size_t width, size_t height, size_t frameno )
 {
 	char		filename[2048];
-	FILE		*out_file;
-	png_structp	png_ptr;
-	png_infop	info_ptr;
-	png_colorp	palette;
-	int		bit_depth, i, j, n_palette;
-	unsigned char	**row_pointers;
 	static int	error_state = 0;
 
 	if( error_state == 1 ) return;
 
 	snprintf( filename, 2047, "frame.%05ld.png", frameno );
-	frameno++;
-
-	/* Open binary output file */
-	if( (out_file = fopen( filename, "wb" )) == NULL ) {
-		fprintf( stderr, "ncview: can't open PNG file %s for writing\n", filename );
-		error_state = 1;
-		return;
-		}
-
-	/* Set up PNG information structures */
-	png_ptr = png_create_write_struct( PNG_LIBPNG_VER_STRING, (png_voidp)NULL, NULL, NULL );	/* use default error handlers */
-	if( ! png_ptr ) {
-		fprintf( stderr, "Error returned when trying to allocate PNG write structure\n" );
-		error_state = 1;
-		return;
-		}
 
-	info_ptr = png_create_info_struct( png_ptr );
-	if( ! info_ptr ) {
-		fprintf( stderr, "Error returned when trying to allocate PNG info structure\n" );
-		png_destroy_write_struct( &png_ptr, (png_infopp)NULL );
+	if( png_queue_frame( filename, data, width, height, current_colormap_list->color_list,
+			options.n_colors + options.n_extra_colors ) != 0 )
 		error_state = 1;
-		return;
-		}
-
-	/* Set up PNG I/O ops */
-	png_init_io( png_ptr, out_file );
-
-	/* Describe our image for PNG */
-	bit_depth = 8;
-	png_set_IHDR( png_ptr, info_ptr, width, height, bit_depth, 
-		PNG_COLOR_TYPE_PALETTE,		/* ncview operates with palettes almost exclusively */
-		PNG_INTERLACE_NONE,
-		PNG_COMPRESSION_TYPE_DEFAULT,
-		PNG_FILTER_TYPE_DEFAULT );
-
-	/* Set our palette */
-	n_palette = 256;
-	palette = (png_colorp)malloc( sizeof(png_color) * n_palette );
-	if( palette == NULL ) {
-		fprintf( stderr, "Failed to allocate colormap; returning without writing output file\n" );
-		error_state = 1;
-		return;
-		}
-	for( i=0; i<n_palette; i++ ) {
-		palette[i].red   = ((current_colormap_list->color_list+i)->red   >> 8);
-		palette[i].green = ((current_colormap_list->color_list+i)->green >> 8);
-		palette[i].blue  = ((current_colormap_list->color_list+i)->blue  >> 8);
-		}
-	png_set_PLTE( png_ptr, info_ptr, palette, n_palette );
-
-	/* Make our row pointers */
-	row_pointers = (unsigned char **)malloc( sizeof( unsigned char * ) * height );
-	if( row_pointers == NULL ) {
-		fprintf( stderr, "Failed to allocate row pointers; returning without writing output file\n" );
-		error_state = 1;
-		return;
-		}
-	for( j=0; j<height; j++ ) 
-		row_pointers[j] = data + j*width;
-
-	/* Associate row pointers with the PNG structures */
-	png_set_rows( png_ptr, info_ptr, row_pointers );
-
-	/* Set up longjump target (PNG will use this for an error) */
-	if( setjmp( png_jmpbuf(png_ptr))) {
-		fprintf( stderr, "Error returned when trying to write PNG file, aborting operation\n" );
-		png_destroy_write_struct( &png_ptr, &info_ptr );
-		fclose( out_file );
-		error_state = 1;
-		return;
-		}
-
-	/* Write PNG data */
-	png_write_png( png_ptr, info_ptr, PNG_TRANSFORM_IDENTITY, NULL );
-
-	/* Delete allocated space */
-	free( row_pointers );
-	free( palette );
-
-	fclose(out_file);
 }
 #endif
 
@@ -51,6 +51,38 @@
 #include "colormaps_hotres.h"
 #include "colormaps_ssec.h"
 
+/* The built-in colormaps, in the order they are put on the colormap list */
+static struct {
+	char	*name;
+	int	*data;
+} builtin_cmaps[] = {
+	/* the following are original colormaps from ncview */
+	{ "3gauss",  cmap_3gauss  },
+	{ "detail",  cmap_detail  },
+	{ "ssec",    cmap_ssec    },
+
+	/* A. Shchepetkin: new colormaps are added here */
+	{ "bright",  cmap_bright  },
+	{ "banded",  cmap_banded  },
+	{ "rainbow", cmap_rainbow },
+	{ "jaisnb",  cmap_jaisnb  },
+	{ "jaisnc",  cmap_jaisnc  },
+	{ "jaisnd",  cmap_jaisnd  },
+	{ "blu_red", cmap_blu_red },
+	{ "manga",   cmap_manga   },
+	{ "jet",     cmap_jet     },
+	{ "wheel",   cmap_wheel   },
+
+	/* the following are the rest of the original colormaps from ncview */
+	{ "3saw",    cmap_3saw    },
+	{ "bw",      cmap_bw      },
+	{ "default", cmap_default },
+	{ "extrema", cmap_extrema },
+	{ "helix",   cmap_helix   },
+	{ "helix2",  cmap_helix2  },
+	{ "hotres",  cmap_hotres  },
+	{ NULL,      NULL         } };
+
 /* Program defaults in a easy-to-find place */
 #define DEFAULT_INVERT_PHYSICAL	FALSE
 #define DEFAULT_INVERT_COLORS	FALSE
@@ -61,6 +93,8 @@
 #define DEFAULT_BLOWUP_TYPE	BLOWUP_BILINEAR
 #define DEFAULT_SHRINK_METHOD	SHRINK_METHOD_MEAN
 #define DEFAULT_SAVEFRAMES	TRUE
+#define DEFAULT_PIXMAP_CACHE_MB	0
+#define DEFAULT_FRAMESTORE_MB	512
 #define DEFAULT_NO_AUTOFLIP	FALSE
 #define DEFAULT_LISTSEL_MAX	40
 #define DEFAULT_COLOR_BY_NDIMS	TRUE
@@ -77,8 +111,15 @@ OSC osc;
 
 static void init_cmaps_from_data();
 static void init_cmap_from_data( char *colormap_name, int *data );
+static void cmap_data_to_rgb( int *data, unsigned char r[256], unsigned char g[256], unsigned char b[256] );
 static int get_cmaps_from_dir( char *dir_name );
 
+/* ncview_nomain.c compiles this file without main(), for the programs
+ * (such as bench_kernels) that use the rest of ncview
+ */
+#ifndef NCVIEW_NO_MAIN
+static int has_arg( int argc, char **argv, char *arg );
+
 /***********************************************************************************************/
 	int
 main( int argc, char **argv )
@@ -89,6 +130,12 @@ main( int argc, char **argv )
 	/* Initialize misc constants */
 	initialize_misc();
 
+	/* The golden images ("make golden" and "make golden_check") need
+	 * no file or display
+	 */
+	if( has_arg( argc, argv, "-golden_write" ) || has_arg( argc, argv, "-golden_check" ))
+		golden_run( argc, argv );		/* Doesn't return */
+
 	/* Read in our state file from a previous run of ncview 
 	 */
 	read_in_state = NULL;	/* Note: a global var. Set to null to flag following routine to make a new stringlist */
@@ -98,8 +145,12 @@ main( int argc, char **argv )
 	else
 		found_state_file = FALSE;
 
-	in_parse_args               ( &argc, argv );
+	/* The benchmark and batch modes don't use the display at all */
+	if( (! has_arg( argc, argv, "-bench" )) && (! has_arg( argc, argv, "-batch" )) )
+		in_parse_args       ( &argc, argv );
 	input_files = parse_options ( argc,  argv );
+	if( options.stream_file != NULL )
+		stream_open();
 	determine_file_type         ( input_files );
 
 	options.window_title = input_files->string;
@@ -113,6 +164,15 @@ main( int argc, char **argv )
 		exit( -1 );
 		}
 
+	if( options.bench ) {
+		overlay_init();
+		bench_run( input_files );	/* Doesn't return */
+		}
+	if( options.batch ) {
+		overlay_init();
+		batch_run();			/* Doesn't return */
+		}
+
 	/* If any vars are in groups, we build the interface differently. 
 	 * I pass this information through the global "options" struct.
 	 */
@@ -157,6 +217,22 @@ main( int argc, char **argv )
 	return(0);
 }
 
+/***********************************************************************************************
+ * Is 'arg' one of the command line arguments?  For options we need to know
+ * about before the arguments are parsed.
+ */
+	static int
+has_arg( int argc, char **argv, char *arg )
+{
+	int	i;
+
+	for( i=1; i<argc; i++ )
+		if( strcmp( argv[i], arg ) == 0 )
+			return( TRUE );
+	return( FALSE );
+}
+#endif	/* NCVIEW_NO_MAIN */
+
 // ---- BEGIN SYSSON ----
 void initialize_sonfication( Stringlist *input_files ) {
 	char *input_file;
@@ -232,9 +308,305 @@ parse_options( int argc, char *argv[] )
 				exit( 0 );
 				}
 
+			else if( strncmp( argv[i], "-prerender", 10 ) == 0 )
+				options.prerender = TRUE;
+
 			else if( strncmp( argv[i], "-pri", 4 ) == 0 )
 				options.private_colormap = TRUE;
 
+			else if( strncmp( argv[i], "-pixmap_cache", 13 ) == 0 ) {
+				if( (i == (argc-1)) || 
+				    (sscanf( argv[i+1], "%d", &(options.pixmap_cache_mb) ) != 1) ||
+				    (options.pixmap_cache_mb < 0) ) {
+					fprintf( stderr, "Error, -pixmap_cache argument must be followed by the number of MB of X server memory to use\n" );
+					exit(-1);
+					}
+				i++;
+				}
+
+			else if( strncmp( argv[i], "-framestore_mb", 14 ) == 0 ) {
+				if( (i == (argc-1)) || 
+				    (sscanf( argv[i+1], "%d", &(options.framestore_mb) ) != 1) ||
+				    (options.framestore_mb < 0) ) {
+					fprintf( stderr, "Error, -framestore_mb argument must be followed by the number of MB of memory to keep frames in\n" );
+					exit(-1);
+					}
+				i++;
+				}
+
+			else if( strncmp( argv[i], "-framestore_spill", 17 ) == 0 ) {
+				if( (i == (argc-1)) || 
+				    (sscanf( argv[i+1], "%d", &(options.framestore_spill_mb) ) != 1) ||
+				    (options.framestore_spill_mb < 0) ) {
+					fprintf( stderr, "Error, -framestore_spill argument must be followed by the number of MB of temporary file to use\n" );
+					exit(-1);
+					}
+				i++;
+				}
+
+			else if( strncmp( argv[i], "-bench_var", 10 ) == 0 ) {
+				if( i == (argc-1) ) {
+					fprintf( stderr, "Error, -bench_var must be followed by the name of a variable\n" );
+					exit(-1);
+					}
+				options.bench_var = argv[i+1];
+				i++;
+				}
+
+			else if( strncmp( argv[i], "-bench_blowup", 13 ) == 0 ) {
+				if( (i == (argc-1)) || 
+				    (sscanf( argv[i+1], "%d", &(options.bench_blowup) ) != 1) ||
+				    (options.bench_blowup == 0) || (options.bench_blowup == -1) ) {
+					fprintf( stderr, "Error, -bench_blowup must be followed by the blowup to use, such as 3, or -2 to shrink by 2\n" );
+					exit(-1);
+					}
+				i++;
+				}
+
+			else if( (strncmp( argv[i], "-bench_transform", 16 ) == 0) ||
+				 (strncmp( argv[i], "-batch_transform", 16 ) == 0) ) {
+				if( (i < (argc-1)) && (strncmp( argv[i+1], "lin", 3 ) == 0) )
+					options.transform = TRANSFORM_NONE;
+				else if( (i < (argc-1)) && (strncmp( argv[i+1], "low", 3 ) == 0) )
+					options.transform = TRANSFORM_LOW;
+				else if( (i < (argc-1)) && (strncmp( argv[i+1], "hi", 2 ) == 0) )
+					options.transform = TRANSFORM_HI;
+				else
+					{
+					fprintf( stderr, "Error, %s must be followed by one of these: linear low hi\n", argv[i] );
+					exit(-1);
+					}
+				i++;
+				}
+
+			else if( strncmp( argv[i], "-bench_overlay", 14 ) == 0 ) {
+				if( i == (argc-1) ) {
+					fprintf( stderr, "Error, -bench_overlay must be followed by coasts, fine_coasts, usa, or an overlay file name\n" );
+					exit(-1);
+					}
+				options.bench_overlay = argv[i+1];
+				i++;
+				}
+
+			else if( strncmp( argv[i], "-batch_var", 10 ) == 0 ) {
+				if( i == (argc-1) ) {
+					fprintf( stderr, "Error, -batch_var must be followed by the name of a variable\n" );
+					exit(-1);
+					}
+				options.batch_var = argv[i+1];
+				i++;
+				}
+
+			else if( strncmp( argv[i], "-batch_frames", 13 ) == 0 ) {
+				if( (i < (argc-1)) && 
+				    (sscanf( argv[i+1], "%ld:%ld", &(options.batch_first), &(options.batch_last) ) == 2) &&
+				    (options.batch_first >= 0) && (options.batch_last >= options.batch_first) )
+					;
+				else if( (i < (argc-1)) && (strchr( argv[i+1], ':' ) == NULL) &&
+				    (sscanf( argv[i+1], "%ld", &(options.batch_first) ) == 1) && (options.batch_first >= 0) )
+					options.batch_last = options.batch_first;
+				else
+					{
+					fprintf( stderr, "Error, -batch_frames must be followed by the frame to do or a range such as 0:99 (frames count from 0)\n" );
+					exit(-1);
+					}
+				i++;
+				}
+
+			else if( strncmp( argv[i], "-batch_blowup", 13 ) == 0 ) {
+				if( (i == (argc-1)) || 
+				    (sscanf( argv[i+1], "%d", &(options.batch_blowup) ) != 1) ||
+				    (options.batch_blowup == 0) || (options.batch_blowup == -1) ) {
+					fprintf( stderr, "Error, -batch_blowup must be followed by the blowup to use, such as 3, or -2 to shrink by 2\n" );
+					exit(-1);
+					}
+				i++;
+				}
+
+			else if( strncmp( argv[i], "-batch_cmap", 11 ) == 0 ) {
+				if( i == (argc-1) ) {
+					fprintf( stderr, "Error, -batch_cmap must be followed by the name of a built-in colormap\n" );
+					exit(-1);
+					}
+				options.batch_cmap = argv[i+1];
+				i++;
+				}
+
+			else if( strncmp( argv[i], "-batch_range", 12 ) == 0 ) {
+				if( (i == (argc-1)) || 
+				    (sscanf( argv[i+1], "%g:%g", &(options.batch_min), &(options.batch_max) ) != 2) ||
+				    (options.batch_min >= options.batch_max) ) {
+					fprintf( stderr, "Error, -batch_range must be followed by the minimum and maximum, such as -5:30\n" );
+					exit(-1);
+					}
+				options.batch_have_range = TRUE;
+				i++;
+				}
+
+			else if( strncmp( argv[i], "-batch_overlay", 14 ) == 0 ) {
+				if( i == (argc-1) ) {
+					fprintf( stderr, "Error, -batch_overlay must be followed by coasts, fine_coasts, usa, or an overlay file name\n" );
+					exit(-1);
+					}
+				options.batch_overlay = argv[i+1];
+				i++;
+				}
+
+			else if( strncmp( argv[i], "-batch", 6 ) == 0 ) {
+				if( i == (argc-1) ) {
+					fprintf( stderr, "Error, -batch must be followed by the directory to put the PNG files in\n" );
+					exit(-1);
+					}
+				options.batch_dir = argv[i+1];
+				options.batch     = TRUE;
+				i++;
+				}
+
+			else if( strncmp( argv[i], "-png_level", 10 ) == 0 ) {
+				if( (i == (argc-1)) || 
+				    (sscanf( argv[i+1], "%d", &(options.png_level) ) != 1) ||
+				    (options.png_level < 0) || (options.png_level > 9) ) {
+					fprintf( stderr, "Error, -png_level must be followed by the compression level, 0 (none) to 9 (most)\n" );
+					exit(-1);
+					}
+				i++;
+				}
+
+			else if( strncmp( argv[i], "-png_filter", 11 ) == 0 ) {
+				if( (i < (argc-1)) && (strcmp( argv[i+1], "none" ) == 0) )
+					options.png_filter = PNG_FILTERS_NONE;
+				else if( (i < (argc-1)) && (strcmp( argv[i+1], "sub" ) == 0) )
+					options.png_filter = PNG_FILTERS_SUB;
+				else if( (i < (argc-1)) && (strcmp( argv[i+1], "up" ) == 0) )
+					options.png_filter = PNG_FILTERS_UP;
+				else if( (i < (argc-1)) && (strcmp( argv[i+1], "avg" ) == 0) )
+					options.png_filter = PNG_FILTERS_AVG;
+				else if( (i < (argc-1)) && (strcmp( argv[i+1], "paeth" ) == 0) )
+					options.png_filter = PNG_FILTERS_PAETH;
+				else if( (i < (argc-1)) && (strcmp( argv[i+1], "all" ) == 0) )
+					options.png_filter = PNG_FILTERS_ALL;
+				else
+					{
+					fprintf( stderr, "Error, -png_filter must be followed by one of these: none sub up avg paeth all\n" );
+					exit(-1);
+					}
+				i++;
+				}
+
+			else if( strncmp( argv[i], "-png_threads", 12 ) == 0 ) {
+				if( (i == (argc-1)) || 
+				    (sscanf( argv[i+1], "%d", &(options.png_threads) ) != 1) ||
+				    (options.png_threads < 1) ) {
+					fprintf( stderr, "Error, -png_threads must be followed by the number of threads to write PNG files in\n" );
+					exit(-1);
+					}
+				i++;
+				}
+
+			else if( strncmp( argv[i], "-stream_format", 14 ) == 0 ) {
+				if( (i < (argc-1)) && (strcmp( argv[i+1], "y4m" ) == 0) )
+					options.stream_format = STREAM_Y4M;
+				else if( (i < (argc-1)) && (strcmp( argv[i+1], "rgb" ) == 0) )
+					options.stream_format = STREAM_RGB;
+				else
+					{
+					fprintf( stderr, "Error, -stream_format must be followed by y4m or rgb\n" );
+					exit(-1);
+					}
+				i++;
+				}
+
+			else if( strncmp( argv[i], "-stream_fps", 11 ) == 0 ) {
+				if( (i == (argc-1)) || 
+				    (sscanf( argv[i+1], "%d", &(options.stream_fps) ) != 1) ||
+				    (options.stream_fps < 1) ) {
+					fprintf( stderr, "Error, -stream_fps must be followed by the number of frames per second\n" );
+					exit(-1);
+					}
+				i++;
+				}
+
+			else if( strncmp( argv[i], "-stream", 7 ) == 0 ) {
+				if( i == (argc-1) ) {
+					fprintf( stderr, "Error, -stream must be followed by the file or FIFO to write frames to, or - for stdout\n" );
+					exit(-1);
+					}
+				options.stream_file = argv[i+1];
+				i++;
+				}
+
+			else if( strncmp( argv[i], "-bench", 6 ) == 0 ) {
+				if( (i == (argc-1)) || 
+				    (sscanf( argv[i+1], "%ld", &(options.bench_frames) ) != 1) ||
+				    (options.bench_frames < 0) ) {
+					fprintf( stderr, "Error, -bench must be followed by the number of frames to do (0 for all of them)\n" );
+					exit(-1);
+					}
+				options.bench = TRUE;
+				i++;
+				}
+
+			else if( strncmp( argv[i], "-trace", 6 ) == 0 ) {
+				if( i == (argc-1) ) {
+					fprintf( stderr, "ncview: -trace must be followed by the name of the file to write\n" );
+					useage();
+					}
+				trace_open( argv[i+1] );
+				i++;
+				}
+
+			else if( strncmp( argv[i], "-timing", 7 ) == 0 ) {
+				options.timing = TRUE;
+				}
+
+			else if( strncmp( argv[i], "-threads", 8 ) == 0 ) {
+				if( (i == (argc-1)) || 
+				    (sscanf( argv[i+1], "%d", &(options.n_threads) ) != 1) ||
+				    (options.n_threads < 1) ) {
+					fprintf( stderr, "Error, -threads argument must be followed by the number of threads to use\n" );
+					exit(-1);
+					}
+				i++;
+				}
+
+			else if( strncmp( argv[i], "-zoom_filter", 12 ) == 0 ) {
+				if( i == (argc-1) ) {
+					fprintf( stderr, "Error, -zoom_filter argument must be followed by one of these: nearest box bilinear\n" );
+					exit(-1);
+					}
+				if( strncmp( argv[i+1], "near", 4 ) == 0 )
+					options.zoom_filter = ZOOM_FILTER_NEAREST;
+				else if( strncmp( argv[i+1], "box", 3 ) == 0 )
+					options.zoom_filter = ZOOM_FILTER_BOX;
+				else if( strncmp( argv[i+1], "bil", 3 ) == 0 )
+					options.zoom_filter = ZOOM_FILTER_BILINEAR;
+				else
+					{
+					fprintf( stderr, "unrecognizied option: %s %s\n",
+						argv[i], argv[i+1] );
+					/* doesn't return */
+					useage();
+					}
+				i++;
+				}
+
+			else if( strncmp( argv[i], "-zoom", 5 ) == 0 ) {
+				if( i == (argc-1) ) {
+					fprintf( stderr, "Error, -zoom argument must be followed by a zoom factor (such as 1.5) or \"fit\"\n" );
+					exit(-1);
+					}
+				if( strncmp( argv[i+1], "fit", 3 ) == 0 )
+					options.zoom_fit = TRUE;
+				else if( (sscanf( argv[i+1], "%f", &(options.zoom) ) != 1) || (options.zoom <= 0.0) ) {
+					fprintf( stderr, "Error, -zoom argument must be followed by a zoom factor (such as 1.5) or \"fit\"\n" );
+					exit(-1);
+					}
+				i++;
+				}
+
+			else if( strncmp( argv[i], "-drop_frames", 12 ) == 0 )
+				options.drop_frames = TRUE;
+
 			else if( strncmp( argv[i], "-deb", 4 ) == 0 )
 				options.debug = TRUE;
 			
@@ -287,6 +659,15 @@ parse_options( int argc, char *argv[] )
 				options.color_by_ndims = FALSE;
 				}
 
+			else if( strncmp( argv[i], "-overlay_cache", 14 ) == 0 ) {
+				if( i == (argc-1) ) {
+					fprintf( stderr, "Error, -overlay_cache must be followed by a directory name, or none\n" );
+					exit(-1);
+					}
+				options.overlay_cache_dir = argv[i+1];
+				i++;
+				}
+
 			else if( strncmp( argv[i], "-no_auto_overlay", 7 ) == 0 ) {
 				options.auto_overlay = FALSE;
 				}
@@ -392,6 +773,37 @@ initialize_misc()
 	options.small  		 = FALSE;
 	options.blowup_type      = DEFAULT_BLOWUP_TYPE;
 	options.save_frames      = DEFAULT_SAVEFRAMES;
+	options.pixmap_cache_mb  = DEFAULT_PIXMAP_CACHE_MB;
+	options.framestore_mb    = DEFAULT_FRAMESTORE_MB;
+	options.framestore_spill_mb = 0;
+	options.prerender        = FALSE;
+	options.drop_frames      = FALSE;
+	options.timing           = FALSE;
+	options.bench            = FALSE;
+	options.bench_frames     = 0L;
+	options.bench_var        = NULL;
+	options.bench_blowup     = 1;
+	options.bench_overlay    = NULL;
+	options.batch            = FALSE;
+	options.batch_dir        = NULL;
+	options.batch_var        = NULL;
+	options.batch_cmap       = "3gauss";
+	options.batch_overlay    = NULL;
+	options.batch_first      = 0L;
+	options.batch_last       = -1L;
+	options.batch_blowup     = 1;
+	options.batch_have_range = FALSE;
+	options.png_level        = -1;
+	options.png_filter       = PNG_FILTERS_DEFAULT;
+	options.png_threads      = 0;
+	options.stream_file      = NULL;
+	options.stream_format    = STREAM_Y4M;
+	options.stream_fps       = 25;
+	options.overlay_cache_dir = NULL;
+	options.n_threads        = 0;
+	options.zoom             = 0.0;
+	options.zoom_fit         = FALSE;
+	options.zoom_filter      = ZOOM_FILTER_AUTO;
 	options.no_autoflip      = DEFAULT_NO_AUTOFLIP;
 	options.t_conv      	 = TRUE;
 	options.varsel_style	 = VARSEL_LIST;
@@ -408,8 +820,10 @@ initialize_misc()
 
 	options.maxsize_pct	 = 75;	/* maximum size of a window, in percent of screen, before switching to scrollbars */
 
-	framestore.frame = NULL;
+	framestore.set[FRAMES_DISPLAY].entry = NULL;
+	framestore.set[FRAMES_DATA].entry    = NULL;
 	framestore.valid = FALSE;
+	framestore.clock = 0L;
 
 }
 
@@ -489,53 +903,55 @@ get_cmaps_from_dir( char *dir_name )
 	void
 init_cmaps_from_data()
 {
-/* the following are original colormaps from ncview */
-
-	init_cmap_from_data( "3gauss",  cmap_3gauss  );
-	init_cmap_from_data( "detail",  cmap_detail  );
-	init_cmap_from_data( "ssec",    cmap_ssec    );
-
-/* A. Shchepetkin: new colormaps are added here */
+	int	i;
 
-        init_cmap_from_data( "bright",  cmap_bright  );
-        init_cmap_from_data( "banded",  cmap_banded  );
-        init_cmap_from_data( "rainbow", cmap_rainbow );
-        init_cmap_from_data( "jaisnb",  cmap_jaisnb  );
-        init_cmap_from_data( "jaisnc",  cmap_jaisnc  );
-        init_cmap_from_data( "jaisnd",  cmap_jaisnd  );
-        init_cmap_from_data( "blu_red", cmap_blu_red );
-        init_cmap_from_data( "manga",   cmap_manga   );
-        init_cmap_from_data( "jet",     cmap_jet     );
-        init_cmap_from_data( "wheel",   cmap_wheel   );
-
-/* the following are the rest of the original colormaps from ncview */
-
-	init_cmap_from_data( "3saw",    cmap_3saw    );
-	init_cmap_from_data( "bw",      cmap_bw      );
-	init_cmap_from_data( "default", cmap_default );
-	init_cmap_from_data( "extrema", cmap_extrema );
-	init_cmap_from_data( "helix",   cmap_helix   );
-	init_cmap_from_data( "helix2",  cmap_helix2  );
-	init_cmap_from_data( "hotres",  cmap_hotres  );
+	for( i=0; builtin_cmaps[i].name != NULL; i++ )
+		init_cmap_from_data( builtin_cmaps[i].name, builtin_cmaps[i].data );
 }
 
 /***********************************************************************************************/
 	void
 init_cmap_from_data( char *colormap_name, int *data )
 {
-	int	i;
 	unsigned char r[256], g[256], b[256];
 
 	if( options.debug ) 
 		fprintf( stderr, "    ... initting cmap >%s< from supplied data\n", colormap_name );
 
+	cmap_data_to_rgb( data, r, g, b );
+	in_create_colormap( colormap_name, r, g, b );
+}
+
+/***********************************************************************************************/
+	static void
+cmap_data_to_rgb( int *data, unsigned char r[256], unsigned char g[256], unsigned char b[256] )
+{
+	int	i;
+
 	for( i=0; i<256; i++ ) {
 		r[i] = (unsigned char)data[i*3+0];
 		g[i] = (unsigned char)data[i*3+1];
 		b[i] = (unsigned char)data[i*3+2];
 		}
+}
 
-	in_create_colormap( colormap_name, r, g, b );
+/***********************************************************************************************
+ * The r, g, b entries of the built-in colormap named 'name', for when
+ * there is no display to make colormaps on (the -batch mode).  Returns
+ * -1 if there is no built-in colormap by that name.
+ */
+	int
+builtin_colormap_rgb( char *name, unsigned char r[256], unsigned char g[256], unsigned char b[256] )
+{
+	int	i;
+
+	for( i=0; builtin_cmaps[i].name != NULL; i++ )
+		if( strcmp( builtin_cmaps[i].name, name ) == 0 ) {
+			cmap_data_to_rgb( builtin_cmaps[i].data, r, g, b );
+			return( 0 );
+			}
+
+	return( -1 );
 }
 
 /***********************************************************************************************/
@@ -787,6 +1203,48 @@ fprintf( stderr, "	-autoscale: scale color map of EACH frame to range of that fr
 fprintf( stderr, "	-maxsize: specifies max size of window before scrollbars are added. Either a single\n" );
 fprintf( stderr, "              integer between 30 and 100 giving percentage, or two integers separated by a\n" );
 fprintf( stderr, "              comma giving width and height. Ex: -maxsize 75  or -maxsize 800,600\n" );
+fprintf( stderr, "	-pixmap_cache MB: keep up to MB megabytes of rendered frames on the X server, so\n" );
+fprintf( stderr, "              replaying them does not resend the image. Useful over slow (ssh -X) connections.\n" );
+fprintf( stderr, "	-framestore_mb MB: keep at most MB megabytes of (compressed) frames in memory for\n" );
+fprintf( stderr, "              fast replay; the least recently shown are dropped first (default: %d).\n", DEFAULT_FRAMESTORE_MB );
+fprintf( stderr, "	-framestore_spill MB: put frames that don't fit in memory into a temporary file of\n" );
+fprintf( stderr, "              MB megabytes (in $TMPDIR, or /tmp) instead of dropping them.\n" );
+fprintf( stderr, "	-prerender: while idle, read the frames after the current one into the framestore,\n" );
+fprintf( stderr, "              so the first time through an animation is fast too.\n" );
+fprintf( stderr, "	-drop_frames: when drawing can't keep up with the animation speed, skip frames\n" );
+fprintf( stderr, "              to stay on time instead of slowing down.\n" );
+fprintf( stderr, "	-timing: time each stage of making a frame; show the results under the image, and\n" );
+fprintf( stderr, "              every few seconds print them in more detail to stderr.\n" );
+fprintf( stderr, "	-trace FILE: write a trace of what the program is doing, with times, to FILE in the\n" );
+fprintf( stderr, "              JSON format that chrome://tracing and Perfetto can show.\n" );
+fprintf( stderr, "	-bench N: without opening the display, make N frames (0 for all of them) the way they\n" );
+fprintf( stderr, "              would be shown, and print how long each stage took.  Also -bench_var NAME,\n" );
+fprintf( stderr, "              -bench_blowup N, -bench_transform linear|low|hi, and -bench_overlay\n" );
+fprintf( stderr, "              coasts|fine_coasts|usa|FILE; -zoom, -zoom_filter and -threads apply too.\n" );
+fprintf( stderr, "	-batch DIR: without opening the display, write the frames of every 2-D variable the\n" );
+fprintf( stderr, "              way they would be shown to DIR as VAR.NNNNNN.png, several frames at once.\n" );
+fprintf( stderr, "              Also -batch_var NAME, -batch_frames FIRST:LAST, -batch_blowup N, -batch_cmap\n" );
+fprintf( stderr, "              NAME (a built-in colormap; default 3gauss), -batch_range MIN:MAX, -batch_transform\n" );
+fprintf( stderr, "              linear|low|hi, and -batch_overlay coasts|fine_coasts|usa|FILE; -zoom, -zoom_filter,\n" );
+fprintf( stderr, "              -minmax, -nc and -threads apply too.\n" );
+fprintf( stderr, "	-png_level N, -png_filter none|sub|up|avg|paeth|all: zlib compression level (0-9)\n" );
+fprintf( stderr, "              and row filters for the PNG files that -frames and -batch write.\n" );
+fprintf( stderr, "	-png_threads N: write the -frames PNG files in N threads, in the background.\n" );
+fprintf( stderr, "	-stream FILE: send each whole frame drawn (or made by -batch, instead of the PNG files)\n" );
+fprintf( stderr, "              to FILE, which can be a FIFO, or - for stdout, for a video encoder to read.\n" );
+fprintf( stderr, "              -stream_format y4m|rgb picks YUV4MPEG2 (the default) or raw 8 bit RGB;\n" );
+fprintf( stderr, "              -stream_fps N sets the frame rate in the YUV4MPEG2 header (default 25).\n" );
+fprintf( stderr, "	-overlay_cache DIR: keep the overlays made for each grid in DIR (default\n" );
+fprintf( stderr, "              $HOME/.ncview_overlays), so they come up right away next time; none to not.\n" );
+fprintf( stderr, "              Overlays not used for 60 days are removed from DIR.\n" );
+fprintf( stderr, "	-golden_write DIR, -golden_check DIR: make images of made-up data at every blowup,\n" );
+fprintf( stderr, "              shrink and zoom method, and write them to DIR or compare them with the\n" );
+fprintf( stderr, "              ones there (this is what \"make golden\" and \"make golden_check\" run).\n" );
+fprintf( stderr, "	-threads N: split image processing among N threads (default: one per processor).\n" );
+fprintf( stderr, "	-zoom F: show the image at F times the size of the data, where F need not be an\n" );
+fprintf( stderr, "              integer (ex: -zoom 1.33), or \"-zoom fit\" to just fill the largest window allowed.\n" );
+fprintf( stderr, "	-zoom_filter: how to resample for -zoom: nearest, box, or bilinear.  The default\n" );
+fprintf( stderr, "              follows the Repl/Bi-lin button when enlarging, and -shrink_mode when shrinking.\n" );
 fprintf( stderr, "	-c: 	print the copying policy.\n" );
 fprintf( stderr, "datafiles:\n" );
 fprintf( stderr, "	You can have up to 32 of these.  They must all be in\n" );
@@ -98,6 +98,7 @@
 #define LABEL_CCINFO_2		9
 #define LABEL_BLOWUP_TYPE	10		/* this is also a button */
 #define LABEL_SKIP		12		/* this is also a button */
+#define LABEL_TIMING		14		/* only there with -timing */
 
 #define LABEL_TITLE		LABEL_1
 #define LABEL_SCANVAR_NAME	LABEL_2
@@ -152,6 +153,10 @@
 /* Truncate displayed strings which are longer than this */
 #define MAX_DISPLAYED_STRING_LENGTH 	250
 
+/*****************************************************************************/
+/* Most worker threads we will use when splitting up work (see parallel.c) */
+#define MAX_THREADS	64
+
 /*****************************************************************************/
 /* What dimension button sets we have */
 #define DIMENSION_X	1
@@ -165,6 +170,7 @@
 #define	MOD_2		2
 #define	MOD_3		3
 #define	MOD_4		4
+#define	MOD_5		5
 
 /*****************************************************************************/
 /* Messages which a dialog popup can return */
@@ -206,6 +212,35 @@
  */
 #define SHRINK_METHOD_MEAN	0
 #define SHRINK_METHOD_MODE	1
+#define SHRINK_PYRAMID		2	/* internal: power-of-two mean levels that others are built from */
+
+/*******************************************************************
+ * Ways to resample the data when the zoom factor is not an integer.
+ * ZOOM_FILTER_AUTO picks nearest or bilinear when enlarging (following
+ * blowup_type) and box or nearest when shrinking (following shrink_method).
+ */
+#define ZOOM_FILTER_AUTO	0
+#define ZOOM_FILTER_NEAREST	1
+#define ZOOM_FILTER_BOX		2
+#define ZOOM_FILTER_BILINEAR	3
+
+/*******************************************************************
+ * Row filters for PNG files (-png_filter).  PNG_FILTERS_DEFAULT leaves
+ * it up to libpng; PNG_FILTERS_ALL tries them all on each row.
+ */
+#define PNG_FILTERS_DEFAULT	0
+#define PNG_FILTERS_NONE	1
+#define PNG_FILTERS_SUB		2
+#define PNG_FILTERS_UP		3
+#define PNG_FILTERS_AVG		4
+#define PNG_FILTERS_PAETH	5
+#define PNG_FILTERS_ALL		6
+
+/*******************************************************************
+ * Formats for streaming frames out (-stream_format)
+ */
+#define STREAM_Y4M		1	/* YUV4MPEG2, 4:4:4 */
+#define STREAM_RGB		2	/* Raw 8 bit RGB, no header */
 
 /*********************************************************************
  * Possible states which the data inside the current buffer can be in
@@ -273,6 +308,12 @@ typedef unsigned char ncv_pixel;/* If you change this, make sure to change
 				 * X routines do also.
 				 */
 
+/*****************************************************************************/
+/* A piece of work that can be split up among threads; it must do items
+ * 'first' through 'last-1'.  See par_for() in parallel.c.
+ */
+typedef void (*ParallelFunc)( long first, long last, void *arg );
+
 /*****************************************************************************/
 /* This describes the file which the relevant variable lives in */
 typedef struct {
@@ -316,6 +357,38 @@ typedef struct {
 
 } NetCDFOptions;
 	
+/*****************************************************************************/
+/* An index onto a dimension's values, for going from a value to the nearest
+ * index quickly.  If the values increase or decrease steadily this is a
+ * binary search on the midpoints between them; otherwise it just looks at
+ * all of them.
+ */
+#define COORD_INCREASING	1
+#define COORD_DECREASING	2
+#define COORD_UNORDERED		3
+
+typedef struct {
+	float	*values;	/* The values themselves; NOT a copy */
+	float	*mid;		/* mid[i] is halfway between values[i] and values[i+1] */
+	size_t	n;
+	int	order;		/* COORD_INCREASING, COORD_DECREASING, or COORD_UNORDERED */
+} CoordIndex;
+
+/*****************************************************************************/
+/* An index onto a set of 2-D locations (such as the points of a curvilinear
+ * grid), for finding the one closest to a given location.  The bounding box
+ * of the locations is cut into nbx by nby bins; the locations in bin b are
+ * pts[bin_start[b]] through pts[bin_start[b+1]-1].
+ */
+typedef struct {
+	float	*xvals, *yvals;	/* The locations themselves; NOT copies */
+	size_t	n;
+	long	nbx, nby;
+	double	x0, y0,		/* Lower left corner of bin (0,0) */
+		bin_dx, bin_dy;
+	size_t	*bin_start, *pts;
+} PointIndex;
+
 /*****************************************************************************/
 /* The dimension structure.  This is more for convienence and efficiency
  * than because dimensions are so fundamental; actually, it's the variables
@@ -334,6 +407,7 @@ typedef struct {
 	int	tgran; 		/* time granularity; i.e., frequency of entries (daily, hourly, etc). Must be one of the TGRAN_* defined above */
 	int	global_id;	/* Used internally, goes from 1..total number of dims we know about */
 	int	is_lat, is_lon; /* Just a guess if these are lat/lon. Used to put on coastlines automatically */
+	CoordIndex *coord_index; /* made the first time it's needed; see dim_coord_index() */
 } NCDim;
 
 /*****************************************************************************/
@@ -454,6 +528,18 @@ typedef struct {
 						*/
 } NCVar;
 
+/*****************************************************************************/
+/* A shrunken version of the data in a view, as used when options.blowup
+ * is negative.  Kept so that changing the shrink factor doesn't mean going
+ * back to the full resolution data every time.
+ */
+typedef struct {
+	int	factor;		/* Data is shrunk by this factor... */
+	int	method;		/* ...using this SHRINK_METHOD_ (or SHRINK_PYRAMID) */
+	size_t	nx, ny;		/* Size of the shrunken data */
+	float	*data;
+} ShrinkLevel;
+
 /*****************************************************************************/
 /* Our current view--the view is the 2D field which is being color-contoured.
  */
@@ -463,6 +549,12 @@ typedef struct {
 	void	*data;		/* The actual 2-D data to colorcontour */
 	int	data_status;	/* Either valid, invalid, or edited (changed) */
 	unsigned char *pixels;	/* Scaled, replicated, byte array version of data */
+	size_t	render_x0,	/* If render_nx is not 0, only this region of */
+		render_y0,	/* 'pixels' is filled in by data_to_pixels. Used */
+		render_nx,	/* to render just the visible part of large  */
+		render_ny;	/* blown-up images */
+	ShrinkLevel *shrink_levels;	/* Shrunken versions of 'data' (see contract_data) */
+	int	n_shrink_levels;
 	int	x_axis_id, 	/* which axes the 2-D data lies on.  'scan' */
 		y_axis_id,	/* is the one accessed by the pushbuttons */
 		scan_axis_id;
@@ -473,25 +565,74 @@ typedef struct {
 } View;
 
 /*****************************************************************************
- * Place to store the frames in, if we want in-core displaying.
+ * Place to store the frames in, if we want in-core displaying.  Each frame
+ * is kept compressed, and only up to options.framestore_mb of them are
+ * kept in memory; the least recently used ones are thrown away (or moved
+ * to the spill file, if there is one) to make room.  See framestore.c.
+ *
+ * Frames are kept two ways: as the pixels shown at the current blowup
+ * (FRAMES_DISPLAY), and as color levels at the resolution of the data
+ * (FRAMES_DATA), which don't depend on the blowup.  Changing the blowup
+ * only throws away the first kind.
  */
+#define FRAME_NONE	0	/* Don't have this frame */
+#define FRAME_IN_CORE	1	/* Frame is in memory */
+#define FRAME_SPILLED	2	/* Frame is in the spill file */
+
+#define FRAMES_DISPLAY	0
+#define FRAMES_DATA	1
+#define FRAMES_N_SETS	2
+
+typedef struct {
+	int		where;		/* FRAME_NONE, FRAME_IN_CORE, or FRAME_SPILLED */
+	int		compressed;	/* FALSE if the frame didn't get smaller, and is stored as is */
+	unsigned char	*data;		/* The stored frame, if in core */
+	size_t		nbytes;		/* Length of the stored frame */
+	size_t		spill_offset;	/* Where the stored frame is in the spill file, if spilled */
+	unsigned long	last_used;
+} FrameStoreEntry;
+
+typedef struct {
+	size_t	nx, ny;		/* # of X and Y entries per frame */
+	FrameStoreEntry *entry;	/* One for each frame */
+} FrameSet;
+
 typedef struct {
 	int	valid;		/* Is ANYTHING in the frame store valid? */
 	size_t	nt;		/* # of frames in the store.  Can be > than nt cuz we allocate some extra to handle file growth */
-	size_t	nx, ny;		/* # of X and Y entries per frame */
-	ncv_pixel *frame;	/* Actual store of the frames */
-	int	*frame_valid;	/* Is this particular frame valid? */
+	FrameSet set[FRAMES_N_SETS];	/* Indexed by FRAMES_DISPLAY or FRAMES_DATA */
+	size_t	bytes_used;	/* Memory taken by the frames that are in core */
+	unsigned long clock;	/* For finding the least recently used frame */
 } FrameStore;
 
+/*****************************************************************************/
+/* Stages of making a frame that are timed with -timing; see timing.c */
+#define TIMING_READ		0	/* Reading the data from the file */
+#define TIMING_SCALE		1	/* Applying scale_factor and add_offset */
+#define TIMING_RESAMPLE		2	/* Blowing up, shrinking, or zooming the data */
+#define TIMING_QUANTIZE		3	/* Turning data values into color levels */
+#define TIMING_OVERLAY		4	/* Putting on overlays */
+#define TIMING_STORE		5	/* Putting frames into, and getting them from, the framestore */
+#define TIMING_TRUECOLOR	6	/* Converting pixels for a TrueColor display */
+#define TIMING_PUTIMAGE		7	/* Sending the image to the X server */
+#define TIMING_N_STAGES		8
+
 /*****************************************************************************/
 /* program options */
 
-/* Options for the overlay feature */
+/* Options for the overlay feature.  The overlay is a bit mask with one
+ * bit per point of the displayed 2-D data field, in the same order as the
+ * data; a set bit means that point is drawn in the missing value color.
+ */
 typedef struct {
 	int	doit;
-	int	*overlay;
+	unsigned char *overlay;
 } OverlayOptions;
 
+#define OVERLAY_MASK_BYTES(n)		(((n)+7)/8)
+#define OVERLAY_MASK_SET(mask,i)	((mask)[(i)>>3] |= (unsigned char)(1 << ((i)&7)))
+#define OVERLAY_MASK_TEST(mask,i)	(((mask)[(i)>>3] >> ((i)&7)) & 1)
+
 typedef struct {
 	int	invert_physical,
 		invert_colors,
@@ -535,10 +676,43 @@ typedef struct {
 
 	int	blowup_type;	/* can be BLOWUP_REPLICATE or BLOWUP_BILINEAR */
 
+	float	zoom;		/* If > 0, the image is this many times the size of the data, and 'blowup' is ignored */
+	int	zoom_fit;	/* If TRUE, the zoom is set so the image just fits the largest window we allow */
+	int	zoom_filter;	/* One of the ZOOM_FILTER_ values */
+
 	int	autoscale;	/* If TRUE, then tries to automatically scale colors for EACH frame.  Much slower!! */
 
 	int	save_frames;	/* If true, try to save frames in core for faster display */
+	int	pixmap_cache_mb; /* If > 0, keep up to this many MB of rendered frames as Pixmaps on the X server */
+	int	framestore_mb;	/* Most MB of memory the (compressed) saved frames can take */
+	int	framestore_spill_mb; /* If > 0, frames that don't fit in memory go to a temp file this big */
+	int	prerender;	/* If true, fill the framestore in the background while idle */
+	int	n_threads;	/* Number of threads to split image processing among; 0 means one per processor */
 	float	frame_delay;	/* Normalied to be between 0.0 and 1.0 */
+	int	drop_frames;	/* If true, skip frames when drawing can't keep up with the animation speed */
+	int	timing;		/* If true, time the stages of making each frame and show the results */
+	int	bench;		/* If true, time making frames without a display, then exit (see bench.c) */
+	long	bench_frames;	/* How many frames to make with -bench; 0 means all of them */
+	char	*bench_var,	/* Variable to use with -bench; NULL means the first 2-D one */
+		*bench_overlay;	/* Overlay to use with -bench, or NULL */
+	int	bench_blowup;	/* Blowup to use with -bench */
+	int	batch;		/* If true, write frames to PNG files without a display, then exit (see batch.c) */
+	char	*batch_dir,	/* Directory to put the -batch PNG files in */
+		*batch_var,	/* Variable to do with -batch; NULL means all the 2-D ones */
+		*batch_cmap,	/* Built-in colormap to use with -batch */
+		*batch_overlay;	/* Overlay to use with -batch, or NULL */
+	long	batch_first,	/* First and last frame to do with -batch; */
+		batch_last;	/* batch_last < 0 means to the end */
+	int	batch_blowup;	/* Blowup to use with -batch */
+	int	batch_have_range; /* If true, use batch_min and batch_max as the range of every variable */
+	float	batch_min, batch_max;
+	int	png_level;	/* zlib compression level for PNG files, 0-9; -1 means libpng's default */
+	int	png_filter;	/* One of the PNG_FILTERS_ values */
+	int	png_threads;	/* Threads to write -frames PNG files in; 0 means pick for me */
+	char	*stream_file;	/* If not NULL, stream whole frames to this file or FIFO ("-" for stdout) */
+	int	stream_format;	/* One of the STREAM_ values */
+	int	stream_fps;	/* Frame rate to put in the YUV4MPEG2 header */
+	char	*overlay_cache_dir;	/* Where overlay masks are kept between runs; NULL for the default, "none" for nowhere */
 
 	int	enable_group_sel;	/* TRUE if we have some vars in groups, so interface must incl. grp selection */
 
@@ -36,6 +36,7 @@
 #include <limits.h>
 #include <math.h>
 #include <time.h>
+#include <sys/time.h>
 #include <unistd.h>
 #include <ctype.h>
 
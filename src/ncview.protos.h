@@ -31,6 +31,7 @@ void 	initialize_file_interface   ( Stringlist *input_files );
 void	initialize_display_interface( void );
 void	initialize_colormaps	    ( void );
 void	init_cmap_from_file	    ( char *dir_name, char *file_name );
+int	builtin_colormap_rgb	    ( char *name, unsigned char r[256], unsigned char g[256], unsigned char b[256] );
 void	process_user_input          ( void );
 void	quit_app		    ( void );
 void	create_default_colormap     ( void );
@@ -67,6 +68,8 @@ char 	*fi_dim_longname ( int fileid, char *dim_name );
 nc_type fi_dim_value     ( NCVar *v, int dim_id, size_t place, double *ret_val_double, char *ret_val_char, 
 				int *return_has_bounds, double *return_bounds_min, double *return_bounds_max,
 				size_t *complete_ndim_virt_place );
+int	fi_dim_values_2d ( NCVar *var, int dim_id, int x_axis_id, int y_axis_id, size_t *complete_ndim_virt_place,
+				float *dest );
 char 	*fi_dim_id_to_name( int fileid, char *var_name, int dim_id );
 int 	fi_dim_name_to_id( int fileid, char *var_name, char *dim_name );
 size_t 	fi_n_dim_entries ( int fileid, char *dim_name );
@@ -87,6 +90,7 @@ int	netcdf_fi_n_dims	( int fileid, char *var_name );
 size_t	*netcdf_fi_var_size	( int fileid, char *var_name );
 void 	netcdf_fi_get_data	( int fileid, char *var_name, size_t *start_pos, 
 						size_t *count, float *data, NetCDFOptions *aux_data );
+void	netcdf_fix_data		( float *data, size_t tot_size, NetCDFOptions *aux_data );
 void	netcdf_fi_close		( int fileid );
 int 	netcdf_n_dims 		( int cdfid, char *varname );
 char	*netcdf_varindex_to_name( int cdfid, int index );
@@ -128,9 +132,14 @@ void	clip_f		   ( float *val, float min, float max );
 void	clip_i		   ( int   *val, int   min, int   max );
 void 	fill_dim_structs   ( NCVar *v );
 void 	expand_data	   ( float *big_data, View *v, size_t array_size );
+void 	contract_data	   ( float *small_data, View *v, float fill_value );
+void	invalidate_shrink_levels( View *v );
+void	data_to_levels	   ( View *v, ncv_pixel *levels );
+void	levels_to_pixels   ( View *v, ncv_pixel *levels, size_t px0, size_t py0, size_t pnx, size_t pny );
+int	levels_match_data  ( void );
 void 	check_ranges       ( NCVar *var );
 char 	*limit_string	   ( char *s );
-int 	*gen_overlay       ( View *v, char *overlay_fname );
+unsigned char *gen_overlay ( View *v, char *overlay_fname );
 void 	fmt_time	   ( char *temp_string, size_t temp_string_len, double new_dimval, NCDim *dim, int include_granularity );
 int	n_vars_in_list	   ( NCVar *v );
 void 	set_blowup_type	   ( int new_type );
@@ -144,9 +153,18 @@ int     is_scannable        ( NCVar *v, int i );
 void 	sl_cat		    ( Stringlist **dest, Stringlist **src );
 void 	get_min_max_onestep( NCVar *var, size_t n_other, size_t tstep, float *data, 
 					float *min, float *max, int verbose );
+void	min_max_of	    ( float *data, size_t n, float fill_v, float *min, float *max );
 void 	cache_scalar_coord_info( NCVar *vars );
 int 	count_nslashes	    ( char *s );
 Stringlist *get_group_list  ( NCVar *vars );
+double	ms_since	    ( struct timeval *t0 );
+CoordIndex *coord_index_new  ( float *values, size_t n );
+void	coord_index_free    ( CoordIndex *ci );
+long	coord_index_lookup  ( CoordIndex *ci, float value );
+CoordIndex *dim_coord_index ( NCDim *d, size_t n );
+PointIndex *point_index_new  ( float *xvals, float *yvals, size_t n );
+void	point_index_free    ( PointIndex *pi );
+long	point_index_nearest ( PointIndex *pi, float x, float y );
 
 /******************************************************************************
  * in interface.c 
@@ -164,6 +182,12 @@ void 	in_button_pressed	( int button_id, int modifier );
 void	in_process_user_input	( void );
 void	in_draw_2d_field 	( unsigned char *data, size_t width, size_t height,
 	size_t timestep );
+void	in_draw_2d_field_region	( unsigned char *data, size_t width, size_t height, size_t timestep,
+					size_t x0, size_t y0, size_t nx, size_t ny );
+int	in_get_visible_region	( size_t width, size_t height, size_t *x0, size_t *y0, size_t *nx, size_t *ny );
+void	in_get_max_2d_size	( size_t *width, size_t *height );
+int	in_draw_cached_2d_field	( size_t width, size_t height, size_t timestep );
+void	in_invalidate_frame_cache( void );
 void	in_create_colormap	( char *name, ncv_pixel r[256], ncv_pixel g[256], ncv_pixel b[256] );
 char	*in_install_next_colormap( int do_widgets_flag );
 int	in_set_2d_size   	( size_t width, size_t height );
@@ -191,6 +215,8 @@ void	in_popdown_2d_window	( void );
 void 	in_timer_clear		( void );
 int	in_report_auto_overlay  ( void );
 void 	in_timer_set            ( XtTimerCallbackProc procedure, XtPointer arg, unsigned long delay_millisec );
+void 	in_work_proc_set        ( XtWorkProc procedure, XtPointer arg );
+void 	in_work_proc_clear      ( void );
 char    *in_install_prev_colormap( int do_widgets );
 void 	in_data_edit_dump	( void );
 
@@ -198,6 +224,7 @@ void 	in_data_edit_dump	( void );
  * in do_buttons.c
  */
 int 	which_button_pressed( void );
+char	*play_status	  ( void );
 void 	do_range 	  ( int modifier );
 void 	do_quit		  ( int modifier );
 void 	do_data_edit	  ( int modifier );
@@ -231,6 +258,12 @@ void 	x_set_label		( int id, char *string );
 void	x_set_speed_proc	( Widget scrollbar, XtPointer client_data, XtPointer position );
 void	x_draw_2d_field		( unsigned char *data, size_t width, size_t height,
 	size_t timestep );
+void	x_draw_2d_field_region	( unsigned char *data, size_t width, size_t height, size_t timestep,
+					size_t x0, size_t y0, size_t nx, size_t ny );
+int	x_get_visible_region	( size_t width, size_t height, size_t *x0, size_t *y0, size_t *nx, size_t *ny );
+void	x_get_max_2d_size	( size_t *width, size_t *height );
+int	x_draw_cached_2d_field	( size_t width, size_t height, size_t timestep );
+void	x_invalidate_pixmap_cache( void );
 void	x_set_2d_size 		( size_t width, size_t height );
 void    x_indicate_active_var   ( char *var_name );
 void    *x_create_default_colormap( void );
@@ -263,6 +296,8 @@ void 	x_draw_colorbar		( void );
 void 	x_create_colorbar       ( float user_min, float user_max, int transform );
 void    x_timer_clear           ( void );
 void    x_timer_set             ( XtTimerCallbackProc procedure, XtPointer client_arg, unsigned long delay_millisec );
+void    x_work_proc_set         ( XtWorkProc procedure, XtPointer client_arg );
+void    x_work_proc_clear       ( void );
 void    x_indicate_active_var   ( char *var_name );
 int     x_dialog                ( char *message, char *ret_string, int want_cancel_button );
 
@@ -286,7 +321,14 @@ void 	view_change_cur_dim  ( char *dim_name, int modifier );
 void	view_forward         ( void );
 void	view_backward        ( void );
 void	view_change_blowup   ( int delta, int redraw_flag, int view_var_is_valid );
+void	view_set_zoom        ( float zoom, int fit, int redraw_flag );
 void	init_saveframes	     ( void );
+void	resize_saveframes    ( void );
+void	view_update_scan_label( void );
+void	view_flush_scan_labels( void );
+int	view_init_headless( NCVar *var );
+int	view_render_headless( size_t frameno );
+int	view_get_whole_frame( void );
 void 	redraw_dimension_info( void );
 void 	redraw_ccontour      ( void );
 void	view_check_new_data  ( int unused );
@@ -315,11 +357,13 @@ void 	view_information     ( void );
  * in overlay.c
  */
 void 	do_overlay		( int n, char *custom_filename, int suppress_screen_changes );
+int	overlay_by_name		( char *name );
 char 	**overlay_names		( void );
 int 	overlay_current		( void );
 int 	overlay_n_overlays	( void );
 void 	determine_overlay_base_dir( char *overlay_base_dir, int n );
 int 	overlay_custom_n	( void );
+void	overlay_pixels		( View *v, size_t px0, size_t py0, size_t pnx, size_t pny );
 
 /******************************************************************************
  * in set_options.c
@@ -412,6 +456,7 @@ int 	x_seen_colormap_name( char *name );
 void 	x_colormap_info( Cmaplist *cmlist, int idx, char **name, int *enabled, XColor **color_list );
 int 	x_n_colormaps( Cmaplist *cmlist );
 void 	x_create_colormap( char *name, unsigned char r[256], unsigned char g[256], unsigned char b[256] );
+void 	set_colormap_colors( XColor *color_list, unsigned char r[256], unsigned char g[256], unsigned char b[256] );
 char 	*x_change_colormap( int delta, int do_widgets_flag );
 void 	x_check_legal_colormap_loaded();
 void 	delete_cmaplist( Cmaplist *cml );
@@ -424,6 +469,85 @@ int 	write_state_to_file( Stringlist *state_to_save );
 int 	read_state_from_file( Stringlist **state );
 Stringlist *get_persistent_state();
 
+/******************************************************************************
+ * in parallel.c
+ */
+int	par_n_threads( void );
+void	par_for( long n, long min_per_thread, ParallelFunc func, void *arg );
+
+/******************************************************************************
+ * in framestore.c
+ */
+void	framestore_init( size_t nx, size_t ny, size_t nt );
+void	framestore_resize( size_t nx, size_t ny );
+void	framestore_grow( size_t nt );
+void	framestore_invalidate( void );
+int	framestore_has( int which, size_t frameno );
+int	framestore_get( int which, size_t frameno, size_t nx, size_t ny, ncv_pixel *pixels );
+size_t	framestore_put( int which, size_t frameno, size_t nx, size_t ny, ncv_pixel *pixels );
+size_t	framestore_bytes_free( void );
+
+/******************************************************************************
+ * in prerender.c
+ */
+void	prerender_restart( void );
+void	prerender_cancel( void );
+char	*prerender_status( void );
+
+/******************************************************************************
+ * in timing.c
+ */
+void	timing_frame_start( void );
+void	timing_frame_end( void );
+void	timing_start( int stage );
+void	timing_stop( int stage );
+void	timing_last_frame( float *ms );
+char	*timing_stage_name_of( int stage );
+void	timing_summarize( float *ms, long n, double *sum, float *avg, float *p50, float *p95, float *max );
+
+/******************************************************************************
+ * in trace.c
+ */
+void	trace_open( char *fname );
+void	trace_begin( char *name, char *category, char *detail );
+void	trace_end( char *name, char *category );
+
+/******************************************************************************
+ * in bench.c
+ */
+void	bench_run( Stringlist *input_files );
+
+/******************************************************************************
+ * in golden.c
+ */
+void	golden_run( int argc, char **argv );
+
+/******************************************************************************
+ * in batch.c
+ */
+void	batch_run( void );
+
+/******************************************************************************
+ * in png_out.c
+ */
+int	write_png_frame( char *filename, unsigned char *data, size_t width, size_t height,
+		XColor *color_list, int n_colors );
+int	png_queue_frame( char *filename, unsigned char *data, size_t width, size_t height,
+		XColor *color_list, int n_colors );
+void	png_queue_finish( void );
+
+/******************************************************************************
+ * in stream_out.c
+ */
+void	stream_open( void );
+int	stream_frame( unsigned char *data, size_t width, size_t height, XColor *color_list, int n_colors );
+
+/******************************************************************************
+ * in expand.c
+ */
+void	expand_block( float *big_data, float *little, size_t nxl, size_t nyl, float fill_val,
+		int blowup, int blowup_type, size_t array_size );
+
 /******************************************************************************
  * in file interface/util.c
  */
@@ -44,14 +44,86 @@ char *my_overlay_names[] = { "None",
 
 extern View  	*view;
 extern Options  options;
+extern ncv_pixel *pixel_transform;
+
+/* What the threads putting the overlay onto the rows of an image need to
+ * know.  Pixel column i of the region being drawn covers data columns
+ * ix0[i] through ix1[i]-1.
+ */
+typedef struct {
+	View	*v;
+	unsigned char *mask;
+	size_t	nx, ny, new_nx, new_ny, px0, py0;
+	long	pnx, *ix0, *ix1;
+} OverlayPixelInfo;
 
 static int	my_current_overlay;
 
-static int 	gen_xform( float value, int n, float *dimvals );
-static int 	*gen_overlay_internal( View *v, float *data, long n );
+/* Masks that have been made are kept, both here and (unless -overlay_cache
+ * none was given) in files, so that putting the same overlay on the same
+ * grid again doesn't take any work.  They are looked up by a hash of the
+ * grid's X and Y values and the overlay's points.  Change
+ * OVERLAY_CACHE_VERSION whenever the same grid and points would give a
+ * different mask, so that the saved ones aren't used.
+ */
+#define OVERLAY_CACHE_VERSION	1
+#define OVERLAY_MEM_CACHE_N	8
+#define OVERLAY_CACHE_ID	"NCVIEW-OVERLAY-MASK"
+
+/* Mask files not used for this many days are removed from the cache
+ * directory whenever a new one is written, so it doesn't grow for ever.
+ */
+#define OVERLAY_CACHE_MAX_DAYS	60
+
+typedef struct {
+	unsigned long long key;
+	size_t	n;			/* Points in the grid */
+	unsigned char *mask;
+} OverlayCacheEntry;
+
+static OverlayCacheEntry overlay_mem_cache[OVERLAY_MEM_CACHE_N];
+static int	overlay_mem_cache_next = 0;	/* Entry to replace next */
+
+/* Hashing a mapped grid means reading its full 2-D X and Y values, so
+ * the hash is kept for each variable and pair of axes it has been worked
+ * out for.  Where the variable is in its other dimensions is kept too,
+ * since the X and Y values can change with them.
+ */
+#define OVERLAY_GRID_HASH_N	8
+
+typedef struct {
+	NCVar	*var;			/* NULL if the entry is unused */
+	int	x_axis_id, y_axis_id;
+	size_t	*place;
+	unsigned long long hash;
+} OverlayGridHash;
+
+static OverlayGridHash overlay_grid_hash[OVERLAY_GRID_HASH_N];
+static int	overlay_grid_hash_next = 0;	/* Entry to replace next */
+
+/* The index onto the last 2-D mapped grid overlays were put on, and the
+ * grid's X and Y values, which it points into
+ */
+static PointIndex *mapped_index = NULL;
+static float	*mapped_x = NULL, *mapped_y = NULL;
+static size_t	mapped_n = 0L;
+
+static unsigned char *gen_overlay_internal( View *v, float *data, long n );
+static void	gen_overlay_internal_mapped( View *v, float *data, long nvals, unsigned char *overlay );
+static unsigned char *new_overlay_mask( size_t n );
+static void	overlay_source_range( size_t pix, size_t n, size_t new_n, long *i0, long *i1 );
+static void	overlay_pixel_rows( long first, long last, void *arg );
 static void 	do_overlay_inner( View *v, float *data, long nvals, int suppress_screen_changes );
-static void 	overlay_find_closest_pt( size_t point_number, float locx, float locy, float *xvals, float *yvals, size_t nx, size_t ny,
-			size_t *idxx, size_t *idxy );
+static PointIndex *mapped_point_index( float *dimval_x_2d, float *dimval_y_2d, size_t n );
+static unsigned char *cached_overlay( View *v, float *data, long nvals, char *overlay_fname );
+static int	overlay_key( View *v, float *data, long nvals, char *overlay_fname, unsigned long long *key );
+static unsigned long long hash_bytes( unsigned long long h, void *p, size_t n );
+static int	mapped_grid_hash( View *v, unsigned long long h, unsigned long long *grid_h );
+static int	same_grid_place( View *v, size_t *place );
+static unsigned char *overlay_cache_get( unsigned long long key, size_t n );
+static void	overlay_cache_put( unsigned long long key, size_t n, unsigned char *mask );
+static int	overlay_cache_fname( unsigned long long key, char *fname, size_t len );
+static void	overlay_cache_prune( char *dir );
 
 /*====================================================================================
  * This routine is only called when the state of the overlay is being changed
@@ -64,16 +136,19 @@ do_overlay( int n, char *custom_filename, int suppress_screen_changes )
 		return;
 		}
 
-	/* Free space for previous overlay */
-	if( options.overlay->doit && (options.overlay->overlay != NULL ))
+	/* Free space for previous overlay.  The overlay is only put on when
+	 * the data is turned into pixels, so the view's data (and anything
+	 * made from it) is still good; only the saved frames need redoing.
+	 */
+	if( options.overlay->overlay != NULL )
 		free( options.overlay->overlay );
+	options.overlay->overlay = NULL;
 
 	switch(n) {
 		
 		case OVERLAY_NONE:
 			options.overlay->doit = FALSE;
 			if( ! suppress_screen_changes ) {
-				view->data_status = VDS_INVALID;
 				invalidate_all_saveframes();
 				change_view( 0, FRAMES );
 				}
@@ -99,7 +174,9 @@ do_overlay( int n, char *custom_filename, int suppress_screen_changes )
 				in_error( "Specified custom overlay filename is not a valid filename!\n" );
 				return;
 				}
-			options.overlay->overlay = gen_overlay( view, custom_filename ); 
+			trace_begin( "gen_overlay", "compute", custom_filename );
+			options.overlay->overlay = cached_overlay( view, NULL, 0L, custom_filename );
+			trace_end( "gen_overlay", "compute" );
 			if( options.overlay->overlay != NULL ) {
 				options.overlay->doit = TRUE;
 				if( ! suppress_screen_changes ) {
@@ -124,7 +201,9 @@ do_overlay( int n, char *custom_filename, int suppress_screen_changes )
 	void
 do_overlay_inner( View *v, float *data, long nvals, int suppress_screen_changes )
 {
-	options.overlay->overlay = gen_overlay_internal( v, data, nvals );
+	trace_begin( "gen_overlay", "compute", NULL );
+	options.overlay->overlay = cached_overlay( v, data, nvals, NULL );
+	trace_end( "gen_overlay", "compute" );
 	if( options.overlay->overlay != NULL ) {
 		options.overlay->doit = TRUE;
 		if( ! suppress_screen_changes ) {
@@ -134,6 +213,406 @@ do_overlay_inner( View *v, float *data, long nvals, int suppress_screen_changes
 		}
 }
 
+/*=========================================================================================
+ * Returns a newly allocated overlay mask for view v, either from the cache or
+ * (if it's not there) made and then put in the cache.  The overlay is the
+ * nvals/2 points in 'data' if overlay_fname is NULL, otherwise the overlay
+ * file of that name.  Returns NULL if the mask couldn't be made.
+ */
+	static unsigned char *
+cached_overlay( View *v, float *data, long nvals, char *overlay_fname )
+{
+	unsigned long long key;
+	unsigned char	*mask;
+	size_t		n;
+	int		have_key;
+
+	n = *(v->variable->size + v->x_axis_id) * *(v->variable->size + v->y_axis_id);
+
+	have_key = (overlay_key( v, data, nvals, overlay_fname, &key ) == 0);
+	if( have_key ) {
+		mask = overlay_cache_get( key, n );
+		if( mask != NULL )
+			return( mask );
+		}
+
+	if( overlay_fname == NULL )
+		mask = gen_overlay_internal( v, data, nvals );
+	else
+		mask = gen_overlay( v, overlay_fname );
+
+	if( (mask != NULL) && have_key )
+		overlay_cache_put( key, n, mask );
+
+	return( mask );
+}
+
+/*=========================================================================================
+ * The key that the overlay mask is looked up by: a hash of the grid (its size
+ * and X and Y values) and the overlay's points (or the contents of the overlay
+ * file).  Returns -1 if there isn't a key, in which case the mask isn't cached.
+ */
+	static int
+overlay_key( View *v, float *data, long nvals, char *overlay_fname, unsigned long long *key )
+{
+	unsigned long long h;
+	size_t	nx, ny, nread;
+	int	mapped, version, x_axis_id, y_axis_id;
+	FILE	*f;
+	char	buf[4096];
+
+	x_axis_id = v->x_axis_id;
+	y_axis_id = v->y_axis_id;
+	nx = *(v->variable->size + x_axis_id);
+	ny = *(v->variable->size + y_axis_id);
+	mapped = (v->variable->dim_map_info[ x_axis_id ] != NULL) ||
+		 (v->variable->dim_map_info[ y_axis_id ] != NULL);
+	version = OVERLAY_CACHE_VERSION;
+
+	h = hash_bytes( 14695981039346656037ULL, &version, sizeof(int) );
+	h = hash_bytes( h, &nx,     sizeof(size_t) );
+	h = hash_bytes( h, &ny,     sizeof(size_t) );
+	h = hash_bytes( h, &mapped, sizeof(int) );
+
+	/* The grid */
+	if( mapped ) {
+		if( mapped_grid_hash( v, h, &h ) != 0 )
+			return( -1 );
+		}
+	else
+		{
+		if( ((*(v->variable->dim + x_axis_id))->values == NULL) ||
+		    ((*(v->variable->dim + y_axis_id))->values == NULL) )
+			return( -1 );
+		h = hash_bytes( h, (*(v->variable->dim + x_axis_id))->values, nx*sizeof(float) );
+		h = hash_bytes( h, (*(v->variable->dim + y_axis_id))->values, ny*sizeof(float) );
+		}
+
+	/* The overlay */
+	if( overlay_fname == NULL ) {
+		h = hash_bytes( h, &nvals, sizeof(long) );
+		h = hash_bytes( h, data, nvals*sizeof(float) );
+		}
+	else
+		{
+		if( (f = fopen( overlay_fname, "r" )) == NULL )
+			return( -1 );
+		while( (nread = fread( buf, 1, 4096, f )) > 0 )
+			h = hash_bytes( h, buf, nread );
+		fclose( f );
+		}
+
+	*key = h;
+	return( 0 );
+}
+
+/*=========================================================================================
+ * Adds the 2-D X and Y values of the mapped grid that v is showing to hash h,
+ * putting the result in grid_h.  Since h only depends on the grid's size
+ * before this, the result is remembered for the variable and axes (and
+ * place in the other dimensions) and the values are only read the first
+ * time.  Returns -1 if the values can't be got.
+ */
+	static int
+mapped_grid_hash( View *v, unsigned long long h, unsigned long long *grid_h )
+{
+	OverlayGridHash	*e;
+	size_t	nx, ny, *place;
+	float	*vals;
+	int	i, x_axis_id, y_axis_id;
+
+	x_axis_id = v->x_axis_id;
+	y_axis_id = v->y_axis_id;
+
+	for( i=0; i<OVERLAY_GRID_HASH_N; i++ ) {
+		e = overlay_grid_hash + i;
+		if( (e->var == v->variable) && (e->x_axis_id == x_axis_id) &&
+		    (e->y_axis_id == y_axis_id) && same_grid_place( v, e->place ) ) {
+			*grid_h = e->hash;
+			return( 0 );
+			}
+		}
+
+	nx = *(v->variable->size + x_axis_id);
+	ny = *(v->variable->size + y_axis_id);
+	vals = (float *)malloc( nx*ny*sizeof(float) );
+	if( vals == NULL )
+		return( -1 );
+	if( fi_dim_values_2d( v->variable, x_axis_id, x_axis_id, y_axis_id, v->var_place, vals ) != 0 ) {
+		free( vals );
+		return( -1 );
+		}
+	h = hash_bytes( h, vals, nx*ny*sizeof(float) );
+	if( fi_dim_values_2d( v->variable, y_axis_id, x_axis_id, y_axis_id, v->var_place, vals ) != 0 ) {
+		free( vals );
+		return( -1 );
+		}
+	h = hash_bytes( h, vals, nx*ny*sizeof(float) );
+	free( vals );
+	*grid_h = h;
+
+	place = (size_t *)malloc( v->variable->n_dims*sizeof(size_t) );
+	if( place == NULL )
+		return( 0 );
+	memcpy( place, v->var_place, v->variable->n_dims*sizeof(size_t) );
+
+	e = overlay_grid_hash + overlay_grid_hash_next;
+	overlay_grid_hash_next = (overlay_grid_hash_next + 1) % OVERLAY_GRID_HASH_N;
+	if( e->place != NULL )
+		free( e->place );
+	e->var       = v->variable;
+	e->x_axis_id = x_axis_id;
+	e->y_axis_id = y_axis_id;
+	e->place     = place;
+	e->hash      = h;
+
+	return( 0 );
+}
+
+/*=========================================================================================
+ * Returns TRUE if v is at the given place in all the dimensions of its
+ * variable except the X and Y axes.
+ */
+	static int
+same_grid_place( View *v, size_t *place )
+{
+	int	i;
+
+	for( i=0; i<v->variable->n_dims; i++ )
+		if( (i != v->x_axis_id) && (i != v->y_axis_id) &&
+		    (place[i] != v->var_place[i]) )
+			return( FALSE );
+
+	return( TRUE );
+}
+
+/*=========================================================================================
+ * Add n bytes starting at p to hash h (64 bit FNV-1a).
+ */
+	static unsigned long long
+hash_bytes( unsigned long long h, void *p, size_t n )
+{
+	unsigned char	*b;
+	size_t		i;
+
+	b = (unsigned char *)p;
+	for( i=0; i<n; i++ ) {
+		h ^= b[i];
+		h *= 1099511628211ULL;
+		}
+
+	return( h );
+}
+
+/*=========================================================================================
+ * Returns a newly allocated copy of the cached mask with the given key, for a
+ * grid of n points, or NULL if there isn't one.  Masks found only in the
+ * cache directory are put in the in-memory cache too.
+ */
+	static unsigned char *
+overlay_cache_get( unsigned long long key, size_t n )
+{
+	unsigned char	*mask;
+	char		fname[2048], line[128], expect[128];
+	size_t		nbytes;
+	FILE		*f;
+	int		i;
+
+	nbytes = OVERLAY_MASK_BYTES(n);
+	for( i=0; i<OVERLAY_MEM_CACHE_N; i++ )
+		if( (overlay_mem_cache[i].mask != NULL) && (overlay_mem_cache[i].key == key) &&
+		    (overlay_mem_cache[i].n == n) ) {
+			mask = (unsigned char *)malloc( nbytes );
+			if( mask == NULL )
+				return( NULL );
+			memcpy( mask, overlay_mem_cache[i].mask, nbytes );
+			if( options.debug )
+				fprintf( stderr, "overlay_cache_get: found mask %016llx in memory\n", key );
+			return( mask );
+			}
+
+	if( overlay_cache_fname( key, fname, 2048 ) != 0 )
+		return( NULL );
+	if( (f = fopen( fname, "rb" )) == NULL )
+		return( NULL );
+
+	/* The first line has to match what overlay_cache_put writes */
+	snprintf( expect, 128, "%s %d %016llx %ld\n", OVERLAY_CACHE_ID, OVERLAY_CACHE_VERSION, key, (long)n );
+	if( (fgets( line, 128, f ) == NULL) || (strcmp( line, expect ) != 0) ) {
+		fclose( f );
+		return( NULL );
+		}
+	mask = (unsigned char *)malloc( nbytes );
+	if( mask == NULL ) {
+		fclose( f );
+		return( NULL );
+		}
+	if( fread( mask, 1, nbytes, f ) != nbytes ) {
+		free( mask );
+		fclose( f );
+		return( NULL );
+		}
+	fclose( f );
+
+	/* So that overlay_cache_prune sees it was used */
+	utimes( fname, NULL );
+
+	if( options.debug )
+		fprintf( stderr, "overlay_cache_get: read mask %016llx from %s\n", key, fname );
+	overlay_cache_put( key, n, mask );
+
+	return( mask );
+}
+
+/*=========================================================================================
+ * Put a copy of the mask with the given key into the in-memory cache, and
+ * into the cache directory if it isn't there already.  Not being able to
+ * cache the mask isn't an error; it just gets made again next time.
+ */
+	static void
+overlay_cache_put( unsigned long long key, size_t n, unsigned char *mask )
+{
+	OverlayCacheEntry *e;
+	char		fname[2048], tmp_fname[2048], *slash;
+	size_t		nbytes;
+	FILE		*f;
+	int		fd, ok;
+	struct stat	sb;
+
+	nbytes = OVERLAY_MASK_BYTES(n);
+
+	e = overlay_mem_cache + overlay_mem_cache_next;
+	overlay_mem_cache_next = (overlay_mem_cache_next + 1) % OVERLAY_MEM_CACHE_N;
+	if( e->mask != NULL )
+		free( e->mask );
+	e->mask = (unsigned char *)malloc( nbytes );
+	if( e->mask != NULL ) {
+		memcpy( e->mask, mask, nbytes );
+		e->key = key;
+		e->n   = n;
+		}
+
+	if( overlay_cache_fname( key, fname, 2048 ) != 0 )
+		return;
+	if( stat( fname, &sb ) == 0 )
+		return;
+
+	/* Write to a temporary file and rename it, so that another ncview
+	 * never sees half a file
+	 */
+	strcpy( tmp_fname, fname );
+	slash = strrchr( tmp_fname, '/' );
+	*slash = '\0';
+	mkdir( tmp_fname, 0755 );
+	*slash = '/';
+	strcat( tmp_fname, ".XXXXXX" );
+	if( (fd = mkstemp( tmp_fname )) == -1 ) {
+		if( options.debug )
+			fprintf( stderr, "overlay_cache_put: can't make %s\n", tmp_fname );
+		return;
+		}
+	if( (f = fdopen( fd, "wb" )) == NULL ) {
+		close( fd );
+		unlink( tmp_fname );
+		return;
+		}
+	fprintf( f, "%s %d %016llx %ld\n", OVERLAY_CACHE_ID, OVERLAY_CACHE_VERSION, key, (long)n );
+	ok = (fwrite( mask, 1, nbytes, f ) == nbytes);
+	ok = (fclose( f ) == 0) && ok;
+	if( (! ok) || (rename( tmp_fname, fname ) != 0) ) {
+		unlink( tmp_fname );
+		return;
+		}
+	if( options.debug )
+		fprintf( stderr, "overlay_cache_put: wrote mask %016llx to %s\n", key, fname );
+
+	*slash = '\0';
+	overlay_cache_prune( tmp_fname );
+}
+
+/*=========================================================================================
+ * Remove the mask files in directory dir that haven't been used in the last
+ * OVERLAY_CACHE_MAX_DAYS days.  Reading a mask file updates its modification
+ * time, so it is the time the mask was last used.
+ */
+	static void
+overlay_cache_prune( char *dir )
+{
+	DIR		*d;
+	struct dirent	*de;
+	struct stat	sb;
+	char		fname[2048];
+	size_t		len;
+	time_t		oldest;
+
+	if( (d = opendir( dir )) == NULL )
+		return;
+
+	oldest = time( NULL ) - (time_t)OVERLAY_CACHE_MAX_DAYS*24*3600;
+	while( (de = readdir( d )) != NULL ) {
+		len = strlen( de->d_name );
+		if( (len < 5) || (strcmp( de->d_name + len - 5, ".mask" ) != 0) )
+			continue;
+		snprintf( fname, 2048, "%s/%s", dir, de->d_name );
+		fname[2047] = '\0';
+		if( (stat( fname, &sb ) == 0) && (sb.st_mtime < oldest) ) {
+			if( options.debug )
+				fprintf( stderr, "overlay_cache_prune: removing unused mask %s\n", fname );
+			unlink( fname );
+			}
+		}
+	closedir( d );
+}
+
+/*=========================================================================================
+ * The name of the file that the mask with the given key is kept in.  They go
+ * in options.overlay_cache_dir if that was given, otherwise in
+ * $HOME/.ncview_overlays.  Returns -1 if masks aren't to be kept in files.
+ */
+	static int
+overlay_cache_fname( unsigned long long key, char *fname, size_t len )
+{
+	char	*dir;
+
+	if( options.overlay_cache_dir != NULL ) {
+		if( strcmp( options.overlay_cache_dir, "none" ) == 0 )
+			return( -1 );
+		snprintf( fname, len, "%s/%016llx.mask", options.overlay_cache_dir, key );
+		}
+	else
+		{
+		dir = getenv( "HOME" );
+		if( dir == NULL )
+			return( -1 );
+		snprintf( fname, len, "%s/.ncview_overlays/%016llx.mask", dir, key );
+		}
+	fname[len-1] = '\0';
+
+	return( 0 );
+}
+
+/*=========================================================================================
+ * Put on an overlay without touching the display, for the -bench and -batch
+ * modes.  'name' can be "coasts", "fine_coasts", "usa", or the name of an
+ * overlay file.  Returns -1 if the overlay couldn't be made.
+ */
+	int
+overlay_by_name( char *name )
+{
+	if( strcmp( name, "coasts" ) == 0 )
+		do_overlay( OVERLAY_P8DEG, NULL, TRUE );
+	else if( strcmp( name, "fine_coasts" ) == 0 )
+		do_overlay( OVERLAY_P08DEG, NULL, TRUE );
+	else if( strcmp( name, "usa" ) == 0 )
+		do_overlay( OVERLAY_USA, NULL, TRUE );
+	else
+		do_overlay( OVERLAY_CUSTOM, name, TRUE );
+
+	if( options.overlay->overlay == NULL )
+		return( -1 );
+	return( 0 );
+}
+
 /*=========================================================================================
  * This is called just once, when ncview starts up.  In particular,
  * it is NOT called every time we start a new overlay.
@@ -182,19 +661,13 @@ determine_overlay_base_dir( char *overlay_base_dir, int n )
  * NOTE: 'nvals' is the total number of data values in array data.  Since there are
  * two data values per location, nvals is TWICE the number of locations.
  */
-	void
-gen_overlay_internal_mapped( View *v, float *data, long nvals, int *overlay )
+	static void
+gen_overlay_internal_mapped( View *v, float *data, long nvals, unsigned char *overlay )
 {
-	NCDim	*dim_x, *dim_y;
-	size_t	ii, jj, kk, x_size, y_size, cursor_place[MAX_NC_DIMS];
+	size_t	kk, x_size, y_size;
 	float	x, y, *dimval_x_2d, *dimval_y_2d;
-	nc_type	dimval_type;
-	double	tval, bnds_min, bnds_max;
-	char	cval[1024];
-	int	has_bnds;
-
-	dim_x = *(v->variable->dim + v->x_axis_id);
-	dim_y = *(v->variable->dim + v->y_axis_id);
+	PointIndex *pi;
+	long	closest;
 
 	x_size = *(v->variable->size + v->x_axis_id);
 	y_size = *(v->variable->size + v->y_axis_id);
@@ -205,49 +678,67 @@ gen_overlay_internal_mapped( View *v, float *data, long nvals, int *overlay )
 
 	if( (dimval_x_2d==NULL) || (dimval_y_2d==NULL) ) {
 		in_error( "Malloc of overlay (distance) field failed\n" );
+		if( dimval_x_2d != NULL ) free( dimval_x_2d );
+		if( dimval_y_2d != NULL ) free( dimval_y_2d );
+		return;
 		}
-	for( ii=0; ii<v->variable->n_dims; ii++ )
-		cursor_place[ii] = v->var_place[ii];
 
 	/* Step 1. Get temporary arrays that hold full 2-D X and Y values */
-	for( jj=0; jj<y_size; jj++ )
-	for( ii=0; ii<x_size; ii++ ) {
-		cursor_place[ v->x_axis_id ] = ii;
-		cursor_place[ v->y_axis_id ] = jj;
-
-		/* Get X value */
-		dimval_type = fi_dim_value( v->variable, v->x_axis_id, ii, &tval, cval,
-			&has_bnds, &bnds_min, &bnds_max, cursor_place );
-		if( dimval_type == NC_DOUBLE )
-			dimval_x_2d[ii + jj*x_size] = tval;
-		else
-			dimval_x_2d[ii + jj*x_size] = dim_x->values[ii];
-
-		/* Get Y value */
-		dimval_type = fi_dim_value( v->variable, v->y_axis_id, ii, &tval, cval,
-			&has_bnds, &bnds_min, &bnds_max, cursor_place );
-		if( dimval_type == NC_DOUBLE )
-			dimval_y_2d[ii + jj*x_size] = tval;
-		else
-			dimval_y_2d[ii + jj*x_size] = dim_y->values[jj];
+	if( (fi_dim_values_2d( v->variable, v->x_axis_id, v->x_axis_id, v->y_axis_id, v->var_place, dimval_x_2d ) != 0) ||
+	    (fi_dim_values_2d( v->variable, v->y_axis_id, v->x_axis_id, v->y_axis_id, v->var_place, dimval_y_2d ) != 0) ) {
+		in_error( "Could not get the X and Y values to put the overlay on\n" );
+		free( dimval_x_2d );
+		free( dimval_y_2d );
+		return;
 		}
 
 	/* Step 2. For each point specified in the overlay file, get the CLOSEST
 	 * point in the 2-D X and Y arrays.
 	 */
+	pi = mapped_point_index( dimval_x_2d, dimval_y_2d, x_size*y_size );
+	if( pi == NULL ) {
+		in_error( "Malloc of overlay (index) failed\n" );
+		return;
+		}
 	for( kk=0; kk<nvals; kk+=2 ) {
 		x = data[kk];
 		y = data[kk+1];
 
-		/* printf( "pt %ld / %ld (x,y)=(%f,%f)\n", kk, nvals, x, y ); */
-		overlay_find_closest_pt( kk, x, y, dimval_x_2d, dimval_y_2d, x_size, y_size,
-			&ii, &jj );
-		*(overlay + jj*x_size + ii) = 1;
+		closest = point_index_nearest( pi, x, y );
+		if( closest >= 0 )
+			OVERLAY_MASK_SET( overlay, closest );
+		}
+}
+
+/******************************************************************************
+ * Returns the index onto the 2-D grid whose X and Y values are dimval_x_2d
+ * and dimval_y_2d (n of each).  If that's the same grid as last time, the
+ * index made then is used again; otherwise a new one is made.  Either way,
+ * the index takes over the two arrays and frees them when it's done with
+ * them.  Returns NULL if there isn't enough memory.
+ */
+	static PointIndex *
+mapped_point_index( float *dimval_x_2d, float *dimval_y_2d, size_t n )
+{
+	if( (mapped_index != NULL) && (n == mapped_n) &&
+			(memcmp( dimval_x_2d, mapped_x, n*sizeof(float) ) == 0) &&
+			(memcmp( dimval_y_2d, mapped_y, n*sizeof(float) ) == 0) ) {
+		free( dimval_x_2d );
+		free( dimval_y_2d );
+		return( mapped_index );
 		}
 
-	free(dimval_x_2d);
-	free(dimval_y_2d);
-	printf( "\n" );
+	point_index_free( mapped_index );
+	if( mapped_x != NULL )
+		free( mapped_x );
+	if( mapped_y != NULL )
+		free( mapped_y );
+	mapped_x = dimval_x_2d;
+	mapped_y = dimval_y_2d;
+	mapped_n = n;
+
+	mapped_index = point_index_new( mapped_x, mapped_y, n );
+	return( mapped_index );
 }
 
 /******************************************************************************
@@ -256,12 +747,14 @@ gen_overlay_internal_mapped( View *v, float *data, long nvals, int *overlay )
  * first X coordinate, data[1] is the first Y coordinate, data[2] is the
  * second X coordinate, etc.
  */
-	int *
+	static unsigned char *
 gen_overlay_internal( View *v, float *data, long nvals )
 {
 	NCDim	*dim_x, *dim_y;
+	CoordIndex *ci_x, *ci_y;
 	size_t	x_size, y_size, ii;
-	int	*overlay, x_is_mapped, y_is_mapped;
+	unsigned char *overlay;
+	int	x_is_mapped, y_is_mapped;
 	float	x, y;
 	long	i, j;
 
@@ -271,34 +764,31 @@ gen_overlay_internal( View *v, float *data, long nvals )
 	x_size = *(v->variable->size + v->x_axis_id);
 	y_size = *(v->variable->size + v->y_axis_id);
 
-	overlay = (int *)malloc( x_size*y_size*sizeof(int) );
-	if( overlay == NULL ) {
-		in_error( "Malloc of overlay field failed\n" );
+	overlay = new_overlay_mask( x_size*y_size );
+	if( overlay == NULL )
 		return( NULL );
-		}
-	for( ii=0; ii<x_size*y_size; ii++ )
-		*(overlay+ii) = 0;
 
 	x_is_mapped = (v->variable->dim_map_info[ v->x_axis_id ] != NULL);
 	y_is_mapped = (v->variable->dim_map_info[ v->y_axis_id ] != NULL);
 	if( x_is_mapped || y_is_mapped ) {
-		printf( "Please wait, calculating overlays for mapped coordinates is time-consuming" );
 		gen_overlay_internal_mapped( v, data, nvals, overlay );
 		}
 	else
 		{
+		ci_x = dim_coord_index( dim_x, x_size );
+		ci_y = dim_coord_index( dim_y, y_size );
+		if( (ci_x == NULL) || (ci_y == NULL) ) {
+			free( overlay );
+			return( NULL );
+			}
 		for( ii=0; ii<nvals; ii+=2 ) {
 			x = data[ii];
 			y = data[ii+1];
 
-			i = gen_xform( x, x_size, dim_x->values );
-			if( i == -2 ) 
-				return( NULL );
-			j = gen_xform( y, y_size, dim_y->values );
-			if( j == -2 ) 
-				return( NULL );
+			i = coord_index_lookup( ci_x, x );
+			j = coord_index_lookup( ci_y, y );
 			if( (i > 0) && (j > 0)) 
-				*(overlay + j*x_size + i) = 1;
+				OVERLAY_MASK_SET( overlay, j*x_size + i );
 			}
 		}
 
@@ -308,7 +798,7 @@ gen_overlay_internal( View *v, float *data, long nvals )
 /******************************************************************************
  * Generate an overlay from data in an overlay file.
  */
-	int *
+	unsigned char *
 gen_overlay( View *v, char *overlay_fname )
 {
 	FILE	*f;
@@ -316,8 +806,9 @@ gen_overlay( View *v, char *overlay_fname )
 	float	x, y, version;
 	long	i, j;
 	size_t	x_size, y_size;
-	int	*overlay;
+	unsigned char *overlay;
 	NCDim	*dim_x, *dim_y;
+	CoordIndex *ci_x, *ci_y;
 
 	/* Open the overlay file */
 	if( (f = fopen(overlay_fname, "r")) == NULL ) {
@@ -333,6 +824,7 @@ gen_overlay( View *v, char *overlay_fname )
 		snprintf( err_mess, 1024, "Error trying to read overlay file named \"%s\"\n",
 			overlay_fname );
 		in_error( err_mess );
+		fclose( f );
 		return( NULL );
 		}
 	for( i=0; i<strlen(id_string); i++ )
@@ -340,12 +832,14 @@ gen_overlay( View *v, char *overlay_fname )
 			snprintf( err_mess, 1024, "Error trying to read overlay file named \"%s\"\nFile does not start with \"%s version-num\"\n", 
 				overlay_fname, id_string );
 			in_error( err_mess );
+			fclose( f );
 			return( NULL );
 			}
 	sscanf( line, "%*s %f", &version );
 	if( (version < 0.95) || (version > 1.05)) {
 		snprintf( err_mess, 1024, "Error, overlay file has unknown version number: %f\nI am set up for version 1.0\n", version );
 		in_error( err_mess );
+		fclose( f );
 		return( NULL );
 		}
 
@@ -355,13 +849,19 @@ gen_overlay( View *v, char *overlay_fname )
 	x_size = *(v->variable->size + v->x_axis_id);
 	y_size = *(v->variable->size + v->y_axis_id);
 
-	overlay = (int *)malloc( x_size*y_size*sizeof(int) );
+	ci_x = dim_coord_index( dim_x, x_size );
+	ci_y = dim_coord_index( dim_y, y_size );
+	if( (ci_x == NULL) || (ci_y == NULL) ) {
+		in_error( "Error, not enough memory to put the overlay on this grid\n" );
+		fclose( f );
+		return( NULL );
+		}
+
+	overlay = new_overlay_mask( x_size*y_size );
 	if( overlay == NULL ) {
-		in_error( "Malloc of overlay field failed\n" );
+		fclose( f );
 		return( NULL );
 		}
-	for( i=0; i<x_size*y_size; i++ )
-		*(overlay+i) = 0;
 
 	/* Read in the overlay file -- skip lines with first char of #, 
 	 * they are comments.
@@ -369,62 +869,140 @@ gen_overlay( View *v, char *overlay_fname )
 	while( fgets(line, 80, f) != NULL ) 
 		if( line[0] != '#' ) {
 			sscanf( line, "%f %f", &x, &y );
-			i = gen_xform( x, x_size, dim_x->values );
-			if( i == -2 ) 
-				return( NULL );
-			j = gen_xform( y, y_size, dim_y->values );
-			if( j == -2 ) 
-				return( NULL );
+			i = coord_index_lookup( ci_x, x );
+			j = coord_index_lookup( ci_y, y );
 			if( (i > 0) && (j > 0)) 
-				*(overlay + j*x_size + i) = 1;
+				OVERLAY_MASK_SET( overlay, j*x_size + i );
 			}
+	fclose( f );
 
 	return( overlay );
 }
 
 /******************************************************************************
- * Given the (dimensional) value from the overlay file, convert it to 
- * the nearest index along the proper dimension that the point corresponds to.
- * 'n' is the length of array dimvals.
- *
- * For example, 'value' might be 160.0, and dimvals might go from 0.0 to 359.0
- * by 1.0, in which case n=360.  Then, the returned value is the location in
- * array dimvals that is closest to 160.0, in this case, it will be 160.
+ * Returns a cleared overlay mask with room for n points, or NULL (after
+ * telling the user) if there isn't enough memory.
  */
-	int
-gen_xform( float value, int n, float *dimvals )
+	static unsigned char *
+new_overlay_mask( size_t n )
 {
-	float	min_dist, dist;
-	int	i, min_place;
+	unsigned char *mask;
 
-	min_dist  = 1.0e35;
-	min_place = 0;
+	mask = (unsigned char *)calloc( OVERLAY_MASK_BYTES(n), 1 );
+	if( mask == NULL )
+		in_error( "Malloc of overlay field failed\n" );
 
-	/* See if off ends of dimvalues ... remember that it can be reversed */
-	if( *dimvals > *(dimvals+n-1) ) {
-		/* reversed */
-		if( value > *dimvals )
-			return( -1 );
-		if( value < *(dimvals+n-1) )
-			return( -1 );
+	return( mask );
+}
+
+/******************************************************************************
+ * Put the current overlay (if any) onto the region of v->pixels that starts
+ * at (px0,py0) and is pnx by pny.  This is done to the finished pixels rather
+ * than to the data, so the data is left alone for everything else that uses
+ * it.  A pixel gets the missing value color if any data point it covers is
+ * marked in the overlay mask.  The rows are split among threads.
+ */
+	void
+overlay_pixels( View *v, size_t px0, size_t py0, size_t pnx, size_t pny )
+{
+	OverlayPixelInfo oi;
+	size_t	i;
+
+	if( (! options.overlay->doit) || (options.overlay->overlay == NULL) )
+		return;
+
+	oi.v    = v;
+	oi.mask = options.overlay->overlay;
+	oi.nx   = *(v->variable->size + v->x_axis_id);
+	oi.ny   = *(v->variable->size + v->y_axis_id);
+	view_get_scaled_size( options.blowup, oi.nx, oi.ny, &(oi.new_nx), &(oi.new_ny) );
+	oi.px0  = px0;
+	oi.py0  = py0;
+	oi.pnx  = (long)pnx;
+
+	oi.ix0 = (long *)malloc( pnx*sizeof(long) );
+	oi.ix1 = (long *)malloc( pnx*sizeof(long) );
+	if( (oi.ix0 == NULL) || (oi.ix1 == NULL) ) {
+		fprintf( stderr, "ncview: overlay_pixels: can't allocate %ld column entries\n", pnx );
+		exit( -1 );
 		}
-	else
-		{
-		if( value < *dimvals )
-			return( -1 );
-		if( value > *(dimvals+n-1) )
-			return( -1 );
+	for( i=0; i<pnx; i++ )
+		overlay_source_range( px0+i, oi.nx, oi.new_nx, oi.ix0+i, oi.ix1+i );
+
+	par_for( (long)pny, 64L, overlay_pixel_rows, &oi );
+
+	free( oi.ix0 );
+	free( oi.ix1 );
+}
+
+/******************************************************************************
+ * The data points i0 through i1-1 (along one axis, which has n points) are
+ * the ones that pixel 'pix' of 'new_n' covers.  There is always at least one.
+ * When shrinking by an integer factor, this matches the squares used by
+ * contract_data(), even where the last one hangs off the edge of the data.
+ */
+	static void
+overlay_source_range( size_t pix, size_t n, size_t new_n, long *i0, long *i1 )
+{
+	if( (options.zoom == 0.0) && (options.blowup < 0) ) {
+		*i0 = (long)pix * (long)(-options.blowup);
+		*i1 = *i0 - options.blowup;
+		if( *i0 > (long)n-1 )
+			*i0 = (long)n-1;
+		if( *i1 > (long)n )
+			*i1 = (long)n;
+		return;
 		}
-	
-	for( i=0; i<n; i++ ) {
-		dist = fabs(*(dimvals+i) - value);
-		if( dist < min_dist ) {
-			min_dist  = dist;
-			min_place = i;
+
+	*i0 = (long)(((double)pix * (double)n) / (double)new_n);
+	*i1 = (long)ceil( ((double)(pix+1) * (double)n) / (double)new_n );
+	if( *i0 > (long)n-1 )
+		*i0 = (long)n-1;
+	if( *i1 <= *i0 )
+		*i1 = *i0 + 1;
+	if( *i1 > (long)n )
+		*i1 = (long)n;
+}
+
+/******************************************************************************
+ * Does pixel rows first through last-1 of overlay_pixels.  Called through par_for.
+ */
+	static void
+overlay_pixel_rows( long first, long last, void *arg )
+{
+	OverlayPixelInfo *oi;
+	long	j, i, iy0, iy1, ii, jj;
+	size_t	prow, srow, base;
+	int	hit;
+	ncv_pixel *pix, fill_pixel;
+
+	oi         = (OverlayPixelInfo *)arg;
+	fill_pixel = *pixel_transform;
+
+	for( j=first; j<last; j++ ) {
+		/* Pixel rows run top to bottom, the data bottom to top, unless inverted */
+		prow = oi->py0 + j;
+		if( options.invert_physical )
+			srow = prow;
+		else
+			srow = oi->new_ny - prow - 1;
+		overlay_source_range( srow, oi->ny, oi->new_ny, &iy0, &iy1 );
+
+		pix = oi->v->pixels + oi->px0 + prow*oi->new_nx;
+		for( i=0; i<oi->pnx; i++ ) {
+			hit = FALSE;
+			for( jj=iy0; (jj<iy1) && (! hit); jj++ ) {
+				base = jj*oi->nx;
+				for( ii=oi->ix0[i]; ii<oi->ix1[i]; ii++ )
+					if( OVERLAY_MASK_TEST( oi->mask, base + ii )) {
+						hit = TRUE;
+						break;
+						}
+				}
+			if( hit )
+				pix[i] = fill_pixel;
 			}
 		}
-
-	return( min_place );
 }
 
 /****************************************************************************************/
@@ -454,237 +1032,3 @@ overlay_custom_n( void )
 {
 	return( OVERLAY_CUSTOM );
 }
-
-/****************************************************************************************
- * Since distances on a sphere are monotonic with no local minima or maxima, we simply
- * follow the downhill direction until we reach a minimum.
- * Indexing:
- *
- *	0 1 2
- * 	3 4 5
- * 	6 7 8
- * |
- * |
- * (0,0) -----
- *
- */
-	void
-overlay_find_closest_pt_inner( size_t point_number, size_t init_guess_idxx, size_t init_guess_idxy, 
-	float locx, float locy, float *xvals, float *yvals, size_t nx, size_t ny, size_t *idxx, size_t *idxy )
-{
-	float	dist[9], dx, dy, mindist, tdist[9], prev_d4;
-	long	i, j, nsteps, xx;
-	long	have_calc[9], index, minloc, ox, oy, isrc, jsrc, idx_src, idx_dest, debug;
-	long	curx, cury, i2use, j2use, i0, j0;
-	int	n_wrapped_x, n_wrapped_y;
-	
-	debug  = 0;
-	nsteps = 0L;
-	n_wrapped_x = 0;
-	n_wrapped_y = 0;
-
-	if( debug ) {
-		i0 = 68;
-		j0 = 46;
-		for( j=j0; j<j0+5; j++ ) {
-			for( i=i0; i<i0+5; i++ ) {
-				index = i + j*nx;
-				printf( "(%3ld,%3ld)=(%f,%f) ", i, j, xvals[index], yvals[index] );
-				}
-			printf( "\n" );
-			}
-		}
-
-	curx = init_guess_idxx;
-	cury = init_guess_idxy;
-
-	for( i=0; i<9; i++ )
-		have_calc[i] = 0;
-
-	minloc = -1;
-	while( minloc != 4 ) {
-		nsteps++;
-		mindist = 1.e31;
-		for( j=-1; j<=1; j++ )
-		for( i=-1; i<=1; i++ ) {
-			index = (i+1) + (-j+1)*3;
-			if( ! have_calc[index] ) {
-				if( (curx == 0) && (i == -1))
-					i2use = nx-1;
-				else if( (curx == nx-1) && (i == 1))
-					i2use = 0;
-				else
-					i2use = curx + i;
-
-				if( (cury == 0) && (j == -1))
-					j2use = ny-1;
-				else if( (cury == ny-1) && (j == 1))
-					j2use = 0;
-				else
-					j2use = cury + j;
-				xx = i2use + j2use*nx;
-				dx = locx - xvals[xx];
-				if( dx != dx ) {
-					fprintf( stderr, "Error, bad dx  locx=%f  index_xx=%ld  xvals[index]=%f\n", 
-						locx, xx, xvals[xx] );
-					exit(-1);
-					}
-				dy = locy - yvals[xx];
-				if( dy != dy ) {
-					fprintf( stderr, "Error, bad dy  locy=%f  index_xx=%ld  yvals[index]=%f\n", 
-						locy, xx, yvals[xx] );
-					exit(-1);
-					}
-				dist[index] = dx*dx + dy*dy;	/* don't bother with square root, takes time and won't affect minimum finding */
-				}
-			if( debug ) 
-				printf( "calculating for index=%ld, i2use,j2use=%ld,%ld  xx=%ld  dx,dy=%f,%f  dist=%f\n", 
-					index, i2use, j2use, xx, dx, dy, dist[index] );
-				
-			if( dist[index] < mindist ) {
-				mindist = dist[index];
-				minloc  = index;
-				}
-			}
-
-		if( debug ) {
-			printf( "cur loc=(%ld,%ld)  minloc=%ld\n", curx, cury, minloc );
-			for( j=2; j>=0; j-- ) {
-				for( i=0; i<3; i++ ) {
-					index = i + (2-j)*3;
-					if( index == minloc )
-						printf( ">%f< ", dist[index] );
-					else
-						printf( " %f  ", dist[index] );
-					}
-				printf( "\n" );
-				}
-				
-			}
-
-		prev_d4 = dist[4];
-
-		/* Now do the shifting towards the downhill direction 
-		 *
-		 *	0 1 2
-		 * 	3 4 5
-		 * 	6 7 8
-		 * |
-		 * |
-		 * (0,0) -----
-		 */
-		for( i=0; i<9; i++ )
-			have_calc[i] = 0;
-		switch( minloc ) {
- 			case 0: ox=-1; oy=1;  break;
-			case 1: ox=0;  oy=1;  break;
-			case 2: ox=1;  oy=1;  break;
-			case 3: ox=-1; oy=0;  break;
-			case 4: ox=0;  oy=0;  break;
-			case 5: ox=1;  oy=0;  break;
-			case 6: ox=-1; oy=-1; break;
-			case 7: ox=0;  oy=-1; break;
-			case 8: ox=1;  oy=-1; break;
-			default:
-				fprintf( stderr, "coding error in overlay.c, minloc=%ld\n", minloc );
-				exit(-1);
-			}
-
-		/* Update current x,y position */
-		if( (curx == 0) && (ox == -1)) {
-			n_wrapped_x++;
-			curx = nx-1;
-			}
-		else if( (curx == nx-1) && (ox == 1)) {
-			n_wrapped_x++;
-			curx = 0;
-			}
-		else
-			curx = curx + ox;
-
-		if( (cury == 0) && (oy == -1)) {
-			n_wrapped_y++;
-			cury = ny-1;
-			}
-		else if( (cury == ny-1) && (oy == 1)) {
-			cury = 0;
-			n_wrapped_y++;
-			}
-		else
-			cury = cury + oy;
-		if( (curx<0) || (cury<0) || (curx>=nx) || (cury>=ny)) {
-			fprintf( stderr, "Error, alg fails, cursor off array; cursor=(%ld,%ld)  nx=%ld  ny=%ld\n", curx, cury, nx, ny);
-			exit(-1);
-			}
-		if( (n_wrapped_x > 2) || (n_wrapped_y > 2)) {
-			/* Give up */
-			*idxx = 0;
-			*idxy = 0;
-			return;
-			}
-
-		/* Shift the distance array appropriately */
-		for( i=-1; i<=1; i++ )
-		for( j=-1; j<=1; j++ ) {
-			idx_dest = (i+1) + (-j+1)*3;
-			isrc = i + ox;
-			jsrc = j + oy;
-			if( (isrc>=-1) && (isrc<=1) && (jsrc>=-1) && (jsrc<=1)) {
-				idx_src = (isrc+1) + (-jsrc+1)*3;
-				if( (idx_src<0) || (idx_src>8)) {
-					fprintf( stderr, "Error, alg failed! overlay.c while shifting\n" );
-					exit(-1);
-					}
-				tdist[idx_dest] = dist[idx_src];
-				have_calc[idx_dest] = 1;
-				}
-			}
-
-		for( i=0; i<9; i++ )
-			dist[i] = tdist[i];
-
-		if( dist[4] > prev_d4 ) {
-			fprintf( stderr, "error, alg fails; prev center dist=%f  new=%f  should always be getting closer!\n",
-				prev_d4, dist[4] );
-			exit(-1);
-			}
-		}
-
-	*idxx = curx;
-	*idxy = cury;
-
-	/* printf( "nsteps=%ld\n", nsteps ); */
-}
-
-/******************************************************************************************
- * Given a location (locx, locy) and an array of values (xvals(nx,ny), yvals(nx,ny)), this
- * calculates the index into the xvals and yvals array such that the distance between
- * (locx,locy) and (xvals(idxx,idxy), yvals(idxx,idxy)) is minimized.
- */
- 	void
-overlay_find_closest_pt( size_t point_number, float locx, float locy, float *xvals, float *yvals, size_t nx, size_t ny,
-		size_t *idxx, size_t *idxy )
-{
-	size_t	init_guess_idxx, init_guess_idxy;
-	static	int have_been_here_before = 0;
-	static	size_t last_idxx, last_idxy;
-
-	if( have_been_here_before ) {
-		init_guess_idxx = last_idxx;
-		init_guess_idxy = last_idxy;
-		}
-	else
-		{
-		init_guess_idxx = nx/2;
-		init_guess_idxy = ny/2;
-		}
-
-	overlay_find_closest_pt_inner( point_number, init_guess_idxx, init_guess_idxy, locx, locy, xvals, yvals,
-		nx, ny, idxx, idxy );
-
-	have_been_here_before = 1;
-	last_idxx = *idxx;
-	last_idxy = *idxy;
-}
-
-
@@ -0,0 +1,182 @@
+/*
+ * Ncview by David W. Pierce.  A visual netCDF file viewer.
+ * Copyright (C) 1993 through 2010 David W. Pierce
+ *
+ * This program  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License, version 3, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * David W. Pierce
+ * 6259 Caminito Carrena
+ * San Diego, CA  92122
+ * dpierce@ucsd.edu
+ */
+
+/* Splitting up work that can be done in pieces, such as the rows of
+ * an image, among several threads.  If ncview was configured without
+ * the pthreads library, everything is simply done in the calling thread.
+ *
+ * NOTE: the netCDF library is not thread safe, so the work done this
+ * way must never read from the data files.  Nor can it touch X.
+ *
+ * A par_for inside a piece of another one (for example, the rows of an
+ * image, when several images are being made at once) is done in the
+ * calling thread, so that we don't end up with threads times threads.
+ */
+
+#include "ncview.includes.h"
+#include "ncview.defines.h"
+#include "ncview.protos.h"
+
+#ifdef HAVE_LIBPTHREAD
+#include <pthread.h>
+#endif
+
+extern Options options;
+
+typedef struct {
+	ParallelFunc	func;
+	long		first, last;	/* This thread does items first through last-1 */
+	void		*arg;
+} ParallelChunk;
+
+#ifdef HAVE_LIBPTHREAD
+static pthread_key_t	par_in_piece_key;	/* Non-NULL in a thread doing a piece */
+static pthread_once_t	par_key_once = PTHREAD_ONCE_INIT;
+
+static void *par_thread_main( void *chunk );
+static void par_make_key( void );
+#endif
+
+/*******************************************************************************
+ * Returns the number of threads to split work among.  This is set by the
+ * -threads option, or is the number of processors if that wasn't given.
+ */
+	int
+par_n_threads( void )
+{
+	static int	n_threads = -1;
+
+	if( n_threads > 0 )
+		return( n_threads );
+
+#ifdef HAVE_LIBPTHREAD
+	if( options.n_threads > 0 )
+		n_threads = options.n_threads;
+	else
+		n_threads = (int)sysconf( _SC_NPROCESSORS_ONLN );
+	if( n_threads < 1 )
+		n_threads = 1;
+	if( n_threads > MAX_THREADS )
+		n_threads = MAX_THREADS;
+#else
+	n_threads = 1;
+#endif
+
+	if( options.debug )
+		fprintf( stderr, "par_n_threads: using %d threads\n", n_threads );
+
+	return( n_threads );
+}
+
+/*******************************************************************************
+ * Calls func( first, last, arg ) so that items 0 through n-1 are all done
+ * exactly once, splitting the items into contiguous pieces that are done in
+ * parallel.  Does not return until all the pieces are done.  Pieces are
+ * never smaller than min_per_thread items, since starting a thread is not
+ * free.
+ */
+	void
+par_for( long n, long min_per_thread, ParallelFunc func, void *arg )
+{
+	long		nt, i, per_thread;
+	ParallelChunk	chunk[MAX_THREADS];
+#ifdef HAVE_LIBPTHREAD
+	pthread_t	thread[MAX_THREADS];
+	int		started[MAX_THREADS];
+#endif
+
+	if( n <= 0 )
+		return;
+
+#ifdef HAVE_LIBPTHREAD
+	pthread_once( &par_key_once, par_make_key );
+	if( pthread_getspecific( par_in_piece_key ) != NULL ) {
+		func( 0L, n, arg );
+		return;
+		}
+#endif
+
+	if( min_per_thread < 1 )
+		min_per_thread = 1;
+	nt = par_n_threads();
+	if( nt > n/min_per_thread )
+		nt = n/min_per_thread;
+	if( nt <= 1 ) {
+		func( 0L, n, arg );
+		return;
+		}
+
+	per_thread = (n + nt - 1)/nt;
+	for( i=0; i<nt; i++ ) {
+		chunk[i].func  = func;
+		chunk[i].arg   = arg;
+		chunk[i].first = i*per_thread;
+		chunk[i].last  = (i+1)*per_thread;
+		if( chunk[i].last > n )
+			chunk[i].last = n;
+		}
+
+#ifdef HAVE_LIBPTHREAD
+	/* The calling thread does the first piece itself.  If a thread
+	 * can't be started, its piece is done here too.
+	 */
+	for( i=1; i<nt; i++ )
+		started[i] = (pthread_create( thread+i, NULL, par_thread_main, (void *)(chunk+i) ) == 0);
+
+	pthread_setspecific( par_in_piece_key, (void *)chunk );
+	func( chunk[0].first, chunk[0].last, arg );
+
+	for( i=1; i<nt; i++ ) {
+		if( started[i] )
+			pthread_join( thread[i], NULL );
+		else
+			func( chunk[i].first, chunk[i].last, arg );
+		}
+	pthread_setspecific( par_in_piece_key, NULL );
+#else
+	for( i=0; i<nt; i++ )
+		func( chunk[i].first, chunk[i].last, arg );
+#endif
+}
+
+#ifdef HAVE_LIBPTHREAD
+/*******************************************************************************/
+	static void *
+par_thread_main( void *chunk )
+{
+	ParallelChunk	*c;
+
+	c = (ParallelChunk *)chunk;
+	pthread_setspecific( par_in_piece_key, chunk );
+	c->func( c->first, c->last, c->arg );
+
+	return( NULL );
+}
+
+/*******************************************************************************/
+	static void
+par_make_key( void )
+{
+	pthread_key_create( &par_in_piece_key, NULL );
+}
+#endif
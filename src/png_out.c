@@ -0,0 +1,356 @@
+/*
+ * Ncview by David W. Pierce.  A visual netCDF file viewer.
+ * Copyright (C) 1993 through 2010 David W. Pierce
+ *
+ * This program  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License, version 3, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * David W. Pierce
+ * 6259 Caminito Carrena
+ * San Diego, CA  92122
+ * dpierce@ucsd.edu
+ */
+
+/* Writing frames out as PNG files, for the "-frames" option (see
+ * dump_to_png in x_interface.c) and the "-batch" mode (see batch.c).
+ * write_png_frame doesn't touch the display or keep any state, so frames
+ * can be written from several threads at once.
+ *
+ * Compressing a frame takes much longer than drawing it, so with -frames
+ * the frames are handed to png_queue_frame, which copies them onto a queue
+ * that a few encoder threads (-png_threads) take them from.  The queue
+ * only holds a couple of frames per thread; when it's full, the caller
+ * waits, so memory use doesn't grow when frames come faster than they can
+ * be written.  All queued frames are written before ncview exits.
+ *
+ * -png_level and -png_filter set the zlib compression level and the row
+ * filters, for trading file size against the time to write each frame.
+ */
+
+#include "ncview.includes.h"
+#include "ncview.defines.h"
+#include "ncview.protos.h"
+
+#ifdef HAVE_PNG
+#include <png.h>
+#include <setjmp.h>
+
+#ifdef HAVE_LIBPTHREAD
+#include <pthread.h>
+#endif
+
+#define PNG_QUEUE_PER_THREAD	2	/* Frames that can wait for each encoder thread */
+
+extern Options	options;
+
+/* libpng's filter masks, in PNG_FILTERS_ order */
+static int png_filter_mask[] = { 0, PNG_FILTER_NONE, PNG_FILTER_SUB, PNG_FILTER_UP,
+		PNG_FILTER_AVG, PNG_FILTER_PAETH, PNG_ALL_FILTERS };
+
+static int	png_write_failed = FALSE;
+
+#ifdef HAVE_LIBPTHREAD
+/* A frame waiting to be written */
+typedef struct {
+	char		*filename;
+	unsigned char	*data;
+	size_t		width, height;
+	XColor		*color_list;
+	int		n_colors;
+} PngJob;
+
+static PngJob		**png_queue;	/* Ring of frames waiting to be written */
+static int		png_queue_len, png_queue_head = 0, png_queue_n = 0,
+			png_n_busy = 0,	/* Threads writing a frame right now */
+			png_n_threads = 0;	/* 0 before they're started, -1 if there are none */
+static pthread_mutex_t	png_lock      = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t	png_have_work = PTHREAD_COND_INITIALIZER,
+			png_have_room = PTHREAD_COND_INITIALIZER,
+			png_all_done  = PTHREAD_COND_INITIALIZER;
+
+static void	png_start_threads( void );
+static void	*png_thread_main( void *unused );
+static PngJob	*png_copy_job( char *filename, unsigned char *data, size_t width, size_t height,
+			XColor *color_list, int n_colors );
+static void	png_free_job( PngJob *job );
+#endif
+
+/*******************************************************************************
+ * Write a width x height array of pixel values to 'filename' as an 8 bit
+ * palette PNG.  Pixel value i is shown with color_list[i]; there are
+ * n_colors entries in color_list (only the first 256 can be used).
+ * Returns 0 on success, or -1 if the file couldn't be written.
+ */
+	int
+write_png_frame( char *filename, unsigned char *data, size_t width, size_t height,
+		XColor *color_list, int n_colors )
+{
+	FILE		*out_file;
+	png_structp	png_ptr;
+	png_infop	info_ptr;
+	png_colorp	palette;
+	int		i, n_palette;
+	size_t		j;
+	unsigned char	**row_pointers;
+
+	/* Open binary output file */
+	if( (out_file = fopen( filename, "wb" )) == NULL ) {
+		fprintf( stderr, "ncview: can't open PNG file %s for writing\n", filename );
+		return( -1 );
+		}
+
+	/* Set up PNG information structures */
+	png_ptr = png_create_write_struct( PNG_LIBPNG_VER_STRING, (png_voidp)NULL, NULL, NULL );	/* use default error handlers */
+	if( ! png_ptr ) {
+		fprintf( stderr, "Error returned when trying to allocate PNG write structure\n" );
+		fclose( out_file );
+		return( -1 );
+		}
+
+	info_ptr = png_create_info_struct( png_ptr );
+	if( ! info_ptr ) {
+		fprintf( stderr, "Error returned when trying to allocate PNG info structure\n" );
+		png_destroy_write_struct( &png_ptr, (png_infopp)NULL );
+		fclose( out_file );
+		return( -1 );
+		}
+
+	/* Set our palette and row pointers */
+	n_palette = (n_colors < 256) ? n_colors : 256;
+	palette      = (png_colorp)malloc( sizeof(png_color) * n_palette );
+	row_pointers = (unsigned char **)malloc( sizeof( unsigned char * ) * height );
+	if( (palette == NULL) || (row_pointers == NULL) ) {
+		fprintf( stderr, "Failed to allocate PNG palette and row pointers; returning without writing output file\n" );
+		png_destroy_write_struct( &png_ptr, &info_ptr );
+		fclose( out_file );
+		return( -1 );
+		}
+	for( i=0; i<n_palette; i++ ) {
+		palette[i].red   = ((color_list+i)->red   >> 8);
+		palette[i].green = ((color_list+i)->green >> 8);
+		palette[i].blue  = ((color_list+i)->blue  >> 8);
+		}
+	for( j=0; j<height; j++ )
+		row_pointers[j] = data + j*width;
+
+	/* Set up longjump target (PNG will use this for an error) */
+	if( setjmp( png_jmpbuf(png_ptr))) {
+		fprintf( stderr, "Error returned when trying to write PNG file %s, aborting operation\n", filename );
+		png_destroy_write_struct( &png_ptr, &info_ptr );
+		free( row_pointers );
+		free( palette );
+		fclose( out_file );
+		return( -1 );
+		}
+
+	/* Set up PNG I/O ops */
+	png_init_io( png_ptr, out_file );
+
+	/* Describe our image for PNG */
+	png_set_IHDR( png_ptr, info_ptr, width, height, 8,
+		PNG_COLOR_TYPE_PALETTE,		/* ncview operates with palettes almost exclusively */
+		PNG_INTERLACE_NONE,
+		PNG_COMPRESSION_TYPE_DEFAULT,
+		PNG_FILTER_TYPE_DEFAULT );
+	png_set_PLTE( png_ptr, info_ptr, palette, n_palette );
+	if( options.png_level >= 0 )
+		png_set_compression_level( png_ptr, options.png_level );
+	if( options.png_filter != PNG_FILTERS_DEFAULT )
+		png_set_filter( png_ptr, PNG_FILTER_TYPE_BASE, png_filter_mask[options.png_filter] );
+	png_set_rows( png_ptr, info_ptr, row_pointers );
+
+	/* Write PNG data */
+	png_write_png( png_ptr, info_ptr, PNG_TRANSFORM_IDENTITY, NULL );
+
+	png_destroy_write_struct( &png_ptr, &info_ptr );
+	free( row_pointers );
+	free( palette );
+
+	if( fclose( out_file ) != 0 ) {
+		fprintf( stderr, "ncview: error writing PNG file %s\n", filename );
+		return( -1 );
+		}
+	return( 0 );
+}
+
+/*******************************************************************************
+ * Like write_png_frame, but the frame is copied and written later by one
+ * of the encoder threads, so this returns right away unless the queue is
+ * full.  Returns -1 if a frame couldn't be written (this one, or one
+ * that was queued before), in which case there's no point in sending
+ * any more.
+ */
+	int
+png_queue_frame( char *filename, unsigned char *data, size_t width, size_t height,
+		XColor *color_list, int n_colors )
+{
+#ifdef HAVE_LIBPTHREAD
+	PngJob	*job;
+	int	slot;
+
+	if( png_write_failed )
+		return( -1 );
+
+	if( png_n_threads == 0 )
+		png_start_threads();
+
+	if( (png_n_threads > 0) &&
+	    ((job = png_copy_job( filename, data, width, height, color_list, n_colors )) != NULL) ) {
+		pthread_mutex_lock( &png_lock );
+		while( png_queue_n == png_queue_len )
+			pthread_cond_wait( &png_have_room, &png_lock );
+		slot = (png_queue_head + png_queue_n) % png_queue_len;
+		png_queue[slot] = job;
+		png_queue_n++;
+		pthread_cond_signal( &png_have_work );
+		pthread_mutex_unlock( &png_lock );
+		return( 0 );
+		}
+#endif
+
+	/* No threads, so just write it now */
+	if( png_write_failed )
+		return( -1 );
+	if( write_png_frame( filename, data, width, height, color_list, n_colors ) != 0 )
+		png_write_failed = TRUE;
+	return( png_write_failed ? -1 : 0 );
+}
+
+/*******************************************************************************
+ * Wait until all the queued frames have been written.
+ */
+	void
+png_queue_finish( void )
+{
+#ifdef HAVE_LIBPTHREAD
+	if( png_n_threads <= 0 )
+		return;
+
+	pthread_mutex_lock( &png_lock );
+	while( (png_queue_n > 0) || (png_n_busy > 0) )
+		pthread_cond_wait( &png_all_done, &png_lock );
+	pthread_mutex_unlock( &png_lock );
+#endif
+}
+
+#ifdef HAVE_LIBPTHREAD
+/*******************************************************************************
+ * By default, use one thread fewer than the number we split image
+ * processing among, to leave one for the user interface.
+ */
+	static void
+png_start_threads( void )
+{
+	pthread_t	thread;
+	int		i, n;
+
+	if( options.png_threads > 0 )
+		n = options.png_threads;
+	else
+		n = par_n_threads() - 1;
+	if( n < 1 )
+		n = 1;
+	if( n > MAX_THREADS )
+		n = MAX_THREADS;
+
+	png_queue_len = PNG_QUEUE_PER_THREAD * n;
+	png_queue     = (PngJob **)malloc( png_queue_len*sizeof(PngJob *) );
+	png_n_threads = -1;
+	if( png_queue == NULL )
+		return;
+
+	for( i=0; i<n; i++ )
+		if( pthread_create( &thread, NULL, png_thread_main, NULL ) == 0 ) {
+			pthread_detach( thread );
+			png_n_threads = (png_n_threads < 0) ? 1 : png_n_threads+1;
+			}
+
+	if( png_n_threads > 0 )
+		atexit( png_queue_finish );
+	if( options.debug )
+		fprintf( stderr, "ncview: writing PNG files in %d threads\n", png_n_threads );
+}
+
+/*******************************************************************************/
+	static void *
+png_thread_main( void *unused )
+{
+	PngJob	*job;
+	int	err;
+
+	pthread_mutex_lock( &png_lock );
+	for( ;; ) {
+		while( png_queue_n == 0 )
+			pthread_cond_wait( &png_have_work, &png_lock );
+		job = png_queue[ png_queue_head ];
+		png_queue_head = (png_queue_head + 1) % png_queue_len;
+		png_queue_n--;
+		png_n_busy++;
+		pthread_cond_signal( &png_have_room );
+		pthread_mutex_unlock( &png_lock );
+
+		err = write_png_frame( job->filename, job->data, job->width, job->height,
+				job->color_list, job->n_colors );
+		png_free_job( job );
+
+		pthread_mutex_lock( &png_lock );
+		png_n_busy--;
+		if( err )
+			png_write_failed = TRUE;
+		if( (png_queue_n == 0) && (png_n_busy == 0) )
+			pthread_cond_broadcast( &png_all_done );
+		}
+
+	return( NULL );
+}
+
+/*******************************************************************************
+ * Returns NULL if there isn't enough memory for the copy.
+ */
+	static PngJob *
+png_copy_job( char *filename, unsigned char *data, size_t width, size_t height,
+		XColor *color_list, int n_colors )
+{
+	PngJob	*job;
+
+	if( (job = (PngJob *)malloc( sizeof(PngJob) )) == NULL )
+		return( NULL );
+	job->filename   = (char *)malloc( strlen(filename)+1 );
+	job->data       = (unsigned char *)malloc( width*height );
+	job->color_list = (XColor *)malloc( n_colors*sizeof(XColor) );
+	if( (job->filename == NULL) || (job->data == NULL) || (job->color_list == NULL) ) {
+		png_free_job( job );
+		return( NULL );
+		}
+	strcpy( job->filename, filename );
+	memcpy( job->data, data, width*height );
+	memcpy( job->color_list, color_list, n_colors*sizeof(XColor) );
+	job->width    = width;
+	job->height   = height;
+	job->n_colors = n_colors;
+
+	return( job );
+}
+
+/*******************************************************************************/
+	static void
+png_free_job( PngJob *job )
+{
+	free( job->filename );
+	free( job->data );
+	free( job->color_list );
+	free( job );
+}
+#endif
+
+#endif
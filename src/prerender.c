@@ -0,0 +1,209 @@
+/*
+ * Ncview by David W. Pierce.  A visual netCDF file viewer.
+ * Copyright (C) 1993 through 2010 David W. Pierce
+ *
+ * This program  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License, version 3, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * David W. Pierce
+ * 6259 Caminito Carrena
+ * San Diego, CA  92122
+ * dpierce@ucsd.edu
+ */
+
+/* Pre-rendering (the "-prerender" option): while the user interface is
+ * idle, read the frames that come after the current one and put them into
+ * the framestore at data resolution, so that the first time through an
+ * animation is as fast as the later ones.  One frame is done each time
+ * we are called, so the interface stays responsive.  This is done with an
+ * Xt work procedure rather than a separate thread because the netCDF
+ * library is not thread safe.
+ *
+ * Anything that makes the saved frames out of date (a new variable, axes,
+ * range, colormap, and so on) goes through init_saveframes() or
+ * invalidate_all_saveframes(), which start pre-rendering over.
+ */
+
+#include "ncview.includes.h"
+#include "ncview.defines.h"
+#include "ncview.protos.h"
+
+extern View		*view;
+extern Options		options;
+extern FrameStore	framestore;
+
+static int	prerender_active = FALSE;
+static size_t	prerender_k,		/* Next frame to try is prerender_k * skip */
+		prerender_n_tried,	/* How many frames we have looked at */
+		prerender_n_todo;	/* How many frames there are to look at */
+
+static Boolean	prerender_step( XtPointer arg );
+static void	prerender_finish( void );
+
+/*******************************************************************************
+ * Stop any pre-rendering that is going on, and (if pre-rendering is
+ * wanted) start again from the frame after the current one.
+ */
+	void
+prerender_restart( void )
+{
+	size_t	nt, skip;
+
+	prerender_cancel();
+
+	/* With -autoscale, every frame has its own range, so the saved
+	 * frames would be thrown away as soon as they were shown
+	 */
+	if( (! options.prerender) || (! options.save_frames) || options.autoscale ||
+	    (view == NULL) || (view->scan_axis_id == -1) || (! framestore.valid) )
+		return;
+
+	/* The saved frames can only be shown at some blowups; at the others
+	 * view_draw goes back to the data, so there is no point in this
+	 */
+	if( ! levels_match_data() )
+		return;
+
+	nt   = *(view->variable->size + view->scan_axis_id);
+	skip = (view->skip > 0) ? view->skip : 1;
+
+	prerender_n_todo  = (nt + skip - 1)/skip;
+	prerender_k       = *(view->var_place + view->scan_axis_id)/skip + 1;
+	prerender_n_tried = 0L;
+	prerender_active  = TRUE;
+
+	if( options.debug )
+		fprintf( stderr, "prerender_restart: %ld frames to do\n", prerender_n_todo );
+
+	in_work_proc_set( prerender_step, NULL );
+}
+
+/*******************************************************************************/
+	void
+prerender_cancel( void )
+{
+	if( ! prerender_active )
+		return;
+
+	in_work_proc_clear();
+	prerender_active = FALSE;
+	view_update_scan_label();
+}
+
+/*******************************************************************************
+ * Returns a string to put after the scan place, saying how far along the
+ * pre-rendering is, or an empty string if it isn't going on.
+ */
+	char *
+prerender_status( void )
+{
+	static char	status[100];
+
+	if( ! prerender_active )
+		return( "" );
+
+	snprintf( status, 99, " [pre-rendering %ld/%ld]", prerender_n_tried, prerender_n_todo );
+	return( status );
+}
+
+/*******************************************************************************
+ * The work procedure.  Reads, converts, and saves one frame that isn't in
+ * the framestore yet.  Returns True (meaning don't call again) when all
+ * the frames have been done, or when the framestore is full.
+ */
+	static Boolean
+prerender_step( XtPointer arg )
+{
+	size_t	nt, skip, frameno, nx, ny, nbytes, *place, *count;
+	int	i;
+	float	*data;
+	ncv_pixel *levels;
+	View	tmp_view;
+
+	if( (view == NULL) || (! framestore.valid) || (! view->variable->have_set_range) ) {
+		prerender_finish();
+		return( True );
+		}
+
+	nt   = *(view->variable->size + view->scan_axis_id);
+	skip = (view->skip > 0) ? view->skip : 1;
+
+	/* Skip over the frames we already have, without giving up control */
+	for( ;; ) {
+		if( prerender_n_tried >= prerender_n_todo ) {
+			prerender_finish();
+			return( True );
+			}
+		if( prerender_k*skip >= nt )
+			prerender_k = 0L;
+		frameno = prerender_k*skip;
+		prerender_k++;
+		prerender_n_tried++;
+		if( ! framestore_has( FRAMES_DATA, frameno ))
+			break;
+		}
+
+	nx = *(view->variable->size + view->x_axis_id);
+	ny = *(view->variable->size + view->y_axis_id);
+
+	place  = (size_t *)malloc( view->variable->n_dims * sizeof(size_t) );
+	count  = (size_t *)malloc( view->variable->n_dims * sizeof(size_t) );
+	data   = (float *)malloc( nx*ny*sizeof(float) );
+	levels = (ncv_pixel *)malloc( nx*ny*sizeof(ncv_pixel) );
+	if( (place == NULL) || (count == NULL) || (data == NULL) || (levels == NULL) ) {
+		fprintf( stderr, "ncview: prerender_step: can't allocate space for a frame of %ld x %ld\n", nx, ny );
+		exit( -1 );
+		}
+
+	/* Read the frame the same way fill_view_data does */
+	for( i=0; i<view->variable->n_dims; i++ ) {
+		place[i] = *(view->var_place + i);
+		count[i] = 1L;
+		}
+	place[ view->scan_axis_id ] = frameno;
+	count[ view->x_axis_id ]    = nx;
+	count[ view->y_axis_id ]    = ny;
+	fi_get_data( view->variable, place, count, data );
+
+	tmp_view      = *view;
+	tmp_view.data = data;
+	data_to_levels( &tmp_view, levels );
+	nbytes = framestore_put( FRAMES_DATA, frameno, nx, ny, levels );
+
+	free( place );
+	free( count );
+	free( data );
+	free( levels );
+
+	view_update_scan_label();
+
+	/* Stop when there is no room for another frame like this one, so
+	 * that we don't start pushing out frames that have been shown
+	 */
+	if( (nbytes == 0L) || (framestore_bytes_free() < nbytes) ) {
+		if( options.debug )
+			fprintf( stderr, "prerender_step: framestore is full after %ld frames\n", prerender_n_tried );
+		prerender_finish();
+		return( True );
+		}
+
+	return( False );
+}
+
+/*******************************************************************************/
+	static void
+prerender_finish( void )
+{
+	prerender_active = FALSE;
+	view_update_scan_label();
+}
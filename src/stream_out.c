@@ -0,0 +1,179 @@
+/*
+ * Ncview by David W. Pierce.  A visual netCDF file viewer.
+ * Copyright (C) 1993 through 2010 David W. Pierce
+ *
+ * This program  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License, version 3, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * David W. Pierce
+ * 6259 Caminito Carrena
+ * San Diego, CA  92122
+ * dpierce@ucsd.edu
+ */
+
+/* Streaming frames out (the "-stream" option), so that a video encoder
+ * can take them straight from a pipe or FIFO, for example:
+ *
+ *	ncview -batch x -stream - data.nc | ffmpeg -i - movie.mp4
+ *
+ * With -stream_format y4m (the default), the stream is YUV4MPEG2 with
+ * 4:4:4 sampling, which carries its own frame size and rate.  With
+ * -stream_format rgb it's just the frames, 3 bytes per pixel, one after
+ * the other; the encoder has to be told the size (it's printed to stderr).
+ * Either way the frames all have to be the same size.
+ *
+ * When streaming to stdout, anything else that would go to stdout goes to
+ * stderr instead, so it can't get mixed in with the frames.
+ */
+
+#include "ncview.includes.h"
+#include "ncview.defines.h"
+#include "ncview.protos.h"
+
+#include <signal.h>
+
+#define STREAM_BUF_BYTES	(4*1024*1024)	/* stdio buffer for the stream */
+
+extern Options	options;
+
+static FILE		*stream_fp = NULL;
+static int		stream_failed = FALSE;
+static size_t		stream_nx = 0L, stream_ny = 0L;
+static unsigned char	*stream_buf = NULL;	/* One frame, as it goes out */
+
+static void	stream_close( void );
+
+/*******************************************************************************
+ * Open options.stream_file.  Opening a FIFO waits until something opens
+ * the other end.
+ */
+	void
+stream_open( void )
+{
+	if( strcmp( options.stream_file, "-" ) == 0 ) {
+		stream_fp = fdopen( dup( fileno(stdout) ), "wb" );
+		fflush( stdout );
+		dup2( fileno(stderr), fileno(stdout) );
+		}
+	else
+		stream_fp = fopen( options.stream_file, "wb" );
+	if( stream_fp == NULL ) {
+		fprintf( stderr, "ncview: can't open %s to stream frames to\n", options.stream_file );
+		exit( -1 );
+		}
+	setvbuf( stream_fp, NULL, _IOFBF, STREAM_BUF_BYTES );
+
+	/* If the reader goes away, we find out from fwrite rather than
+	 * being killed
+	 */
+	signal( SIGPIPE, SIG_IGN );
+	atexit( stream_close );
+}
+
+/*******************************************************************************
+ * Send a frame of pixel values out on the stream.  Pixel value i has the
+ * color color_list[i]; there are n_colors entries in color_list.  Returns
+ * -1 if the frame couldn't be sent, in which case no more will be.
+ */
+	int
+stream_frame( unsigned char *data, size_t width, size_t height, XColor *color_list, int n_colors )
+{
+	unsigned char	table[256][3];
+	size_t		i, npix;
+	int		k;
+	float		r, g, b;
+
+	if( (stream_fp == NULL) || stream_failed )
+		return( -1 );
+
+	if( stream_nx == 0L ) {
+		stream_nx  = width;
+		stream_ny  = height;
+		stream_buf = (unsigned char *)malloc( 3*width*height );
+		if( stream_buf == NULL ) {
+			fprintf( stderr, "ncview: can't allocate space to stream %ld x %ld frames\n", width, height );
+			exit( -1 );
+			}
+		if( options.stream_format == STREAM_Y4M )
+			fprintf( stream_fp, "YUV4MPEG2 W%ld H%ld F%d:1 Ip A1:1 C444\n",
+				width, height, options.stream_fps );
+		else
+			fprintf( stderr, "ncview: streaming %ld x %ld frames of raw RGB (rgb24) to %s\n",
+				width, height, options.stream_file );
+		}
+	else if( (width != stream_nx) || (height != stream_ny) ) {
+		fprintf( stderr, "ncview: the image changed size from %ld x %ld to %ld x %ld; the streamed frames\n",
+			stream_nx, stream_ny, width, height );
+		fprintf( stderr, "must all be the same size, so no more will be sent\n" );
+		stream_failed = TRUE;
+		return( -1 );
+		}
+
+	/* What each of the 256 possible pixel values turns into.  Values
+	 * past the end of the color list are black.  The YUV is BT.601,
+	 * limited range.
+	 */
+	for( k=0; k<256; k++ ) {
+		if( k < n_colors ) {
+			r = (float)(color_list[k].red   >> 8);
+			g = (float)(color_list[k].green >> 8);
+			b = (float)(color_list[k].blue  >> 8);
+			}
+		else
+			r = g = b = 0.0;
+		if( options.stream_format == STREAM_Y4M ) {
+			table[k][0] = (unsigned char)( 16.5 + ( 65.481*r + 128.553*g +  24.966*b)/255.0);
+			table[k][1] = (unsigned char)(128.5 + (-37.797*r -  74.203*g + 112.000*b)/255.0);
+			table[k][2] = (unsigned char)(128.5 + (112.000*r -  93.786*g -  18.214*b)/255.0);
+			}
+		else
+			{
+			table[k][0] = (unsigned char)r;
+			table[k][1] = (unsigned char)g;
+			table[k][2] = (unsigned char)b;
+			}
+		}
+
+	npix = width*height;
+	if( options.stream_format == STREAM_Y4M ) {
+		for( i=0; i<npix; i++ ) {
+			stream_buf[i]        = table[data[i]][0];
+			stream_buf[npix+i]   = table[data[i]][1];
+			stream_buf[2*npix+i] = table[data[i]][2];
+			}
+		fputs( "FRAME\n", stream_fp );
+		}
+	else
+		for( i=0; i<npix; i++ ) {
+			stream_buf[3*i]   = table[data[i]][0];
+			stream_buf[3*i+1] = table[data[i]][1];
+			stream_buf[3*i+2] = table[data[i]][2];
+			}
+
+	if( fwrite( stream_buf, 1, 3*npix, stream_fp ) != 3*npix ) {
+		fprintf( stderr, "ncview: error streaming frames to %s; no more will be sent\n", options.stream_file );
+		stream_failed = TRUE;
+		return( -1 );
+		}
+
+	return( 0 );
+}
+
+/*******************************************************************************/
+	static void
+stream_close( void )
+{
+	if( stream_fp != NULL )
+		fclose( stream_fp );
+	stream_fp = NULL;
+}
@@ -0,0 +1,462 @@
+/*
+ * Ncview by David W. Pierce.  A visual netCDF file viewer.
+ * Copyright (C) 1993 through 2010 David W. Pierce
+ *
+ * This program  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License, version 3, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * David W. Pierce
+ * 6259 Caminito Carrena
+ * San Diego, CA  92122
+ * dpierce@ucsd.edu
+ */
+
+/* synth_data: writes made-up netCDF files of whatever size you want, so
+ * that ncview's startup time, frame rate, and min/max scans can be tried
+ * out on big datasets without having to find some.  For example,
+ *
+ *	synth_data -nx 10000 -ny 10000 -nt 10 -o big
+ *	synth_data -nfiles 10000 -nt 10 -o many		(then "ncview many_*.nc")
+ *	synth_data -nvars 5000 -groups 10 -o wide
+ *	synth_data -packed -deflate 4 -chunk 1,256,256 -curvilinear -o packed
+ *
+ * Each variable is a smooth field that moves along with time, with a block
+ * of missing values.  The time axis carries on from one file to the next,
+ * so a set of files made with -nfiles is concatenated along time by
+ * ncview.  The data are written a block of rows at a time, so the grids
+ * can be much bigger than memory.
+ *
+ * This is a separate program that uses only the netCDF library; it isn't
+ * installed.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <sys/time.h>
+
+#include "netcdf.h"
+
+#define MAX_ROW_POINTS	4000000L	/* Most points to write at once */
+#define FILL_F		1.0e20
+#define FILL_S		(-32767)
+#define PACK_SCALE	0.01
+#define PACK_OFFSET	0.0
+
+typedef struct {
+	size_t	nx, ny, nt;	/* Size of the grid, and time steps per file */
+	int	nfiles, nvars, ngroups;
+	int	packed, curvilinear, deflate, shuffle, format;
+	size_t	chunk[3];	/* Time, Y, X; all 0 means the library's default */
+	int	missing_pct;
+	char	*prefix;
+} SynthOptions;
+
+static void	synth_usage( void );
+static void	synth_parse( int argc, char **argv, SynthOptions *so );
+static double	synth_write_file( SynthOptions *so, int ifile, char *fname );
+static void	synth_coords( SynthOptions *so, int ncid, int dim_y, int dim_x );
+static void	synth_fill_rows( SynthOptions *so, float *buf, size_t j0, size_t nrows, size_t t, int ivar,
+			double *sin_x, double *cos_x, double *cos_y );
+static void	synth_check( int err, char *what );
+
+/*******************************************************************************/
+	int
+main( int argc, char **argv )
+{
+	SynthOptions	so;
+	char		fname[2048];
+	int		ifile;
+	double		mb;
+	struct timeval	t0, t1;
+
+	synth_parse( argc, argv, &so );
+
+	gettimeofday( &t0, NULL );
+	mb = 0.0;
+	for( ifile=0; ifile<so.nfiles; ifile++ ) {
+		if( so.nfiles == 1 )
+			snprintf( fname, 2047, "%s.nc", so.prefix );
+		else
+			snprintf( fname, 2047, "%s_%05d.nc", so.prefix, ifile );
+		mb += synth_write_file( &so, ifile, fname );
+		}
+	gettimeofday( &t1, NULL );
+
+	printf( "synth_data: wrote %d file(s), %d variable(s) of %ld x %ld x %ld, %.1f MB of data in %.2f s\n",
+		so.nfiles, so.nvars, (long)so.nx, (long)so.ny, (long)(so.nt*so.nfiles), mb,
+		(t1.tv_sec - t0.tv_sec) + (t1.tv_usec - t0.tv_usec)*1.0e-6 );
+	return( 0 );
+}
+
+/*******************************************************************************/
+	static void
+synth_usage( void )
+{
+fprintf( stderr, "usage: synth_data [options] -o PREFIX\n" );
+fprintf( stderr, "Writes PREFIX.nc, or PREFIX_00000.nc, PREFIX_00001.nc, ... with -nfiles.\n" );
+fprintf( stderr, "	-nx N, -ny N: size of the grid (default 360 x 180)\n" );
+fprintf( stderr, "	-nt N: time steps in each file (default 12)\n" );
+fprintf( stderr, "	-nfiles N: write N files that continue along time (default 1)\n" );
+fprintf( stderr, "	-nvars N: number of variables (default 1)\n" );
+fprintf( stderr, "	-groups N: spread the variables over N groups\n" );
+fprintf( stderr, "	-packed: store shorts with scale_factor and add_offset instead of floats\n" );
+fprintf( stderr, "	-curvilinear: give 2-D lat and lon on a rotated grid instead of 1-D axes\n" );
+fprintf( stderr, "	-missing PCT: about PCT percent of each field is missing (default 10)\n" );
+fprintf( stderr, "	-format classic|64bit|nc4|nc4classic: default nc4\n" );
+fprintf( stderr, "	-chunk T,Y,X: chunk sizes (netCDF-4 formats only)\n" );
+fprintf( stderr, "	-deflate N: compress at level N, 1 to 9 (netCDF-4 formats only)\n" );
+fprintf( stderr, "	-shuffle: use the shuffle filter when compressing\n" );
+exit( -1 );
+}
+
+/*******************************************************************************/
+	static void
+synth_parse( int argc, char **argv, SynthOptions *so )
+{
+	int	i, ok;
+	long	lct, lcy, lcx;
+
+	so->nx          = 360;
+	so->ny          = 180;
+	so->nt          = 12;
+	so->nfiles      = 1;
+	so->nvars       = 1;
+	so->ngroups     = 0;
+	so->packed      = 0;
+	so->curvilinear = 0;
+	so->deflate     = 0;
+	so->shuffle     = 0;
+	so->format      = NC_NETCDF4;
+	so->chunk[0]    = 0;
+	so->chunk[1]    = 0;
+	so->chunk[2]    = 0;
+	so->missing_pct = 10;
+	so->prefix      = NULL;
+
+	for( i=1; i<argc; i++ ) {
+		ok = 1;
+		if( strcmp( argv[i], "-packed" ) == 0 )
+			so->packed = 1;
+		else if( strcmp( argv[i], "-curvilinear" ) == 0 )
+			so->curvilinear = 1;
+		else if( strcmp( argv[i], "-shuffle" ) == 0 )
+			so->shuffle = 1;
+		else if( i == argc-1 )
+			ok = 0;		/* All the rest need a value */
+		else if( strcmp( argv[i], "-nx" ) == 0 )
+			so->nx = atol( argv[++i] );
+		else if( strcmp( argv[i], "-ny" ) == 0 )
+			so->ny = atol( argv[++i] );
+		else if( strcmp( argv[i], "-nt" ) == 0 )
+			so->nt = atol( argv[++i] );
+		else if( strcmp( argv[i], "-nfiles" ) == 0 )
+			so->nfiles = atoi( argv[++i] );
+		else if( strcmp( argv[i], "-nvars" ) == 0 )
+			so->nvars = atoi( argv[++i] );
+		else if( strcmp( argv[i], "-groups" ) == 0 )
+			so->ngroups = atoi( argv[++i] );
+		else if( strcmp( argv[i], "-missing" ) == 0 )
+			so->missing_pct = atoi( argv[++i] );
+		else if( strcmp( argv[i], "-deflate" ) == 0 )
+			so->deflate = atoi( argv[++i] );
+		else if( strcmp( argv[i], "-o" ) == 0 )
+			so->prefix = argv[++i];
+		else if( strcmp( argv[i], "-chunk" ) == 0 ) {
+			if( sscanf( argv[++i], "%ld,%ld,%ld", &lct, &lcy, &lcx ) != 3 ) {
+				fprintf( stderr, "synth_data: -chunk must be followed by T,Y,X, such as 1,256,256\n" );
+				exit( -1 );
+				}
+			so->chunk[0] = lct;
+			so->chunk[1] = lcy;
+			so->chunk[2] = lcx;
+			}
+		else if( strcmp( argv[i], "-format" ) == 0 ) {
+			i++;
+			if( strcmp( argv[i], "classic" ) == 0 )
+				so->format = NC_CLOBBER;
+			else if( strcmp( argv[i], "64bit" ) == 0 )
+				so->format = NC_64BIT_OFFSET;
+			else if( strcmp( argv[i], "nc4" ) == 0 )
+				so->format = NC_NETCDF4;
+			else if( strcmp( argv[i], "nc4classic" ) == 0 )
+				so->format = NC_NETCDF4 | NC_CLASSIC_MODEL;
+			else
+				ok = 0;
+			}
+		else
+			ok = 0;
+
+		if( ! ok ) {
+			fprintf( stderr, "synth_data: don't understand argument \"%s\"\n", argv[i] );
+			synth_usage();
+			}
+		}
+
+	if( so->prefix == NULL )
+		synth_usage();
+	if( (so->nx < 2) || (so->ny < 2) || (so->nt < 1) || (so->nfiles < 1) || (so->nvars < 1) ||
+	    (so->ngroups < 0) || (so->deflate < 0) || (so->deflate > 9) ||
+	    (so->missing_pct < 0) || (so->missing_pct > 100) ) {
+		fprintf( stderr, "synth_data: a size, count, or level is out of range\n" );
+		exit( -1 );
+		}
+	if( ((so->format & NC_NETCDF4) == 0) &&
+	    ((so->ngroups > 0) || (so->deflate > 0) || (so->chunk[0] > 0)) ) {
+		fprintf( stderr, "synth_data: -groups, -deflate and -chunk need -format nc4\n" );
+		exit( -1 );
+		}
+	if( ((so->format & NC_CLASSIC_MODEL) != 0) && (so->ngroups > 0) ) {
+		fprintf( stderr, "synth_data: -groups needs -format nc4\n" );
+		exit( -1 );
+		}
+}
+
+/*******************************************************************************
+ * Write one file; returns the number of MB of data written.
+ */
+	static double
+synth_write_file( SynthOptions *so, int ifile, char *fname )
+{
+	int	ncid, dim_t, dim_y, dim_x, dims[3], varid_t, ivar, grp, *varids, *grpids, err;
+	char	name[NC_MAX_NAME];
+	size_t	t, j0, nrows, rows_per_put, start[3], count[3], k, n;
+	double	tval, *sin_x, *cos_x, *cos_y;
+	float	*buf, fill_f;
+	short	fill_s, *shbuf;
+	float	scale, offset;
+
+	err = nc_create( fname, so->format | NC_CLOBBER, &ncid );
+	synth_check( err, fname );
+
+	synth_check( nc_def_dim( ncid, "time", NC_UNLIMITED, &dim_t ), "def_dim time" );
+	synth_check( nc_def_dim( ncid, so->curvilinear ? "y" : "lat", so->ny, &dim_y ), "def_dim y" );
+	synth_check( nc_def_dim( ncid, so->curvilinear ? "x" : "lon", so->nx, &dim_x ), "def_dim x" );
+
+	synth_check( nc_def_var( ncid, "time", NC_DOUBLE, 1, &dim_t, &varid_t ), "def_var time" );
+	synth_check( nc_put_att_text( ncid, varid_t, "units", 30, "days since 2000-01-01 00:00:00" ), "time units" );
+	synth_check( nc_put_att_text( ncid, varid_t, "calendar", 8, "standard" ), "time calendar" );
+	synth_coords( so, ncid, dim_y, dim_x );
+
+	/* Groups, if any, hang off the root; the dimensions and coordinates
+	 * in the root group are seen from inside them
+	 */
+	grpids = (int *)malloc( (so->ngroups > 0 ? so->ngroups : 1)*sizeof(int) );
+	varids = (int *)malloc( so->nvars*sizeof(int) );
+	for( grp=0; grp<so->ngroups; grp++ ) {
+		snprintf( name, NC_MAX_NAME-1, "group%d", grp );
+		synth_check( nc_def_grp( ncid, name, grpids+grp ), name );
+		}
+
+	dims[0] = dim_t;
+	dims[1] = dim_y;
+	dims[2] = dim_x;
+	fill_f  = FILL_F;
+	fill_s  = FILL_S;
+	scale   = PACK_SCALE;
+	offset  = PACK_OFFSET;
+	for( ivar=0; ivar<so->nvars; ivar++ ) {
+		grp = (so->ngroups > 0) ? grpids[ivar % so->ngroups] : ncid;
+		snprintf( name, NC_MAX_NAME-1, "var%05d", ivar );
+		synth_check( nc_def_var( grp, name, so->packed ? NC_SHORT : NC_FLOAT, 3, dims, varids+ivar ), name );
+		if( so->packed ) {
+			synth_check( nc_put_att_short( grp, varids[ivar], "_FillValue", NC_SHORT, 1, &fill_s ), "_FillValue" );
+			synth_check( nc_put_att_float( grp, varids[ivar], "scale_factor", NC_FLOAT, 1, &scale ), "scale_factor" );
+			synth_check( nc_put_att_float( grp, varids[ivar], "add_offset", NC_FLOAT, 1, &offset ), "add_offset" );
+			}
+		else
+			synth_check( nc_put_att_float( grp, varids[ivar], "_FillValue", NC_FLOAT, 1, &fill_f ), "_FillValue" );
+		if( so->curvilinear )
+			synth_check( nc_put_att_text( grp, varids[ivar], "coordinates", 7, "lon lat" ), "coordinates" );
+		if( so->chunk[0] > 0 )
+			synth_check( nc_def_var_chunking( grp, varids[ivar], NC_CHUNKED, so->chunk ), "chunking" );
+		if( so->deflate > 0 )
+			synth_check( nc_def_var_deflate( grp, varids[ivar], so->shuffle, 1, so->deflate ), "deflate" );
+		}
+	synth_check( nc_enddef( ncid ), "enddef" );
+
+	/* Time carries on from the previous file */
+	for( t=0; t<so->nt; t++ ) {
+		start[0] = t;
+		tval     = (double)(ifile*so->nt + t);
+		synth_check( nc_put_var1_double( ncid, varid_t, start, &tval ), "put time" );
+		}
+
+	sin_x = (double *)malloc( so->nx*sizeof(double) );
+	cos_x = (double *)malloc( so->nx*sizeof(double) );
+	cos_y = (double *)malloc( so->ny*sizeof(double) );
+	for( k=0; k<so->nx; k++ ) {
+		sin_x[k] = sin( 6.0*M_PI*k/so->nx );
+		cos_x[k] = cos( 6.0*M_PI*k/so->nx );
+		}
+	for( k=0; k<so->ny; k++ )
+		cos_y[k] = cos( 2.0*M_PI*k/so->ny );
+
+	rows_per_put = MAX_ROW_POINTS / so->nx;
+	if( rows_per_put < 1 )
+		rows_per_put = 1;
+	if( rows_per_put > so->ny )
+		rows_per_put = so->ny;
+	buf   = (float *)malloc( rows_per_put*so->nx*sizeof(float) );
+	shbuf = (short *)malloc( (so->packed ? rows_per_put*so->nx : 1)*sizeof(short) );
+	if( (buf == NULL) || (shbuf == NULL) || (sin_x == NULL) || (cos_x == NULL) || (cos_y == NULL) ) {
+		fprintf( stderr, "synth_data: can't allocate space for %ld rows of %ld\n",
+			(long)rows_per_put, (long)so->nx );
+		exit( -1 );
+		}
+
+	for( ivar=0; ivar<so->nvars; ivar++ ) {
+		grp = (so->ngroups > 0) ? grpids[ivar % so->ngroups] : ncid;
+		for( t=0; t<so->nt; t++ )
+		for( j0=0; j0<so->ny; j0+=rows_per_put ) {
+			nrows = (j0 + rows_per_put > so->ny) ? so->ny - j0 : rows_per_put;
+			synth_fill_rows( so, buf, j0, nrows, ifile*so->nt + t, ivar, sin_x, cos_x, cos_y );
+			start[0] = t;	count[0] = 1;
+			start[1] = j0;	count[1] = nrows;
+			start[2] = 0;	count[2] = so->nx;
+			if( so->packed ) {
+				n = nrows*so->nx;
+				for( k=0; k<n; k++ )
+					shbuf[k] = (buf[k] == fill_f) ? FILL_S :
+						(short)floor( (buf[k] - PACK_OFFSET)/PACK_SCALE + 0.5 );
+				synth_check( nc_put_vara_short( grp, varids[ivar], start, count, shbuf ), "put data" );
+				}
+			else
+				synth_check( nc_put_vara_float( grp, varids[ivar], start, count, buf ), "put data" );
+			}
+		}
+
+	synth_check( nc_close( ncid ), "close" );
+
+	free( buf );
+	free( shbuf );
+	free( sin_x );
+	free( cos_x );
+	free( cos_y );
+	free( grpids );
+	free( varids );
+
+	return( (double)so->nvars * so->nt * so->nx * so->ny * (so->packed ? 2 : 4) / (1024.0*1024.0) );
+}
+
+/*******************************************************************************
+ * The coordinates: 1-D lat and lon, or 2-D ones on a grid rotated by 30
+ * degrees with -curvilinear.
+ */
+	static void
+synth_coords( SynthOptions *so, int ncid, int dim_y, int dim_x )
+{
+	int	varid_lat, varid_lon, dims[2];
+	size_t	i, j, start[2], count[2];
+	float	*lat, *lon, x, y, rot;
+
+	if( ! so->curvilinear ) {
+		synth_check( nc_def_var( ncid, "lat", NC_FLOAT, 1, &dim_y, &varid_lat ), "def_var lat" );
+		synth_check( nc_def_var( ncid, "lon", NC_FLOAT, 1, &dim_x, &varid_lon ), "def_var lon" );
+		}
+	else
+		{
+		dims[0] = dim_y;
+		dims[1] = dim_x;
+		synth_check( nc_def_var( ncid, "lat", NC_FLOAT, 2, dims, &varid_lat ), "def_var lat" );
+		synth_check( nc_def_var( ncid, "lon", NC_FLOAT, 2, dims, &varid_lon ), "def_var lon" );
+		}
+	synth_check( nc_put_att_text( ncid, varid_lat, "units", 13, "degrees_north" ), "lat units" );
+	synth_check( nc_put_att_text( ncid, varid_lon, "units", 12, "degrees_east" ), "lon units" );
+
+	/* Have to leave define mode to write them, then go back */
+	synth_check( nc_enddef( ncid ), "enddef" );
+
+	if( ! so->curvilinear ) {
+		lat = (float *)malloc( so->ny*sizeof(float) );
+		lon = (float *)malloc( so->nx*sizeof(float) );
+		for( j=0; j<so->ny; j++ )
+			lat[j] = -90.0 + 180.0*(j + 0.5)/so->ny;
+		for( i=0; i<so->nx; i++ )
+			lon[i] = 360.0*(i + 0.5)/so->nx;
+		synth_check( nc_put_var_float( ncid, varid_lat, lat ), "put lat" );
+		synth_check( nc_put_var_float( ncid, varid_lon, lon ), "put lon" );
+		}
+	else
+		{
+		/* A row at a time, so this works for big grids too */
+		lat = (float *)malloc( so->nx*sizeof(float) );
+		lon = (float *)malloc( so->nx*sizeof(float) );
+		rot = 30.0*M_PI/180.0;
+		for( j=0; j<so->ny; j++ ) {
+			for( i=0; i<so->nx; i++ ) {
+				x = 60.0*((float)i/(so->nx-1) - 0.5);
+				y = 40.0*((float)j/(so->ny-1) - 0.5);
+				lon[i] = 200.0 + x*cos(rot) - y*sin(rot);
+				lat[i] =  30.0 + x*sin(rot) + y*cos(rot);
+				}
+			start[0] = j;	count[0] = 1;
+			start[1] = 0;	count[1] = so->nx;
+			synth_check( nc_put_vara_float( ncid, varid_lat, start, count, lat ), "put lat" );
+			synth_check( nc_put_vara_float( ncid, varid_lon, start, count, lon ), "put lon" );
+			}
+		}
+	free( lat );
+	free( lon );
+
+	synth_check( nc_redef( ncid ), "redef" );
+}
+
+/*******************************************************************************
+ * Rows j0 through j0+nrows-1 of variable ivar at (overall) time step t.
+ * The field is a pattern of highs and lows that drifts east with time, so
+ * every frame is different; a block of about missing_pct percent of the
+ * points, which drifts too, is missing.
+ */
+	static void
+synth_fill_rows( SynthOptions *so, float *buf, size_t j0, size_t nrows, size_t t, int ivar,
+		double *sin_x, double *cos_x, double *cos_y )
+{
+	size_t	i, j, miss_x0, miss_nx, miss_y0, miss_ny;
+	double	phase, sp, cp, amp;
+	float	*row;
+
+	phase = 0.1*t + 0.7*ivar;
+	sp    = sin( phase );
+	cp    = cos( phase );
+	amp   = 10.0 + ivar%7;
+
+	/* The missing block is half as tall as the grid */
+	miss_ny = so->ny/2;
+	miss_nx = (size_t)((2.0*so->missing_pct/100.0) * so->nx);
+	if( miss_nx > so->nx )
+		miss_nx = so->nx;
+	miss_y0 = so->ny/4;
+	miss_x0 = (t*so->nx/50) % so->nx;
+
+	for( j=j0; j<j0+nrows; j++ ) {
+		row = buf + (j-j0)*so->nx;
+		for( i=0; i<so->nx; i++ )
+			/* sin(kx + phase) = sin(kx)cos(phase) + cos(kx)sin(phase) */
+			row[i] = amp*(sin_x[i]*cp + cos_x[i]*sp)*cos_y[j] + (5.0*j)/so->ny;
+		if( (miss_nx > 0) && (j >= miss_y0) && (j < miss_y0 + miss_ny) )
+			for( i=0; i<miss_nx; i++ )
+				row[ (miss_x0 + i) % so->nx ] = FILL_F;
+		}
+}
+
+/*******************************************************************************/
+	static void
+synth_check( int err, char *what )
+{
+	if( err == NC_NOERR )
+		return;
+	fprintf( stderr, "synth_data: error (%s): %s\n", what, nc_strerror( err ));
+	exit( -1 );
+}
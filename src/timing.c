@@ -0,0 +1,259 @@
+/*
+ * Ncview by David W. Pierce.  A visual netCDF file viewer.
+ * Copyright (C) 1993 through 2010 David W. Pierce
+ *
+ * This program  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License, version 3, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * David W. Pierce
+ * 6259 Caminito Carrena
+ * San Diego, CA  92122
+ * dpierce@ucsd.edu
+ */
+
+/* Frame timing (the "-timing" option).  Each stage of making a frame
+ * (reading the data, applying scale_factor and add_offset, blowing it up
+ * or shrinking it, turning it into color levels, and so on) is timed, and
+ * the times for the last TIMING_WINDOW frames are kept.  The averages and
+ * 95th percentiles go on a line of their own under the image, and every
+ * so often a table with more detail is printed to stderr.
+ *
+ * A frame runs from timing_frame_start() to timing_frame_end(), both
+ * called from view_draw (or, with -bench, from bench_run).  A stage can
+ * be started and stopped several times in a frame; the times add up.
+ * Stages that run outside of a frame (for example, reading data to
+ * pre-render frames) aren't counted.
+ *
+ * Drawing to the X server is normally asynchronous, so with -timing we
+ * wait for the server to finish each image (see x_draw_2d_field_region).
+ * Otherwise the "put" time would just be the time to queue the request.
+ */
+
+#include "ncview.includes.h"
+#include "ncview.defines.h"
+#include "ncview.protos.h"
+
+#define TIMING_WINDOW		128	/* Frames in the rolling statistics */
+#define TIMING_HUD_MS		500.0	/* How often to redo the line under the image */
+#define TIMING_REPORT_MS	5000.0	/* How often to print the table to stderr */
+
+extern Options	options;
+
+static char *timing_stage_name[TIMING_N_STAGES] = {
+	"read", "scale", "resample", "quantize", "overlay", "store", "truecolor", "put" };
+
+static int		timing_in_frame = FALSE;
+static struct timeval	timing_frame_t0, timing_stage_t0[TIMING_N_STAGES],
+			timing_hud_time, timing_report_time;
+static double		timing_cur[TIMING_N_STAGES];	/* ms so far in this frame */
+
+/* Ring of the last TIMING_WINDOW frames; the last slot of each row is
+ * the time for the whole frame
+ */
+static float		timing_hist[TIMING_WINDOW][TIMING_N_STAGES+1];
+static long		timing_n_frames = 0L;		/* Total frames timed */
+static long		timing_n_since_report = 0L;
+
+static void	timing_stats( int stage, float *avg, float *p50, float *p95, float *max );
+static int	timing_compare_float( const void *p1, const void *p2 );
+static void	timing_update_hud( void );
+static void	timing_report( void );
+
+/*******************************************************************************/
+	void
+timing_frame_start( void )
+{
+	int	i;
+
+	if( ! options.timing )
+		return;
+
+	for( i=0; i<TIMING_N_STAGES; i++ )
+		timing_cur[i] = 0.0;
+	gettimeofday( &timing_frame_t0, NULL );
+	timing_in_frame = TRUE;
+}
+
+/*******************************************************************************
+ * The frame is on the screen; save its times.
+ */
+	void
+timing_frame_end( void )
+{
+	int	i, slot;
+
+	if( (! options.timing) || (! timing_in_frame) )
+		return;
+	timing_in_frame = FALSE;
+
+	slot = timing_n_frames % TIMING_WINDOW;
+	for( i=0; i<TIMING_N_STAGES; i++ )
+		timing_hist[slot][i] = timing_cur[i];
+	timing_hist[slot][TIMING_N_STAGES] = ms_since( &timing_frame_t0 );
+
+	if( timing_n_frames == 0L ) {
+		gettimeofday( &timing_report_time, NULL );
+		timing_hud_time = timing_report_time;
+		}
+	timing_n_frames++;
+	timing_n_since_report++;
+
+	/* With -bench there's no display, and bench.c reports the times */
+	if( options.bench )
+		return;
+
+	if( (timing_n_frames == 1L) || (ms_since( &timing_hud_time ) >= TIMING_HUD_MS) ) {
+		timing_update_hud();
+		gettimeofday( &timing_hud_time, NULL );
+		}
+
+	if( ms_since( &timing_report_time ) >= TIMING_REPORT_MS ) {
+		timing_report();
+		timing_n_since_report = 0L;
+		gettimeofday( &timing_report_time, NULL );
+		}
+}
+
+/*******************************************************************************
+ * Times of the frame that was just finished, in ms.  'ms' must have room
+ * for TIMING_N_STAGES+1 values; the last is the time for the whole frame.
+ */
+	void
+timing_last_frame( float *ms )
+{
+	int	i, slot;
+
+	slot = (timing_n_frames + TIMING_WINDOW - 1) % TIMING_WINDOW;
+	for( i=0; i<=TIMING_N_STAGES; i++ )
+		ms[i] = timing_hist[slot][i];
+}
+
+/*******************************************************************************/
+	char *
+timing_stage_name_of( int stage )
+{
+	if( stage == TIMING_N_STAGES )
+		return( "frame" );
+	return( timing_stage_name[stage] );
+}
+
+/*******************************************************************************/
+	void
+timing_start( int stage )
+{
+	if( options.timing && timing_in_frame )
+		gettimeofday( timing_stage_t0+stage, NULL );
+}
+
+/*******************************************************************************/
+	void
+timing_stop( int stage )
+{
+	if( options.timing && timing_in_frame )
+		timing_cur[stage] += ms_since( timing_stage_t0+stage );
+}
+
+/*******************************************************************************
+ * Statistics of one stage (or the whole frame, if stage is TIMING_N_STAGES)
+ * over the frames we have, in ms.
+ */
+	static void
+timing_stats( int stage, float *avg, float *p50, float *p95, float *max )
+{
+	float	sorted[TIMING_WINDOW];
+	long	n, i;
+	double	sum;
+
+	n = (timing_n_frames < TIMING_WINDOW) ? timing_n_frames : TIMING_WINDOW;
+	for( i=0; i<n; i++ )
+		sorted[i] = timing_hist[i][stage];
+	timing_summarize( sorted, n, &sum, avg, p50, p95, max );
+}
+
+/*******************************************************************************
+ * The total, average, median, 95th percentile, and largest of the n times
+ * in ms (n must be at least 1).  ms is sorted in place.  This is also used
+ * by bench.c for its per-stage lines.
+ */
+	void
+timing_summarize( float *ms, long n, double *sum, float *avg, float *p50, float *p95, float *max )
+{
+	long	i;
+
+	*sum = 0.0;
+	for( i=0; i<n; i++ )
+		*sum += ms[i];
+	qsort( ms, n, sizeof(float), timing_compare_float );
+
+	*avg = *sum/(double)n;
+	*p50 = ms[ n/2 ];
+	*p95 = ms[ (95*(n-1))/100 ];
+	*max = ms[ n-1 ];
+}
+
+/*******************************************************************************/
+	static int
+timing_compare_float( const void *p1, const void *p2 )
+{
+	float	f1, f2;
+
+	f1 = *(float *)p1;
+	f2 = *(float *)p2;
+	if( f1 < f2 )
+		return( -1 );
+	if( f1 > f2 )
+		return( 1 );
+	return( 0 );
+}
+
+/*******************************************************************************
+ * Put the averages and 95th percentiles on the line under the image
+ */
+	static void
+timing_update_hud( void )
+{
+	char	hud[1024], *s;
+	int	i;
+	float	avg, p50, p95, max;
+
+	timing_stats( TIMING_N_STAGES, &avg, &p50, &p95, &max );
+	snprintf( hud, 1023, "ms avg/95%%: frame %.1f/%.1f", avg, p95 );
+	for( i=0; i<TIMING_N_STAGES; i++ ) {
+		timing_stats( i, &avg, &p50, &p95, &max );
+		if( p95 < 0.05 )	/* Leave out stages that aren't doing anything */
+			continue;
+		s = hud + strlen(hud);
+		snprintf( s, 1023-(s-hud), "  %s %.1f/%.1f", timing_stage_name[i], avg, p95 );
+		}
+
+	in_set_label( LABEL_TIMING, hud );
+}
+
+/*******************************************************************************/
+	static void
+timing_report( void )
+{
+	int	i;
+	long	n;
+	float	avg, p50, p95, max;
+
+	n = (timing_n_frames < TIMING_WINDOW) ? timing_n_frames : TIMING_WINDOW;
+	fprintf( stderr, "ncview timing: %ld frames in the last %.1f s; ms over the last %ld frames:\n",
+		timing_n_since_report, ms_since( &timing_report_time )/1000.0, n );
+	fprintf( stderr, "    %-10s %8s %8s %8s %8s\n", "stage", "avg", "p50", "p95", "max" );
+	for( i=0; i<=TIMING_N_STAGES; i++ ) {
+		timing_stats( i, &avg, &p50, &p95, &max );
+		fprintf( stderr, "    %-10s %8.2f %8.2f %8.2f %8.2f\n",
+			timing_stage_name_of( i ), avg, p50, p95, max );
+		}
+}
@@ -0,0 +1,142 @@
+/*
+ * Ncview by David W. Pierce.  A visual netCDF file viewer.
+ * Copyright (C) 1993 through 2010 David W. Pierce
+ *
+ * This program  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License, version 3, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * David W. Pierce
+ * 6259 Caminito Carrena
+ * San Diego, CA  92122
+ * dpierce@ucsd.edu
+ */
+
+/* Event trace (the "-trace file.json" option).  Writes a begin and an end
+ * event for each X event handled, timer and work procedure called, file
+ * read, and so on, in the "Trace Event" JSON format that chrome://tracing
+ * and Perfetto read.  This shows where the program spent its time without
+ * having to turn on -debug.
+ *
+ * Everything traced happens in the main thread.  Events are written (and
+ * flushed) as they happen.  The closing "]" is written at exit, but the
+ * trace viewers don't need it, so a trace from a session that crashed can
+ * still be read.
+ */
+
+#include "ncview.includes.h"
+#include "ncview.defines.h"
+#include "ncview.protos.h"
+
+static FILE		*trace_file = NULL;
+static struct timeval	trace_t0;
+static int		trace_pid;
+static long		trace_n_events = 0L;
+
+static void	trace_event( char *name, char *category, char *phase, char *detail );
+static void	trace_write_string( char *s );
+static void	trace_close( void );
+
+/*******************************************************************************/
+	void
+trace_open( char *fname )
+{
+	if( (trace_file = fopen( fname, "w" )) == NULL ) {
+		fprintf( stderr, "ncview: can't open trace file \"%s\" for writing\n", fname );
+		exit( -1 );
+		}
+
+	gettimeofday( &trace_t0, NULL );
+	trace_pid = (int)getpid();
+	fprintf( trace_file, "[\n" );
+	atexit( trace_close );
+}
+
+/*******************************************************************************
+ * Start of something we want to see in the trace.  'category' groups
+ * things together in the viewer; 'detail' (a file name, variable name,
+ * and so on) can be NULL.
+ */
+	void
+trace_begin( char *name, char *category, char *detail )
+{
+	if( trace_file != NULL )
+		trace_event( name, category, "B", detail );
+}
+
+/*******************************************************************************/
+	void
+trace_end( char *name, char *category )
+{
+	if( trace_file != NULL )
+		trace_event( name, category, "E", NULL );
+}
+
+/*******************************************************************************/
+	static void
+trace_event( char *name, char *category, char *phase, char *detail )
+{
+	struct timeval	now;
+	double		ts;
+
+	gettimeofday( &now, NULL );
+	ts = (now.tv_sec - trace_t0.tv_sec)*1.0e6 + (now.tv_usec - trace_t0.tv_usec);
+
+	if( trace_n_events++ > 0 )
+		fprintf( trace_file, ",\n" );
+	fprintf( trace_file, "{\"name\":" );
+	trace_write_string( name );
+	fprintf( trace_file, ",\"cat\":" );
+	trace_write_string( category );
+	fprintf( trace_file, ",\"ph\":\"%s\",\"ts\":%.0f,\"pid\":%d,\"tid\":1", phase, ts, trace_pid );
+	if( detail != NULL ) {
+		fprintf( trace_file, ",\"args\":{\"detail\":" );
+		trace_write_string( detail );
+		fprintf( trace_file, "}" );
+		}
+	fprintf( trace_file, "}" );
+
+	/* So the events so far are in the file if we crash */
+	fflush( trace_file );
+}
+
+/*******************************************************************************
+ * Write a string as a quoted JSON string
+ */
+	static void
+trace_write_string( char *s )
+{
+	putc( '"', trace_file );
+	for( ; *s != '\0'; s++ ) {
+		if( (*s == '"') || (*s == '\\') )
+			fprintf( trace_file, "\\%c", *s );
+		else if( (unsigned char)*s < ' ' )
+			fprintf( trace_file, "\\u%04x", (unsigned char)*s );
+		else
+			putc( *s, trace_file );
+		}
+	putc( '"', trace_file );
+}
+
+/*******************************************************************************
+ * Called at exit.  Makes the file valid JSON, which other tools need.
+ */
+	static void
+trace_close( void )
+{
+	if( trace_file == NULL )
+		return;
+
+	fprintf( trace_file, "\n]\n" );
+	fclose( trace_file );
+	trace_file = NULL;
+}
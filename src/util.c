@@ -46,6 +46,41 @@ extern ut_system *unitsys;
 #endif 
 /*-------------------*/
 
+/* Working space for util_mode, so that it doesn't have to allocate any */
+#define MODE_HIST_SIZE	4096
+typedef struct {
+	long	val, idx;
+} ModePair;
+
+typedef struct {
+	long	 *ivals;	/* the values, rounded to integers */
+	ModePair *pairs;	/* for sorting, when there are too many values for a histogram */
+	int	 *hist;		/* MODE_HIST_SIZE counts; always left all zeros */
+} ModeScratch;
+
+/* What the threads doing the rows of a shrunken field need to know */
+typedef struct {
+	View	*v;
+	float	*small_data, *src, fill_value;
+	long	n, f, interior_nx, interior_ny;
+	size_t	new_nx, src_nx;
+} ContractInfo;
+
+/* What the threads doing the rows of a zoomed image need to know.  For
+ * pixel column i of the region being drawn, the data columns used are
+ * ix0[i] and ix1[i], with weight wx[i] on ix1[i] (for bilinear filtering),
+ * or ix0[i] through ix1[i]-1 (for box filtering).  The source is either
+ * the data itself, or (if is_levels) a frame of color levels that was
+ * saved at data resolution; see levels_to_pixels().
+ */
+typedef struct {
+	View	*v;
+	int	filter, is_levels;
+	size_t	nx, ny, new_nx, new_ny, px0, py0, pnx;
+	long	*ix0, *ix1;
+	float	*data, *wx, fill_value, data_range;
+} ZoomInfo;
+
 extern Options   options;
 extern NCVar     *variables;
 extern ncv_pixel *pixel_transform;
@@ -54,8 +89,24 @@ extern FrameStore framestore;
 static void handle_time_dim( int fileid, NCVar *v, int dimid );
 static int  months_calc_tgran( int fileid, NCDim *d );
 static float util_mean( float *x, size_t n, float fill_value );
-static float util_mode( float *x, size_t n, float fill_value );
-static void contract_data( float *small_data, View *v, float fill_value );
+static float util_mode( float *x, size_t n, float fill_value, ModeScratch *ms );
+static int mode_pair_compare( const void *p1, const void *p2 );
+static ModeScratch *new_mode_scratch( size_t n );
+static void free_mode_scratch( ModeScratch *ms );
+static void contract_rows( long first, long last, void *arg );
+static float contract_square( View *v, long n, long i, long j, float *tmpv, ModeScratch *ms, float fill_value );
+static ShrinkLevel *get_mean_pyramid_level( View *v, long factor, float fill_value );
+static ShrinkLevel *find_shrink_level( View *v, int factor, int method );
+static ShrinkLevel *add_shrink_level( View *v, int factor, int method, size_t nx, size_t ny );
+static void expand_data_region( float *region_data, View *v, size_t x0, size_t y0, size_t nx, size_t ny );
+static void zoom_data_to_pixels( View *v, size_t px0, size_t py0, size_t pnx, size_t pny, float data_range );
+static void resample_to_pixels( ZoomInfo *zi, size_t pny );
+static int  resample_filter( void );
+static void zoom_rows( long first, long last, void *arg );
+static void zoom_source_range( int filter, size_t pix, size_t n, size_t new_n, long *i0, long *i1, float *w );
+static ncv_pixel data_to_pixel_value( View *v, float rawdata, float fill_value, float data_range );
+static ncv_pixel level_to_pixel_value( ncv_pixel level );
+static ncv_pixel data_to_level_value( View *v, float rawdata, float fill_value, float data_range );
 static int equivalent_FDBs( NCVar *v1, NCVar *v2 );
 static int data_has_mv( float *data, size_t n, float fill_value );
 static void handle_dim_mapping( NCVar *v );
@@ -64,6 +115,8 @@ static void handle_dim_mapping_2d( NCVar *v, char *coord_var_name, char *coord_a
 	size_t *coord_var_eff_size, int coord_var_neff_dims, char *orig_coord_att,
 	int ncid );
 static int  determine_lat_lon( char *s_in, int *is_lat, int *is_lon );
+static long point_index_bin( PointIndex *pi, float x, float y );
+static void point_index_bin_xy( PointIndex *pi, float x, float y, long *bx, long *by );
 
 /* Variables local to routines in this file */
 static  char    *month_name[12] = { "Jan", "Feb", "Mar", "Apr", "May", "Jun",
@@ -199,15 +252,16 @@ data_has_mv( float *data, size_t n, float fill_value )
  * Scale the data, replicate it, and convert to a pixel type array.  I'm afraid
  * that for speed, this considers 'ncv_pixel' to be a single byte value.  Make sure
  * to change it if you change the definition of ncv_pixel!  Returns 0 on
- * success, -1 on failure.
+ * success, -1 on failure.  If v->render_nx is not 0, only the region of
+ * v->pixels given by v->render_* is filled in (this is only done when the
+ * data is being blown up, or zoomed by a non-integer factor).
  */
 	int
 data_to_pixels( View *v )
 {
 	long	i, j, j2;
-	size_t	x_size, y_size, new_x_size, new_y_size;
-	ncv_pixel pix_val;
-	float	data_range, rawdata, data, fill_value, *scaled_data;
+	size_t	x_size, y_size, new_x_size, new_y_size, px0, py0, pnx, pny, sy0;
+	float	data_range, fill_value, *scaled_data;
 	long	blowup, result, orig_minmax_method;
 	char	error_message[1024];
 
@@ -226,36 +280,61 @@ data_to_pixels( View *v )
 
 	view_get_scaled_size( options.blowup, x_size, y_size, &new_x_size, &new_y_size );
 
-	scaled_data   = (float *)malloc( new_x_size*new_y_size*sizeof(float));
-	if( scaled_data == NULL ) {
+	/* Region of the pixel array to fill in.  Pixel rows are flipped
+	 * relative to the data unless invert_physical is set, so the rows
+	 * of the scaled data we need (starting at sy0) are different.
+	 */
+	if( (v->render_nx == 0) || ((blowup <= 1) && (options.zoom == 0.0)) ) {
+		px0 = 0L;
+		py0 = 0L;
+		pnx = new_x_size;
+		pny = new_y_size;
+		}
+	else
+		{
+		px0 = v->render_x0;
+		py0 = v->render_y0;
+		pnx = v->render_nx;
+		pny = v->render_ny;
+		}
+	if( options.invert_physical )
+		sy0 = py0;
+	else
+		sy0 = new_y_size - py0 - pny;
+
+	/* A non-integer zoom goes straight from the data to the pixels */
+	if( options.zoom > 0.0 )
+		scaled_data = NULL;
+	else
+		scaled_data = (float *)malloc( pnx*pny*sizeof(float));
+	if( (scaled_data == NULL) && (options.zoom == 0.0) ) {
 		fprintf( stderr, "ncview: data_to_pixels: can't allocate data expansion array\n" );
-		fprintf( stderr, "requested size: %ld bytes\n", new_x_size*new_y_size*sizeof(float) );
+		fprintf( stderr, "requested size: %ld bytes\n", pnx*pny*sizeof(float) );
 		fprintf( stderr, "new_x_size, new_y_size, float_size: %ld %ld %ld\n", 
 				new_x_size, new_y_size, sizeof(float) );
 		fprintf( stderr, "blowup: %d\n", options.blowup );
 		exit( -1 );
 		}
 
-	/* If we are doing overlays, implement them */
-	if( options.overlay->doit && (options.overlay->overlay != NULL)) {
-		for( i=0; i<(x_size*y_size); i++ ) {
-			*((float *)v->data + i) = 
-			     (float)(1 - *(options.overlay->overlay+i)) * *((float *)v->data + i) +
-			     (float)(*(options.overlay->overlay+i)) * v->variable->fill_value;
-			}
-		}
-
 	fill_value = v->variable->fill_value;
 
-	if( blowup > 0 ) {
+	timing_start( TIMING_RESAMPLE );
+	if( options.zoom > 0.0 ) {
+		if( options.debug ) printf( "..zooming data, zoom=%g\n", options.zoom );
+		}
+	else if( blowup > 0 ) {
 		if( options.debug ) printf( "..expanding data, blowup=%ld\n", blowup );
-		expand_data( scaled_data, v, new_x_size*new_y_size );
+		if( (pnx == new_x_size) && (pny == new_y_size) )
+			expand_data( scaled_data, v, new_x_size*new_y_size );
+		else
+			expand_data_region( scaled_data, v, px0, sy0, pnx, pny );
 		}
 	else
 		{
 		if( options.debug ) printf( "..contracting data, blowup=%ld\n", blowup );
 		contract_data( scaled_data, v, fill_value );
 		}
+	timing_stop( TIMING_RESAMPLE );
 
 	data_range = v->variable->user_max - v->variable->user_min;
 
@@ -279,7 +358,9 @@ data_to_pixels( View *v )
 		if( result == MESSAGE_OK ) {
 			orig_minmax_method = options.min_max_method;
 			options.min_max_method = MIN_MAX_METHOD_EXHAUST;
+			trace_begin( "init_min_max", "compute", v->variable->name );
 			init_min_max( v->variable );
+			trace_end( "init_min_max", "compute" );
 			options.min_max_method = orig_minmax_method;
 			if( (v->variable->user_max == 0) &&
 	    		    (v->variable->user_min == 0) ) {
@@ -324,46 +405,400 @@ data_to_pixels( View *v )
 			v->variable->user_max = 0;
 	    	}
 
-	for( j=0; j<new_y_size; j++ ) {
+	/* Zooming goes straight to the pixels, so resampling and turning
+	 * the data into color levels can't be timed separately
+	 */
+	if( options.zoom > 0.0 ) {
+		timing_start( TIMING_RESAMPLE );
+		zoom_data_to_pixels( v, px0, py0, pnx, pny, data_range );
+		timing_stop( TIMING_RESAMPLE );
+		timing_start( TIMING_OVERLAY );
+		overlay_pixels( v, px0, py0, pnx, pny );
+		timing_stop( TIMING_OVERLAY );
+		return( 0 );
+		}
+
+	timing_start( TIMING_QUANTIZE );
+	for( j=0; j<pny; j++ ) {
 
 		if( options.invert_physical )
 			j2 = j;
 		else
-			j2 = new_y_size - j - 1;
+			j2 = pny - j - 1;
+
+		for( i=0; i<pnx; i++ ) 
+			*(v->pixels + (px0+i) + (py0+j)*new_x_size) = 
+				data_to_pixel_value( v, *(scaled_data + i + j2*pnx), fill_value, data_range );
+		}
+
+	timing_stop( TIMING_QUANTIZE );
+
+	free( scaled_data );
+
+	/* Overlays go on last, so they don't touch the data */
+	timing_start( TIMING_OVERLAY );
+	overlay_pixels( v, px0, py0, pnx, pny );
+	timing_stop( TIMING_OVERLAY );
+
+	return( 0 );
+}
+
+/******************************************************************************
+ * Convert one (scaled) data value to the pixel value that shows it.
+ */
+	static ncv_pixel
+data_to_pixel_value( View *v, float rawdata, float fill_value, float data_range )
+{
+	return( level_to_pixel_value( data_to_level_value( v, rawdata, fill_value, data_range )));
+}
+
+/******************************************************************************
+ * Convert a color level (see data_to_level_value) to the pixel value that
+ * shows it.
+ */
+	static ncv_pixel
+level_to_pixel_value( ncv_pixel level )
+{
+	if( (level == 0) || (options.display_type == PseudoColor) )
+		return( *(pixel_transform+level) );
+	return( level );
+}
+
+/******************************************************************************
+ * Convert one data value to its color level: 0 for missing, or 
+ * options.n_extra_colors and up for the colors in the colormap.  This is
+ * the pixel value itself except on PseudoColor displays, where it still
+ * has to go through pixel_transform.
+ */
+	static ncv_pixel
+data_to_level_value( View *v, float rawdata, float fill_value, float data_range )
+{
+	ncv_pixel pix_val;
+	float	data;
+
+	if( close_enough(rawdata, fill_value) || (rawdata == FILL_FLOAT))
+		return( 0 );
+
+	data = (rawdata - v->variable->user_min) / data_range;
+	clip_f( &data, 0.0, .9999 );
+	switch( options.transform ) {
+		case TRANSFORM_NONE:	break;
+
+		/* This might cause problems.  It is at odds with what
+		 * the manual claims--at least for Ultrix--but works, 
+		 * whereas what the manual claims works, doesn't!
+		 */
+		case TRANSFORM_LOW:	data = sqrt( data );  
+					data = sqrt( data );
+					break;
+
+		case TRANSFORM_HI:	data = data*data*data*data;     break;
+		}		
+	if( options.invert_colors )
+		data = 1. - data;
+	pix_val = (ncv_pixel)(data * options.n_colors) + 10;
+
+	return( pix_val );
+}
+
+/******************************************************************************
+ * Fill 'levels' (which is nx by ny, the size of the data) with the color
+ * level of each point of v->data.  This is what the framestore keeps so
+ * that frames can be shown again at another size without going back to
+ * the data; see levels_to_pixels().  The overlay isn't put on here, since
+ * it has to go on after the frame is scaled, as it does for the data.
+ */
+	void
+data_to_levels( View *v, ncv_pixel *levels )
+{
+	size_t	i, n;
+	float	fill_value, data_range;
 
-		for( i=0; i<new_x_size; i++ ) {
-			rawdata =  *(scaled_data + i + j2*new_x_size);
-			if( close_enough(rawdata, fill_value) || (rawdata == FILL_FLOAT))
-				pix_val = *pixel_transform;
+	n          = *(v->variable->size + v->x_axis_id) * *(v->variable->size + v->y_axis_id);
+	fill_value = v->variable->fill_value;
+	data_range = v->variable->user_max - v->variable->user_min;
+
+	for( i=0; i<n; i++ )
+		levels[i] = data_to_level_value( v, *((float *)v->data + i), fill_value, data_range );
+}
+
+/******************************************************************************
+ * Returns TRUE if levels_to_pixels() makes the same pixels at the current
+ * blowup or zoom as data_to_pixels() does.  That is only so when each
+ * pixel is a copy of one data point.  Averaging, taking the mode, or
+ * interpolating the color levels isn't the same as doing it to the data
+ * (and contract_data and expand_data don't use the same squares and
+ * weights as the zoom filters anyway), so those frames have to be made
+ * from the data.
+ */
+	int
+levels_match_data( void )
+{
+	if( options.zoom > 0.0 )
+		return( resample_filter() == ZOOM_FILTER_NEAREST );
+
+	return( (options.blowup == 1) ||
+		((options.blowup > 1) && (options.blowup_type == BLOWUP_REPLICATE)) );
+}
+
+/******************************************************************************
+ * Fill in the region of v->pixels that starts at (px0,py0) and is pnx by pny
+ * from a frame of color levels made by data_to_levels(), scaling it to the
+ * current blowup or zoom and then putting on the overlay.  This should
+ * only be used when levels_match_data() says the result is the same as
+ * making the frame from the data.
+ */
+	void
+levels_to_pixels( View *v, ncv_pixel *levels, size_t px0, size_t py0, size_t pnx, size_t pny )
+{
+	ZoomInfo zi;
+	size_t	i, n;
+
+	zi.nx = *(v->variable->size + v->x_axis_id);
+	zi.ny = *(v->variable->size + v->y_axis_id);
+	n     = zi.nx*zi.ny;
+
+	zi.data = (float *)malloc( n*sizeof(float) );
+	if( zi.data == NULL ) {
+		fprintf( stderr, "ncview: levels_to_pixels: can't allocate %ld floats\n", n );
+		exit( -1 );
+		}
+	for( i=0; i<n; i++ )
+		zi.data[i] = (float)levels[i];
+
+	zi.v          = v;
+	zi.is_levels  = TRUE;
+	zi.filter     = resample_filter();
+	zi.px0        = px0;
+	zi.py0        = py0;
+	zi.pnx        = pnx;
+	zi.fill_value = 0.0;
+	zi.data_range = 1.0;
+	resample_to_pixels( &zi, pny );
+
+	free( zi.data );
+
+	overlay_pixels( v, px0, py0, pnx, pny );
+}
+
+/******************************************************************************
+ * Fill in the region of v->pixels that starts at (px0,py0) and is pnx by pny
+ * when the zoom factor is not an integer (options.zoom > 0).  Each pixel is
+ * found directly from v->data, rather than by making a scaled copy of the
+ * data and then converting that to pixels, so the work done depends only on
+ * the number of pixels drawn.  The rows are split among threads.
+ */
+	static void
+zoom_data_to_pixels( View *v, size_t px0, size_t py0, size_t pnx, size_t pny, float data_range )
+{
+	ZoomInfo zi;
+
+	zi.v          = v;
+	zi.data       = (float *)v->data;
+	zi.is_levels  = FALSE;
+	zi.nx         = *(v->variable->size + v->x_axis_id);
+	zi.ny         = *(v->variable->size + v->y_axis_id);
+	zi.px0        = px0;
+	zi.py0        = py0;
+	zi.pnx        = pnx;
+	zi.fill_value = v->variable->fill_value;
+	zi.data_range = data_range;
+	zi.filter     = resample_filter();
+	if( options.debug ) printf( "..zoom filter=%d\n", zi.filter );
+
+	resample_to_pixels( &zi, pny );
+}
+
+/******************************************************************************
+ * The filter to use when resampling to the current zoom or blowup.  Integer
+ * blowups use the Repl/Bi-lin setting, and integer shrinks -shrink_mode.
+ */
+	static int
+resample_filter( void )
+{
+	if( (options.zoom > 0.0) && (options.zoom_filter != ZOOM_FILTER_AUTO) )
+		return( options.zoom_filter );
+
+	if( ((options.zoom > 0.0) && (options.zoom >= 1.0)) ||
+	    ((options.zoom == 0.0) && (options.blowup >= 1)) )
+		return( (options.blowup_type == BLOWUP_BILINEAR) ? ZOOM_FILTER_BILINEAR : ZOOM_FILTER_NEAREST );
+
+	return( (options.shrink_method == SHRINK_METHOD_MEAN) ? ZOOM_FILTER_BOX : ZOOM_FILTER_NEAREST );
+}
+
+/******************************************************************************
+ * Does the part of the resampling that is the same whether it is from the
+ * data or from saved color levels: make the table of which source columns
+ * each pixel column uses, then do the rows in parallel.  Everything in zi
+ * but the sizes of the scaled image and the column table must be set.
+ */
+	static void
+resample_to_pixels( ZoomInfo *zi, size_t pny )
+{
+	size_t	i;
+
+	view_get_scaled_size( options.blowup, zi->nx, zi->ny, &(zi->new_nx), &(zi->new_ny) );
+
+	zi->ix0 = (long *)malloc( zi->pnx*sizeof(long) );
+	zi->ix1 = (long *)malloc( zi->pnx*sizeof(long) );
+	zi->wx  = (float *)malloc( zi->pnx*sizeof(float) );
+	if( (zi->ix0 == NULL) || (zi->ix1 == NULL) || (zi->wx == NULL) ) {
+		fprintf( stderr, "ncview: resample_to_pixels: can't allocate %ld column entries\n", zi->pnx );
+		exit( -1 );
+		}
+	for( i=0; i<zi->pnx; i++ )
+		zoom_source_range( zi->filter, zi->px0+i, zi->nx, zi->new_nx, zi->ix0+i, zi->ix1+i, zi->wx+i );
+
+	par_for( (long)pny, 16L, zoom_rows, zi );
+
+	free( zi->ix0 );
+	free( zi->ix1 );
+	free( zi->wx  );
+}
+
+/******************************************************************************
+ * Which data points (along one axis) are used for pixel 'pix' of 'new_n',
+ * when the data has 'n' points along that axis.  See ZoomInfo for what
+ * i0, i1, and w mean for each filter.
+ */
+	static void
+zoom_source_range( int filter, size_t pix, size_t n, size_t new_n, long *i0, long *i1, float *w )
+{
+	double	scale, f;
+
+	scale = (double)n / (double)new_n;
+	*w    = 0.0;
+
+	switch( filter ) {
+		case ZOOM_FILTER_BOX:
+			*i0 = (long)floor( (double)pix * scale );
+			*i1 = (long)ceil( (double)(pix+1) * scale );
+			if( *i0 > (long)n-1 )
+				*i0 = (long)n-1;
+			if( *i1 <= *i0 )
+				*i1 = *i0 + 1;
+			if( *i1 > (long)n )
+				*i1 = (long)n;
+			break;
+
+		case ZOOM_FILTER_BILINEAR:
+			/* Data point i is centered at pixel (i+0.5)/scale */
+			f = ((double)pix + 0.5)*scale - 0.5;
+			if( f < 0.0 )
+				f = 0.0;
+			*i0 = (long)f;
+			if( *i0 >= (long)n-1 ) {
+				*i0 = (long)n-1;
+				*i1 = *i0;
+				}
 			else
 				{
-				data = (rawdata - v->variable->user_min) / data_range;
-				clip_f( &data, 0.0, .9999 );
-				switch( options.transform ) {
-					case TRANSFORM_NONE:	break;
-
-					/* This might cause problems.  It is at odds with what
-					 * the manual claims--at least for Ultrix--but works, 
-					 * whereas what the manual claims works, doesn't!
-					 */
-					case TRANSFORM_LOW:	data = sqrt( data );  
-								data = sqrt( data );
-								break;
-
-					case TRANSFORM_HI:	data = data*data*data*data;     break;
-					}		
-				if( options.invert_colors )
-					data = 1. - data;
-				pix_val = (ncv_pixel)(data * options.n_colors) + 10;
-				if( options.display_type == PseudoColor )
-					pix_val = *(pixel_transform+pix_val);
+				*i1 = *i0 + 1;
+				*w  = (float)(f - (double)(*i0));
 				}
-			*(v->pixels + i + j*new_x_size) = pix_val;
-			}
+			break;
+
+		default: /* ZOOM_FILTER_NEAREST */
+			*i0 = (long)(((double)pix + 0.5)*scale);
+			if( *i0 > (long)n-1 )
+				*i0 = (long)n-1;
+			*i1 = *i0;
+			break;
 		}
+}
 
-	free( scaled_data );
-	return( 0 );
+/******************************************************************************
+ * Does pixel rows first through last-1 of the region of a zoomed image.
+ * This is called through par_for.  With bilinear filtering, a pixel is
+ * missing if the data point nearest to it is missing; otherwise any missing
+ * neighbors are left out of the interpolation.  With box filtering, a pixel
+ * is missing if anything in its box is, as when shrinking by the mean.
+ */
+	static void
+zoom_rows( long first, long last, void *arg )
+{
+	ZoomInfo *zi;
+	float	*data, val, fill, wy, w[4], d[4], sum, wsum;
+	long	j, i, k, iy0, iy1, ii, jj, n;
+	size_t	prow, srow;
+	int	missing;
+	double	dsum;
+	ncv_pixel *pix;
+
+	zi   = (ZoomInfo *)arg;
+	data = zi->data;
+	fill = zi->fill_value;
+
+	for( j=first; j<last; j++ ) {
+		/* Pixel rows run top to bottom, the data bottom to top, unless inverted */
+		prow = zi->py0 + j;
+		if( options.invert_physical )
+			srow = prow;
+		else
+			srow = zi->new_ny - prow - 1;
+		zoom_source_range( zi->filter, srow, zi->ny, zi->new_ny, &iy0, &iy1, &wy );
+
+		pix = zi->v->pixels + zi->px0 + prow*zi->new_nx;
+		for( i=0; i<zi->pnx; i++ ) {
+			switch( zi->filter ) {
+				case ZOOM_FILTER_BOX:
+					dsum    = 0.0;
+					missing = FALSE;
+					for( jj=iy0; (jj<iy1) && (! missing); jj++ )
+					for( ii=zi->ix0[i]; ii<zi->ix1[i]; ii++ ) {
+						val = *(data + ii + jj*zi->nx);
+						if( close_enough( val, fill )) {
+							missing = TRUE;
+							break;
+							}
+						dsum += val;
+						}
+					n   = (zi->ix1[i] - zi->ix0[i]) * (iy1 - iy0);
+					val = missing ? fill : (float)(dsum / (double)n);
+					break;
+
+				case ZOOM_FILTER_BILINEAR:
+					d[0] = *(data + zi->ix0[i] + iy0*zi->nx);
+					d[1] = *(data + zi->ix1[i] + iy0*zi->nx);
+					d[2] = *(data + zi->ix0[i] + iy1*zi->nx);
+					d[3] = *(data + zi->ix1[i] + iy1*zi->nx);
+					w[0] = (1.0 - zi->wx[i]) * (1.0 - wy);
+					w[1] = zi->wx[i]         * (1.0 - wy);
+					w[2] = (1.0 - zi->wx[i]) * wy;
+					w[3] = zi->wx[i]         * wy;
+
+					/* The nearest point is the one with the most weight */
+					k = 0;
+					for( n=1; n<4; n++ )
+						if( w[n] > w[k] )
+							k = n;
+					if( close_enough( d[k], fill )) {
+						val = fill;
+						break;
+						}
+					sum  = 0.0;
+					wsum = 0.0;
+					for( n=0; n<4; n++ )
+						if( ! close_enough( d[n], fill )) {
+							sum  += w[n]*d[n];
+							wsum += w[n];
+							}
+					val = sum / wsum;
+					break;
+
+				default: /* ZOOM_FILTER_NEAREST */
+					val = *(data + zi->ix0[i] + iy0*zi->nx);
+					break;
+				}
+
+			if( ! zi->is_levels )
+				pix[i] = data_to_pixel_value( zi->v, val, fill, zi->data_range );
+			else if( close_enough( val, fill ))
+				pix[i] = level_to_pixel_value( 0 );
+			else
+				pix[i] = level_to_pixel_value( (ncv_pixel)(val + 0.5) );
+			}
+		}
 }
 
 /******************************************************************************
@@ -810,9 +1245,8 @@ get_min_max_onestep( NCVar *var, size_t n_other, size_t tstep, float *data,
 					float *min, float *max, int verbose )
 {
 	size_t	*start, *count, n_time;
-	size_t	j;
 	int	i;
-	float	dat, fill_v;
+	float	fill_v;
 	
 	count  = (size_t *)malloc( var->n_dims * sizeof( size_t ));
 	start  = (size_t *)malloc( var->n_dims * sizeof( size_t ));
@@ -836,7 +1270,23 @@ get_min_max_onestep( NCVar *var, size_t n_other, size_t tstep, float *data,
 
 	fi_get_data( var, start, count, data );
 
-	for( j=0; j<n_other; j++ ) {
+	min_max_of( data, n_other, fill_v, min, max );
+		
+	free( count );
+	free( start );
+}
+
+/******************************************************************************
+ * Widen [*min, *max] to take in the n values in data, leaving out NaNs and
+ * missing values.
+ */
+	void
+min_max_of( float *data, size_t n, float fill_v, float *min, float *max )
+{
+	size_t	j;
+	float	dat;
+
+	for( j=0; j<n; j++ ) {
 		dat = *(data+j);
 		if( dat != dat )
 			dat = fill_v;
@@ -848,9 +1298,6 @@ get_min_max_onestep( NCVar *var, size_t n_other, size_t tstep, float *data,
 				*min = dat;
 			}
 		}
-		
-	free( count );
-	free( start );
 }
 
 /******************************************************************************
@@ -1329,6 +1776,7 @@ fill_dim_structs( NCVar *v )
 			d->name      	= dim_name;
 			d->long_name 	= fi_dim_longname( fileid, dim_name );
 			d->have_calc_minmax = 0;
+			d->coord_index  = NULL;
 			d->units     	= fi_dim_units   ( fileid, dim_name );
 			d->units_change = 0;
 			d->size      	= *(v->size+i);
@@ -1391,59 +1839,132 @@ is_scannable( NCVar *v, int i )
 
 /******************************************************************************
  * Return the mode (most common value) of passed array "x".  We assume "x"
- * contains the floating point representation of integers.
+ * contains the floating point representation of integers.  If there is a
+ * tie, the value that appears first in "x" wins.  All the working space
+ * comes from 'ms', so nothing is allocated here.  When the values span
+ * fewer than MODE_HIST_SIZE integers they are simply counted in a histogram,
+ * otherwise they are sorted and the runs of equal values are counted.
  */
 	float
-util_mode( float *x, size_t n, float fill_value )
+util_mode( float *x, size_t n, float fill_value, ModeScratch *ms )
 {
-	long 	i, n_vals;
-	double 	sum;
-	long 	ival, *count_vals, max_count, *unique_vals;
-	int	foundval, j, max_index;
-	float	retval;
+	long 	i, ival, ival_min, ival_max, retval, count, best_count, best_first;
+	size_t	run_start;
 
-	count_vals  = (long *)malloc( n*sizeof(long) );
-	unique_vals = (long *)malloc( n*sizeof(long) );
-
-	sum = 0.0;
-	n_vals = 0;
+	ival_min = 0L;
+	ival_max = 0L;
 	for( i=0L; i<n; i++ ) {
-		if( close_enough( x[i], fill_value )) {
-			free(count_vals);
-			free(unique_vals);
+		if( close_enough( x[i], fill_value ))
 			return( fill_value );
-			}
 		ival = (x[i] > 0.) ? (long)(x[i]+.4) : (long)(x[i]-.4); /* round x[i] to nearest integer */
-		foundval = -1;
-		for( j=0; j<n_vals; j++ ) {
-			if( unique_vals[j] == ival ) {
-				foundval = j;
-				break;
+		ms->ivals[i] = ival;
+		if( (i == 0) || (ival < ival_min) )
+			ival_min = ival;
+		if( (i == 0) || (ival > ival_max) )
+			ival_max = ival;
+		}
+	if( n == 0 )
+		return( fill_value );
+
+	/* The difference is taken unsigned, since values far outside the
+	 * integers (such as a scaled fill value) can make it overflow a long
+	 */
+	retval = ms->ivals[0];
+	if( ((unsigned long)ival_max - (unsigned long)ival_min) < MODE_HIST_SIZE ) {
+		for( i=0L; i<n; i++ )
+			ms->hist[ ms->ivals[i]-ival_min ]++;
+
+		/* Going through in the original order makes the first value win ties */
+		best_count = 0;
+		for( i=0L; i<n; i++ ) 
+			if( ms->hist[ ms->ivals[i]-ival_min ] > best_count ) {
+				best_count = ms->hist[ ms->ivals[i]-ival_min ];
+				retval     = ms->ivals[i];
 				}
+
+		/* Leave the histogram all zeros for next time */
+		for( i=0L; i<n; i++ )
+			ms->hist[ ms->ivals[i]-ival_min ] = 0;
+		}
+	else
+		{
+		for( i=0L; i<n; i++ ) {
+			ms->pairs[i].val = ms->ivals[i];
+			ms->pairs[i].idx = i;
 			}
-		if( foundval == -1 ) {
-			unique_vals[n_vals] = ival;
-			count_vals[n_vals] = 1;
-			n_vals++;
+		qsort( ms->pairs, n, sizeof(ModePair), mode_pair_compare );
+
+		/* Within a run of equal values the first entry is where that 
+		 * value first appeared, which is used to break ties
+		 */
+		best_count = 0;
+		best_first = n;
+		run_start  = 0L;
+		for( i=1L; i<=n; i++ ) {
+			if( (i == n) || (ms->pairs[i].val != ms->pairs[run_start].val) ) {
+				count = i - run_start;
+				if( (count > best_count) || 
+				    ((count == best_count) && (ms->pairs[run_start].idx < best_first))) {
+					best_count = count;
+					best_first = ms->pairs[run_start].idx;
+					retval     = ms->pairs[run_start].val;
+					}
+				run_start = i;
+				}
 			}
-		else
-			count_vals[foundval]++;
 		}
 
-	max_count = -1;
-	max_index = -1;
-	for( i=0L; i<n_vals; i++ )
-		if( count_vals[i] > max_count ) {
-			max_count = count_vals[i];
-			max_index = i;
-			}
+	return( (float)retval );
+}
 
-	retval = (float)unique_vals[max_index];
+/******************************************************************************
+ * Sort on value, then on where the value was in the original array.
+ */
+	static int
+mode_pair_compare( const void *p1, const void *p2 )
+{
+	const ModePair *a, *b;
 
-	free(count_vals);
-	free(unique_vals);
+	a = (const ModePair *)p1;
+	b = (const ModePair *)p2;
 
-	return( retval );
+	if( a->val != b->val )
+		return( (a->val < b->val) ? -1 : 1 );
+	if( a->idx != b->idx )
+		return( (a->idx < b->idx) ? -1 : 1 );
+	return( 0 );
+}
+
+/******************************************************************************
+ * Working space for util_mode, big enough for arrays of up to n values.
+ */
+	static ModeScratch *
+new_mode_scratch( size_t n )
+{
+	ModeScratch *ms;
+
+	ms = (ModeScratch *)malloc( sizeof(ModeScratch) );
+	if( ms != NULL ) {
+		ms->ivals = (long *)malloc( n*sizeof(long) );
+		ms->pairs = (ModePair *)malloc( n*sizeof(ModePair) );
+		ms->hist  = (int *)calloc( MODE_HIST_SIZE, sizeof(int) );
+		}
+	if( (ms == NULL) || (ms->ivals == NULL) || (ms->pairs == NULL) || (ms->hist == NULL) ) {
+		fprintf( stderr, "ncview: new_mode_scratch: failed to allocate working space for %ld values\n", n );
+		exit( -1 );
+		}
+
+	return( ms );
+}
+
+/******************************************************************************/
+	static void
+free_mode_scratch( ModeScratch *ms )
+{
+	free( ms->ivals );
+	free( ms->pairs );
+	free( ms->hist  );
+	free( ms );
 }
 
 /******************************************************************************/
@@ -1603,436 +2124,387 @@ calc_dim_minmaxes( void )
 }
 	
 /********************************************************************************
- * Actually do the "shrinking" of the FLOATING POINT (not pixel) data, converting 
+ * Actually do the "shrinking" of the FLOATING POINT (not pixel) data, converting
  * it to the small version by either finding the most common value in the square,
- * or by averaging over the square.  Remember that our standard for how to 
+ * or by averaging over the square.  Remember that our standard for how to
  * interpret 'options.blowup' is that a value of "-N" means to shrink by a factor
  * of N.  So, blowup == -2 means make it half size, -3 means 1/3 size, etc.
+ *
+ * Each shrunken field is kept in v->shrink_levels until the data changes, so
+ * going back to a shrink factor we have already done is just a copy.  Means
+ * of squares that lie entirely inside the data are found from a pyramid of
+ * power-of-two mean levels where possible, rather than from the full
+ * resolution data.
  */
 	void
 contract_data( float *small_data, View *v, float fill_value )
 {
-	long 	i, j, n, nx, ny, ii, jj;
-	size_t	new_nx, new_ny, idx, ioffset, joffset;
-	float 	*tmpv;
+	long 	n, nx, ny, level_factor;
+	size_t	new_nx, new_ny;
+	ContractInfo ci;
+	ShrinkLevel *sl, *pyr;
 
 	if( options.blowup > 0 ) {
 		fprintf( stderr, "internal error, contract_data called with a positive blowup factor!\n" );
 		exit(-1);
 		}
 
-	n = -options.blowup;
-	tmpv = (float *)malloc( n*n * sizeof(float) );
-	if( tmpv == NULL ) {
-		fprintf( stderr, "internal error, failed to allocate array for calculating reduced means\n" );
+	if( (options.shrink_method != SHRINK_METHOD_MEAN) && (options.shrink_method != SHRINK_METHOD_MODE) ) {
+		fprintf( stderr, "Error in contract_data: unknown value of options.shrink_method!\n" );
 		exit( -1 );
 		}
 
+	n = -options.blowup;
+
 	/* Get old and new sizes (new size is smaller in this routine) */
 	nx   = *(v->variable->size + v->x_axis_id);
 	ny   = *(v->variable->size + v->y_axis_id);
 	view_get_scaled_size( options.blowup, nx, ny, &new_nx, &new_ny );
 
-	for( j=0; j<new_ny; j++ )
-	for( i=0; i<new_nx; i++ ) {
-		for( jj=0; jj<n; jj++ )
-		for( ii=0; ii<n; ii++ ) {
-			ioffset = i*n + ii;
-			joffset = j*n + jj;
-			if( ioffset >= nx )
-				ioffset = nx-1;
-			if( joffset >= ny )
-				joffset = ny-1;
-			idx = ioffset + joffset*nx;
-			tmpv[ii + jj*n] = *((float *)v->data + idx);
-			}
+	/* Have we already done this one? */
+	sl = find_shrink_level( v, n, options.shrink_method );
+	if( (sl != NULL) && (sl->nx == new_nx) && (sl->ny == new_ny) ) {
+		if( options.debug ) printf( "..using saved shrunken data, factor=%ld\n", n );
+		memcpy( small_data, sl->data, new_nx*new_ny*sizeof(float) );
+		return;
+		}
 
-		if( options.shrink_method == SHRINK_METHOD_MEAN )
-			small_data[i + j*new_nx] = util_mean( tmpv, n*n, fill_value );
+	ci.v           = v;
+	ci.small_data  = small_data;
+	ci.fill_value  = fill_value;
+	ci.n           = n;
+	ci.new_nx      = new_nx;
+	ci.interior_nx = nx/n;
+	ci.interior_ny = ny/n;
 
-		else if( options.shrink_method == SHRINK_METHOD_MODE ) {
-			small_data[i + j*new_nx] = util_mode( tmpv, n*n, fill_value );
+	/* For means, squares that lie completely inside the data are found 
+	 * from the largest power-of-two pyramid level that evenly divides the
+	 * shrink factor; each output point is then the mean of f by f points
+	 * of that level.
+	 */
+	if( options.shrink_method == SHRINK_METHOD_MEAN ) {
+		level_factor = 1;
+		while( (n % (level_factor*2)) == 0 )
+			level_factor *= 2;
+		if( level_factor == 1 ) {
+			ci.src    = (float *)v->data;
+			ci.src_nx = nx;
 			}
 		else
 			{
-			fprintf( stderr, "Error in contract_data: unknown value of options.shrink_method!\n" );
-			exit( -1 );
+			pyr       = get_mean_pyramid_level( v, level_factor, fill_value );
+			ci.src    = pyr->data;
+			ci.src_nx = pyr->nx;
 			}
+		ci.f = n / level_factor;
 		}
 
+	/* The rows of the output are independent, so do them in parallel */
+	par_for( new_ny, 1, contract_rows, (void *)&ci );
 
-	free(tmpv);
+	sl = add_shrink_level( v, n, options.shrink_method, new_nx, new_ny );
+	memcpy( sl->data, small_data, new_nx*new_ny*sizeof(float) );
 }
 
 /******************************************************************************
- * Actually do the "blowup" of the FLOATING POINT (not pixel) data, converting 
- * it to the large version by either interpolation or replication.
- * NOTE this routine is only called when options.blowup > 0!
+ * Does rows first through last-1 of the shrunken field for contract_data.
  */
-	void
-expand_data( float *big_data, View *v, size_t array_size )
+	static void
+contract_rows( long first, long last, void *arg )
 {
-	size_t	idx, nxl, nyl, nxb, nyb;
-	long	line, il, jl, i2b, j2b;
-	int	blowup, offset_xb, offset_yb, miss_base, miss_right, miss_below;
-	float	step, final_est, extrap_fact;
-	float	base_val, right_val, below_val, val, bupr;
-	float	base_x, base_y, del_x, del_y;
-	float	est1, est2, frac_x, frac_y;
-	float 	fill_val, cval;
-
-	blowup   = options.blowup;
+	ContractInfo	*ci;
+	long		i, j, ii, jj, f, i_edge;
+	float		*tmpv, val;
+	double		sum;
+	int		missing;
+	ModeScratch	*ms;
 
-#ifdef CHECK_MEM
-	printf( "...CHECK_MEM is on!!\n" );
-#endif
+	ci = (ContractInfo *)arg;
+	f  = ci->f;
 
-	/*--------------------------------------------------------------------------------
-	 * See my notebook entry of 2010-08-23. 
-	 * In general we draw a distinction between indices that are valid in the
-	 * original (little) array, indicazted by a "l" (little) suffix (such as il or jl),
-	 * and indices valid in the destination (big) array, which have a suffix of "b".
-	 *---------------------------------------------------------------------------------*/
-	nxl = *(v->variable->size + v->x_axis_id);	/* # of X entries in the little array */
-	nyl = *(v->variable->size + v->y_axis_id);	/* # of Y entries in the little array */
-	nxb = nxl*blowup;				/* # of X entries in big array */
-	nyb = nyl*blowup;				/* # of Y entries in big array */
-
-	fill_val = v->variable->fill_value;
-	
-	if( (nxb < blowup) || (nxb*nyb < blowup) ) {
-		fprintf( stderr, "ncview: data_to_pixels: too much magnification\n" );
-		fprintf( stderr, "nxb=%ld\n", nxb );
+	tmpv = (float *)malloc( ci->n*ci->n * sizeof(float) );
+	if( tmpv == NULL ) {
+		fprintf( stderr, "internal error, failed to allocate array for calculating reduced means\n" );
 		exit( -1 );
 		}
-
-	if( (blowup == 1) || (options.blowup_type == BLOWUP_REPLICATE)) { 
-		for( jl=0; jl<nyl; jl++ ) {
-			for( il=0; il<nxl; il++ )
-				for( i2b=0; i2b<blowup; i2b++ ) {
-#ifdef CHECK_MEM
-					if( il*blowup + jl*nxb*blowup + i2b >= array_size ) { fprintf( stderr, "mem error 001\n" ); exit(-1); }
-#endif
-					*(big_data + il*blowup + jl*nxb*blowup + i2b) = *((float *)((float *)v->data)+il+jl*nxl);
-					}
-			for( line=1; line<blowup; line++ )
-				for( i2b=0; i2b<nxb; i2b++ ) {
-#ifdef CHECK_MEM
-					if( i2b + jl*nxb*blowup + line*nxb >= array_size ) { fprintf( stderr, "mem error 002\n" ); exit(-1); }
-#endif
-					*(big_data + i2b + jl*nxb*blowup + line*nxb) =
-						*(big_data + i2b + jl*nxb*blowup);
-					}
-			}
-		} 
-
-	else 	{ /* BLOWUP_BILINEAR */
-		bupr = 1.0/(float)blowup;
-
-		/* Offset where we will put the center value into the big array. These are offsets
-		 * into the big array.
-		 */
-		offset_xb = (blowup - 1)/2;
-		offset_yb = offset_xb;
-
-		/* Horizontal base lines */
-		for( jl=0; jl<nyl; jl++ ) {
-			for( il=0; il<nxl-1; il++ ) {
-				base_val  = *((float *)v->data + il   + jl*nxl);
-				right_val = *((float *)v->data + il+1 + jl*nxl);
-
-				miss_base  = close_enough(base_val,  fill_val);
-				miss_right = close_enough(right_val, fill_val);
-				if( miss_base ) {
-					if( miss_right ) {
-						/* BOTH missing */
-						step = 0.0;
-						val = base_val;		/* missing value */
-						}
-					else
-						{
-						/* base missing, but right is there */
-						step = 0.0;
-						val = right_val;	/* an OK value */
+	ms = NULL;
+	if( options.shrink_method == SHRINK_METHOD_MODE )
+		ms = new_mode_scratch( ci->n*ci->n );
+
+	for( j=first; j<last; j++ ) {
+
+		/* Squares past i_edge hang off the right or top edge of the data */
+		i_edge = (j < ci->interior_ny) ? ci->interior_nx : 0;
+
+		if( options.shrink_method == SHRINK_METHOD_MEAN ) {
+			for( i=0; i<i_edge; i++ ) {
+				sum     = 0.0;
+				missing = FALSE;
+				for( jj=0; (jj<f) && (!missing); jj++ )
+				for( ii=0; ii<f; ii++ ) {
+					val = *(ci->src + i*f + ii + (j*f + jj)*ci->src_nx);
+					if( close_enough( val, ci->fill_value )) {
+						missing = TRUE;
+						break;
 						}
+					sum += val;
 					}
-				else if( miss_right ) {
-					/* ONLY right is missing, checked for both missing above */
-					val = base_val;
-					step = 0.0;
-					}
+				if( missing )
+					ci->small_data[i + j*ci->new_nx] = ci->fill_value;
 				else
-					{
-					/* NEITHER missing */
-					step = (right_val-base_val)*bupr;
-					val = base_val;
-					}
-
-				for( i2b=0; i2b < blowup; i2b++ ) {
-#ifdef CHECK_MEM
-					if( il*blowup+i2b+offset_xb + jl*blowup*nxb + offset_yb*nxb >= array_size ) { fprintf( stderr, "mem error 003\n" ); exit(-1); }
-#endif
-					*(big_data + il*blowup+i2b+offset_xb + jl*blowup*nxb + offset_yb*nxb ) = val;
-					val += step;
-					}
+					ci->small_data[i + j*ci->new_nx] = sum / (double)(f*f);
 				}
-			/* Fill in the last center value on the right, which was left unfilled by the above alg */
-#ifdef CHECK_MEM
-			if( (nxl-1)*blowup+offset_xb + jl*blowup*nxb + offset_yb*nxb >= array_size ) { fprintf( stderr, "mem error 004\n" ); exit(-1); }
-#endif
-			*(big_data + (nxl-1)*blowup+offset_xb + jl*blowup*nxb + offset_yb*nxb ) = *((float *)v->data + (nxl-1) + jl*nxl);
+			}
+		else
+			{
+			for( i=0; i<i_edge; i++ )
+				ci->small_data[i + j*ci->new_nx] = contract_square( ci->v, ci->n, i, j, tmpv, ms, ci->fill_value );
 			}
 
-		/* Vertical base lines */
-		for( jl=0; jl<nyl-1; jl++ ) 
-		for( il=0; il<nxl;   il++ ) {
-			base_val  = *((float *)v->data + il + jl*nxl);
-			below_val = *((float *)v->data + il + (jl+1)*nxl);
+		for( i=i_edge; i<ci->new_nx; i++ )
+			ci->small_data[i + j*ci->new_nx] = contract_square( ci->v, ci->n, i, j, tmpv, ms, ci->fill_value );
+		}
 
-			miss_base  = close_enough(base_val,  fill_val);
-			miss_below = close_enough(below_val, fill_val);
+	free( tmpv );
+	if( ms != NULL )
+		free_mode_scratch( ms );
+}
 
-			if( miss_base ) {
-				if( miss_below ) {
-					/* BOTH missing */
-					step = 0.0;
-					val = base_val;		/* missing value */
-					}
-				else
-					{
-					/* base missing, but below is there */
-					step = 0.0;
-					val = below_val;	/* an OK value */
-					}
-				}
-			else if( miss_below ) {
-				/* ONLY below is missing, checked for both missing above */
-				val = base_val;
-				step = 0.0;
-				}
-			else
-				{
-				/* NEITHER missing */
-				step = (below_val-base_val)*bupr;
-				val = base_val;
-				}
+/******************************************************************************
+ * Mean or mode of the n by n square of data that becomes point (i,j) of the
+ * shrunken field.  Points of the square that are off the edge of the data
+ * take the value at the edge.  'tmpv' must have room for n*n values, and
+ * 'ms' must be big enough for that many too if we are taking modes.
+ */
+	static float
+contract_square( View *v, long n, long i, long j, float *tmpv, ModeScratch *ms, float fill_value )
+{
+	long	nx, ny, ii, jj;
+	size_t	idx, ioffset, joffset;
 
-			for( j2b=0; j2b < blowup; j2b++ ) {
-#ifdef CHECK_MEM
-			if( il*blowup+offset_xb + jl*blowup*nxb + (j2b+offset_yb)*nxb >= array_size ) { fprintf( stderr, "mem error 005\n" ); exit(-1); }
-#endif
-				*(big_data + il*blowup+offset_xb + jl*blowup*nxb + (j2b+offset_yb)*nxb ) = val;
-				val += step;
-				}
-			}
-		/* Fill in the last center value along the top, which was left unfilled by the above alg */
-		for( il=0; il<nxl; il++ ) {
-#ifdef CHECK_MEM
-			if( il*blowup+offset_xb + (nyl-1)*blowup*nxb + offset_yb*nxb >= array_size ) { fprintf( stderr, "mem error 006\n" ); exit(-1); }
-#endif
-			*(big_data + il*blowup+offset_xb + (nyl-1)*blowup*nxb + offset_yb*nxb) = *((float *)v->data + il + (nyl-1)*nxl);
-			}
+	nx   = *(v->variable->size + v->x_axis_id);
+	ny   = *(v->variable->size + v->y_axis_id);
 
-		/* Now, fill in the interior of the interior squares by 
-		 * interpolating from the horizontal and vertical
-		 * base lines.
-		 */
-		for( jl=0; jl<nyl-1; jl++ )
-		for( il=0; il<nxl-1; il++ ) {
-			for( j2b=1; j2b<blowup; j2b++ )
-			for( i2b=1; i2b<blowup; i2b++ ) {
-				frac_x = (float)i2b*bupr;
-				frac_y = (float)j2b*bupr;
-
-				base_x    = *(big_data +  il   *blowup+offset_xb + jl*blowup*nxb +(j2b+offset_yb)*nxb);
-				right_val = *(big_data + (il+1)*blowup+offset_xb + jl*blowup*nxb+ (j2b+offset_yb)*nxb);
-				base_y    = *(big_data + il*blowup+i2b+offset_xb +  jl   *blowup*nxb + offset_yb*nxb);
-				below_val = *(big_data + il*blowup+i2b+offset_xb + (jl+1)*blowup*nxb + offset_yb*nxb);
-
-				if( close_enough(base_x,    fill_val) || 
-				    close_enough(right_val, fill_val) || 
-				    (il == nxl-1) )
-					del_x = 0.0;
-				else
-					del_x  = right_val - base_x;
-				if( close_enough(base_y,    fill_val) || 
-				    close_enough(below_val, fill_val) || 
-				    (jl == nyl-1) )
-					del_y = 0.0;
-				else
-					del_y  = below_val - base_y;
-				est1 = frac_x*del_x + base_x;
-				est2 = frac_y*del_y + base_y;
-
-				if( close_enough( est1, fill_val )) {
-					if( close_enough( est2, fill_val ))
-						final_est = fill_val;
-					else
-						final_est = est2;
-					}
-				else if( close_enough( est2, fill_val ))
-					final_est = est1;
-				else
-					final_est = (est1 + est2)*.5;
+	for( jj=0; jj<n; jj++ )
+	for( ii=0; ii<n; ii++ ) {
+		ioffset = i*n + ii;
+		joffset = j*n + jj;
+		if( ioffset >= nx )
+			ioffset = nx-1;
+		if( joffset >= ny )
+			joffset = ny-1;
+		idx = ioffset + joffset*nx;
+		tmpv[ii + jj*n] = *((float *)v->data + idx);
+		}
 
-#ifdef CHECK_MEM
-				if( il*blowup+i2b+offset_xb + jl*blowup*nxb + (j2b+offset_yb)*nxb >= array_size ) { fprintf( stderr, "mem error 007\n" ); exit(-1); }
-#endif
-				*(big_data + il*blowup+i2b+offset_xb + jl*blowup*nxb + (j2b+offset_yb)*nxb ) = final_est;
-				}
-			}
+	if( options.shrink_method == SHRINK_METHOD_MEAN )
+		return( util_mean( tmpv, n*n, fill_value ));
+	else
+		return( util_mode( tmpv, n*n, fill_value, ms ));
+}
 
-		/* It is a tricky and undetermined question as to whether we want to allow
-		 * extrema on the boundaries.  As a complete and total hack, we use only 
-		 * some fraction of the linear projection when extrapolating out to the 
-		 * edges.  If this is set to 1, then full linear extrapolation is used;
-		 * if set to 0, no extrapolation is done.
-		 */
-		extrap_fact = 0.2;
+/******************************************************************************
+ * Returns the mean pyramid level for the indicated power-of-two factor,
+ * making it (and any finer levels it needs) if we don't have it yet.  Each
+ * level is made from the next finer one in a single pass, by averaging
+ * 2x2 squares.  Only points whose squares lie entirely inside the data
+ * are ever used from a level, so edges are not handled carefully here.
+ */
+	static ShrinkLevel *
+get_mean_pyramid_level( View *v, long factor, float fill_value )
+{
+	ShrinkLevel *sl, *finer;
+	float	*src, vals[4];
+	size_t	src_nx, src_ny, i, j, i2, j2;
+	int	k, missing;
+	double	sum;
 
-		/* Fill in right hand side by extrapolating the gradient from the interior square fill.
-		 * This goes from y=the first center point to y=the last center point.
-		 */
-		il = nxl-1;
-		for( j2b=0; j2b<=blowup*(nyl-1); j2b++ ) {
-			idx = il*blowup+offset_xb + (j2b+offset_yb)*nxb;	
-			step = (*(big_data + idx - 1) - *(big_data + idx - 2));
-			val  = *(big_data + idx) + step;
-			for( i2b=1; i2b<(blowup-offset_xb+1); i2b++ ) {
-#ifdef CHECK_MEM
-				if( idx + i2b >= array_size ) { fprintf( stderr, "mem error 008\n" ); exit(-1); }
-#endif
-				*(big_data + idx + i2b) = val;
-				val += step*extrap_fact;
-				}
-			}
+	sl = find_shrink_level( v, factor, SHRINK_PYRAMID );
+	if( sl != NULL )
+		return( sl );
 
-		/* Fill in left hand side */
-		il = 0;
-		for( j2b=0; j2b<=blowup*(nyl-1); j2b++ ) {
-			idx = il*blowup+offset_xb + (j2b+offset_yb)*nxb;
-			step = (*(big_data + idx + 2) - *(big_data + idx + 1));
-			val  = *(big_data + idx) - step;
-			for( i2b=1; i2b<=(blowup-1)/2; i2b++ ) {
-#ifdef CHECK_MEM
-				if( idx - i2b >= array_size ) { fprintf( stderr, "mem error 009\n" ); exit(-1); }
-#endif
-				*(big_data + idx - i2b) = val;
-				val -= step*extrap_fact;
+	if( factor == 2 ) {
+		src    = (float *)v->data;
+		src_nx = *(v->variable->size + v->x_axis_id);
+		src_ny = *(v->variable->size + v->y_axis_id);
+		}
+	else
+		{
+		finer  = get_mean_pyramid_level( v, factor/2, fill_value );
+		src    = finer->data;
+		src_nx = finer->nx;
+		src_ny = finer->ny;
+		}
+
+	if( options.debug ) printf( "..making mean pyramid level for factor %ld\n", factor );
+
+	sl = add_shrink_level( v, factor, SHRINK_PYRAMID, (src_nx+1)/2, (src_ny+1)/2 );
+	for( j=0; j<sl->ny; j++ ) {
+		j2 = ((2*j+1) < src_ny) ? 2*j+1 : src_ny-1;
+		for( i=0; i<sl->nx; i++ ) {
+			i2 = ((2*i+1) < src_nx) ? 2*i+1 : src_nx-1;
+			vals[0] = *(src + 2*i + 2*j*src_nx);
+			vals[1] = *(src + i2  + 2*j*src_nx);
+			vals[2] = *(src + 2*i + j2*src_nx);
+			vals[3] = *(src + i2  + j2*src_nx);
+			sum     = 0.0;
+			missing = FALSE;
+			for( k=0; k<4; k++ ) {
+				if( close_enough( vals[k], fill_value ))
+					missing = TRUE;
+				sum += vals[k];
 				}
+			*(sl->data + i + j*sl->nx) = missing ? fill_value : (float)(sum*0.25);
 			}
+		}
 
-		/* Fill in bottom */
-		jl = 0;
-		for( i2b=0; i2b<=blowup*(nxl-1); i2b++ ) {
-			idx = i2b+offset_xb + jl*blowup*nxb + offset_yb*nxb;
-			step = (*(big_data + idx + 2*nxb) - *(big_data + idx + nxb));   /* big(,y+2) - big(,y+1) */
-			val  = *(big_data + idx) - step;
-			for( j2b=1; j2b<=(blowup-1)/2; j2b++ ) {
-#ifdef CHECK_MEM
-				if( idx - j2b*nxb >= array_size ) { fprintf( stderr, "mem error 010\n" ); exit(-1); }
-#endif
-				*(big_data + idx - j2b*nxb) = val;
-				val -= step*extrap_fact;
-				}
-			}
+	return( sl );
+}
 
-		/* Fill in top */
-		jl = nyl-1;
-		for( i2b=0; i2b<blowup*(nxl-1); i2b++ ) {
-			idx = i2b+offset_xb + jl*blowup*nxb + offset_yb*nxb;
-			step = (*(big_data + idx - nxb) - *(big_data + idx - 2*nxb));  /* big(,y-1) - big(,y-2) */
-			val  = *(big_data + idx) + step;
-			for( j2b=1; j2b<=blowup/2; j2b++ ) {
-#ifdef CHECK_MEM
-				if( idx + j2b*nxb >= array_size ) { fprintf( stderr, "mem error 011\n" ); exit(-1); }
-#endif
-				*(big_data + idx + j2b*nxb) = val;
-				val += step*extrap_fact;
-				}
-			}
+/******************************************************************************/
+	static ShrinkLevel *
+find_shrink_level( View *v, int factor, int method )
+{
+	int	i;
 
-		/* Still have to fill in the four corners at this point.   Because of the
-		 * extrapolation issue noted above, we take a simple approach.  Just fill
-		 * in the corner blocks with the center data value.
-		 */
+	for( i=0; i<v->n_shrink_levels; i++ )
+		if( (v->shrink_levels[i].factor == factor) && (v->shrink_levels[i].method == method) )
+			return( v->shrink_levels + i );
 
-		/* Lower left corner */
-		il = 0;
-		jl = 0;
-		cval = *((float *)v->data + il + jl*nxl);          /* Data value in lower left corner */
-		if( ! close_enough( cval, fill_val )) {
-			/* Fill in lower left corner */
-			for( j2b=0; j2b<=offset_yb; j2b++ )
-			for( i2b=0; i2b<=offset_xb; i2b++ ) {
-#ifdef CHECK_MEM
-				if( i2b + j2b*nxb >= array_size ) { fprintf( stderr, "mem error 012\n" ); exit(-1); }
-#endif
-				*(big_data + i2b + j2b*nxb) = cval;
-				}
-			}
-			
-		/* Lower right corner */
-		il = nxl - 1;
-		jl = 0;
-		cval = *((float *)v->data + il + jl*nxl);          /* Data value in lower left corner */
-		if( ! close_enough( cval, fill_val )) {
-			/* Fill in lower right corner */
-			for( j2b=0; j2b<=offset_yb; j2b++ )
-			for( i2b=offset_xb; i2b<blowup; i2b++ ) {
-#ifdef CHECK_MEM
-				if( il*blowup + i2b + j2b*nxb >= array_size ) { fprintf( stderr, "mem error 013\n" ); exit(-1); }
-#endif
-				*(big_data + il*blowup + i2b + j2b*nxb) = cval;
-				}
-			}
+	return( NULL );
+}
 
-		/* Upper right corner */
-		il = nxl - 1;
-		jl = nyl - 1;
-		cval = *((float *)v->data + il + jl*nxl);          /* Data value in lower left corner */
-		if( ! close_enough( cval, fill_val )) {
-			/* Fill in upper right corner */
-			for( j2b=offset_yb; j2b<blowup; j2b++ )
-			for( i2b=offset_xb; i2b<blowup; i2b++ ) {
-#ifdef CHECK_MEM
-				if( il*blowup + i2b + jl*blowup*nxb + j2b*nxb >= array_size ) { fprintf( stderr, "mem error 014\n" ); exit(-1); }
-#endif
-				*(big_data + il*blowup + i2b + jl*blowup*nxb + j2b*nxb) = cval;
-				}
-			}
+/******************************************************************************
+ * Returns a new shrink level of the indicated size for the view, replacing
+ * any old one with the same factor and method.
+ */
+	static ShrinkLevel *
+add_shrink_level( View *v, int factor, int method, size_t nx, size_t ny )
+{
+	ShrinkLevel *sl;
 
-		/* Upper left corner */
-		il = 0;
-		jl = nyl - 1;
-		cval = *((float *)v->data + il + jl*nxl);          /* Data value in lower left corner */
-		if( ! close_enough( cval, fill_val )) {
-			/* Fill in upper left corner */
-			for( j2b=offset_yb; j2b<blowup; j2b++ )
-			for( i2b=0; i2b<=offset_xb; i2b++ ) {
-#ifdef CHECK_MEM
-				if(  il*blowup + i2b + jl*blowup*nxb + j2b*nxb >= array_size ) { fprintf( stderr, "mem error 015\n" ); exit(-1); }
-#endif
-				*(big_data + il*blowup + i2b + jl*blowup*nxb + j2b*nxb) = cval;
-				}
+	sl = find_shrink_level( v, factor, method );
+	if( sl != NULL )
+		free( sl->data );
+	else
+		{
+		v->shrink_levels = (ShrinkLevel *)realloc( v->shrink_levels,
+				(v->n_shrink_levels+1)*sizeof(ShrinkLevel) );
+		if( v->shrink_levels == NULL ) {
+			fprintf( stderr, "ncview: add_shrink_level: failed to allocate shrink level list\n" );
+			exit( -1 );
 			}
+		sl = v->shrink_levels + v->n_shrink_levels;
+		v->n_shrink_levels++;
+		}
 
-		/* Paint missing value blocks */
-		for( jl=0; jl<nyl; jl++ )
-		for( il=0; il<nxl; il++ ) {
-			base_val  = *((float *)v->data + il   + jl*nxl);
-			if( close_enough( base_val, fill_val )) {
-				for( j2b=0; j2b<blowup; j2b++ )
-				for( i2b=0; i2b<blowup; i2b++ ) {
-#ifdef CHECK_MEM
-					if( il*blowup+i2b + jl*nxb*blowup + j2b*nxb >= array_size ) { fprintf( stderr, "mem error 016\n" ); exit(-1); }
-#endif
-					*(big_data + il*blowup+i2b + jl*nxb*blowup + j2b*nxb ) = base_val;
-					}
-				}
-			}
+	sl->factor = factor;
+	sl->method = method;
+	sl->nx     = nx;
+	sl->ny     = ny;
+	sl->data   = (float *)malloc( nx*ny*sizeof(float) );
+	if( sl->data == NULL ) {
+		fprintf( stderr, "ncview: add_shrink_level: failed to allocate %ld bytes\n", nx*ny*sizeof(float) );
+		exit( -1 );
+		}
+
+	return( sl );
+}
+
+/******************************************************************************
+ * Throw away the shrunken versions of the view's data.  This must be called
+ * whenever the data in the view changes.
+ */
+	void
+invalidate_shrink_levels( View *v )
+{
+	int	i;
+
+	for( i=0; i<v->n_shrink_levels; i++ )
+		free( v->shrink_levels[i].data );
+	if( v->shrink_levels != NULL )
+		free( v->shrink_levels );
+
+	v->shrink_levels   = NULL;
+	v->n_shrink_levels = 0;
+}
 
-		}	/* end of BLOWUP_BILINEAR case */
+/******************************************************************************
+ * Actually do the "blowup" of the FLOATING POINT (not pixel) data, converting 
+ * it to the large version by either interpolation or replication.
+ * NOTE this routine is only called when options.blowup > 0!
+ */
+	void
+expand_data( float *big_data, View *v, size_t array_size )
+{
+	expand_block( big_data, (float *)v->data, 
+		*(v->variable->size + v->x_axis_id),
+		*(v->variable->size + v->y_axis_id),
+		v->variable->fill_value, options.blowup, options.blowup_type, array_size );
+}
+
+/******************************************************************************
+ * Blow up only the part of the data that ends up in the region of the big
+ * array that starts at (x0,y0) and is nx by ny in size, putting the result
+ * into 'region_data' (which is nx by ny).  We expand a block of the little
+ * array that covers the region with a couple of extra points on each side,
+ * so that the interpolated values in the region come out exactly as they 
+ * would if the whole field were expanded; then we just copy out the region.
+ */
+	static void
+expand_data_region( float *region_data, View *v, size_t x0, size_t y0, size_t nx, size_t ny )
+{
+	size_t	nxl, nyl, il0, il1, jl0, jl1, nxl_blk, nyl_blk, nxb_blk, j, i;
+	long	blowup;
+	float	*little, *big;
+
+	blowup = options.blowup;
+	nxl = *(v->variable->size + v->x_axis_id);
+	nyl = *(v->variable->size + v->y_axis_id);
+
+	/* Block of the little array to expand; il1 and jl1 are one past the end */
+	il0 = x0/blowup;
+	il0 = (il0 > 2) ? il0-2 : 0;
+	jl0 = y0/blowup;
+	jl0 = (jl0 > 2) ? jl0-2 : 0;
+	il1 = (x0+nx-1)/blowup + 3;
+	if( il1 > nxl )
+		il1 = nxl;
+
+	/* When interpolating, expand_block extrapolates each row past the
+	 * right edge by one point too many, which ends up in the first column
+	 * of the row above.  To get the same first column as a full render,
+	 * the block has to have the same right edge.
+	 */
+	if( (il0 == 0) && (options.blowup_type == BLOWUP_BILINEAR) )
+		il1 = nxl;
+	jl1 = (y0+ny-1)/blowup + 3;
+	if( jl1 > nyl )
+		jl1 = nyl;
+	nxl_blk = il1 - il0;
+	nyl_blk = jl1 - jl0;
+	nxb_blk = nxl_blk*blowup;
+
+	little = (float *)malloc( nxl_blk*nyl_blk*sizeof(float) );
+	big    = (float *)malloc( nxb_blk*nyl_blk*blowup*sizeof(float) );
+	if( (little == NULL) || (big == NULL) ) {
+		fprintf( stderr, "ncview: expand_data_region: can't allocate data expansion arrays\n" );
+		exit( -1 );
+		}
+
+	for( j=0; j<nyl_blk; j++ )
+		for( i=0; i<nxl_blk; i++ )
+			*(little + i + j*nxl_blk) = *((float *)v->data + (i+il0) + (j+jl0)*nxl);
+
+	expand_block( big, little, nxl_blk, nyl_blk, v->variable->fill_value, 
+		blowup, options.blowup_type, nxb_blk*nyl_blk*blowup );
+
+	for( j=0; j<ny; j++ )
+		memcpy( region_data + j*nx, big + (x0 - il0*blowup) + (y0 + j - jl0*blowup)*nxb_blk, 
+			nx*sizeof(float) );
+
+	free( little );
+	free( big );
 }
 
 /******************************************************************************
@@ -2423,3 +2895,365 @@ int unpack_groupname( char *varname, int ig, char *groupname )
 	return( 0 );
 }
 
+
+/******************************************************************************
+ * Milliseconds of wall-clock time since *t0, which was set by gettimeofday().
+ */
+	double
+ms_since( struct timeval *t0 )
+{
+	struct timeval	now;
+
+	gettimeofday( &now, NULL );
+	return( (now.tv_sec - t0->tv_sec)*1000.0 + (now.tv_usec - t0->tv_usec)*0.001 );
+}
+
+/******************************************************************************
+ * Make an index onto the n values in 'values', for use by coord_index_lookup.
+ * The index doesn't copy the values, so they have to stay put while it's
+ * in use.  Returns NULL if there isn't enough memory.
+ */
+	CoordIndex *
+coord_index_new( float *values, size_t n )
+{
+	CoordIndex	*ci;
+	size_t		i;
+	int		incr, decr;
+
+	ci = (CoordIndex *)malloc( sizeof(CoordIndex) );
+	if( ci == NULL )
+		return( NULL );
+	ci->values = values;
+	ci->n      = n;
+	ci->mid    = NULL;
+
+	/* Only values that strictly increase or decrease can be binary
+	 * searched.  Anything else (including repeated values) gets the
+	 * slow way.
+	 */
+	incr = decr = (n > 1);
+	for( i=1; i<n; i++ ) {
+		if( !(values[i] > values[i-1]) )
+			incr = FALSE;
+		if( !(values[i] < values[i-1]) )
+			decr = FALSE;
+		}
+	if( incr )
+		ci->order = COORD_INCREASING;
+	else if( decr )
+		ci->order = COORD_DECREASING;
+	else
+		ci->order = COORD_UNORDERED;
+
+	if( ci->order != COORD_UNORDERED ) {
+		ci->mid = (float *)malloc( (n-1)*sizeof(float) );
+		if( ci->mid == NULL ) {
+			free( ci );
+			return( NULL );
+			}
+		for( i=0; i<n-1; i++ )
+			ci->mid[i] = 0.5*(values[i] + values[i+1]);
+		}
+
+	return( ci );
+}
+
+/******************************************************************************/
+	void
+coord_index_free( CoordIndex *ci )
+{
+	if( ci == NULL )
+		return;
+	if( ci->mid != NULL )
+		free( ci->mid );
+	free( ci );
+}
+
+/******************************************************************************
+ * Returns the index of the value that is closest to 'value', or -1 if 'value'
+ * is off either end of the values.  When two values are equally close, the
+ * one with the lower index wins.
+ */
+	long
+coord_index_lookup( CoordIndex *ci, float value )
+{
+	float	*vals, dist, min_dist;
+	size_t	i, lo, hi, k, n;
+
+	vals = ci->values;
+	n    = ci->n;
+
+	/* See if off ends of values ... remember that they can be reversed */
+	if( vals[0] > vals[n-1] ) {
+		if( (value > vals[0]) || (value < vals[n-1]) )
+			return( -1 );
+		}
+	else
+		{
+		if( (value < vals[0]) || (value > vals[n-1]) )
+			return( -1 );
+		}
+
+	if( ci->order == COORD_UNORDERED ) {
+		min_dist = 1.0e35;
+		k = 0;
+		for( i=0; i<n; i++ ) {
+			dist = fabs(vals[i] - value);
+			if( dist < min_dist ) {
+				min_dist = dist;
+				k = i;
+				}
+			}
+		return( (long)k );
+		}
+
+	/* Find the first midpoint that's not before 'value'; the value
+	 * just before that midpoint is the closest one.
+	 */
+	lo = 0;
+	hi = n-1;
+	while( lo < hi ) {
+		k = (lo + hi)/2;
+		if( (ci->order == COORD_INCREASING) ? (ci->mid[k] < value) : (ci->mid[k] > value) )
+			lo = k+1;
+		else
+			hi = k;
+		}
+	k = lo;
+
+	/* The midpoints are rounded, so when 'value' is right on one of
+	 * them, settle it by the distances themselves
+	 */
+	if( (k > 0) && (fabs(vals[k-1] - value) <= fabs(vals[k] - value)) )
+		k--;
+	else if( (k < n-1) && (fabs(vals[k+1] - value) < fabs(vals[k] - value)) )
+		k++;
+
+	return( (long)k );
+}
+
+/******************************************************************************
+ * The coordinate index of dimension d, which is n long.  It's made the first
+ * time it's asked for and kept with the dim after that.  Returns NULL if it
+ * can't be made.
+ */
+	CoordIndex *
+dim_coord_index( NCDim *d, size_t n )
+{
+	if( (d->coord_index != NULL) &&
+			((d->coord_index->values != d->values) || (d->coord_index->n != n)) ) {
+		coord_index_free( d->coord_index );
+		d->coord_index = NULL;
+		}
+
+	if( (d->coord_index == NULL) && (d->values != NULL) && (n > 0) )
+		d->coord_index = coord_index_new( d->values, n );
+
+	return( d->coord_index );
+}
+
+/******************************************************************************
+ * Make an index onto the n locations (xvals[i], yvals[i]), for use by
+ * point_index_nearest.  The index doesn't copy the locations, so they have
+ * to stay put while it's in use.  Locations that are NaN are left out.
+ * Returns NULL if there isn't enough memory.
+ */
+	PointIndex *
+point_index_new( float *xvals, float *yvals, size_t n )
+{
+	PointIndex	*pi;
+	size_t		i, n_ok, *fill;
+	long		b, nbins;
+	double		xmin, xmax, ymin, ymax, w, h;
+
+	pi = (PointIndex *)malloc( sizeof(PointIndex) );
+	if( pi == NULL )
+		return( NULL );
+	pi->xvals     = xvals;
+	pi->yvals     = yvals;
+	pi->n         = n;
+	pi->bin_start = NULL;
+	pi->pts       = NULL;
+
+	n_ok = 0L;
+	xmin = ymin =  1.0e35;
+	xmax = ymax = -1.0e35;
+	for( i=0; i<n; i++ ) {
+		if( (xvals[i] != xvals[i]) || (yvals[i] != yvals[i]) )
+			continue;
+		n_ok++;
+		if( xvals[i] < xmin ) xmin = xvals[i];
+		if( xvals[i] > xmax ) xmax = xvals[i];
+		if( yvals[i] < ymin ) ymin = yvals[i];
+		if( yvals[i] > ymax ) ymax = yvals[i];
+		}
+	if( n_ok == 0L ) {
+		xmin = xmax = ymin = ymax = 0.0;
+		}
+
+	/* About 4 locations to a bin, with the bins about square */
+	w = (xmax > xmin) ? (xmax - xmin) : 0.0;
+	h = (ymax > ymin) ? (ymax - ymin) : 0.0;
+	nbins = n_ok/4 + 1;
+	if( (w > 0.0) && (h > 0.0) ) {
+		pi->nbx = (long)sqrt( nbins*w/h );
+		if( pi->nbx < 1 )
+			pi->nbx = 1;
+		if( pi->nbx > nbins )
+			pi->nbx = nbins;
+		pi->nby = nbins / pi->nbx;
+		}
+	else if( w > 0.0 ) {
+		pi->nbx = nbins;
+		pi->nby = 1;
+		}
+	else
+		{
+		pi->nbx = 1;
+		pi->nby = (h > 0.0) ? nbins : 1;
+		}
+	pi->x0     = xmin;
+	pi->y0     = ymin;
+	pi->bin_dx = (w > 0.0) ? w/pi->nbx : 1.0;
+	pi->bin_dy = (h > 0.0) ? h/pi->nby : 1.0;
+	nbins = pi->nbx * pi->nby;
+
+	/* Sort the locations into their bins */
+	pi->bin_start = (size_t *)calloc( nbins+1, sizeof(size_t) );
+	pi->pts       = (size_t *)malloc( (n_ok+1)*sizeof(size_t) );
+	fill          = (size_t *)malloc( nbins*sizeof(size_t) );
+	if( (pi->bin_start == NULL) || (pi->pts == NULL) || (fill == NULL) ) {
+		if( fill != NULL )
+			free( fill );
+		point_index_free( pi );
+		return( NULL );
+		}
+	for( i=0; i<n; i++ )
+		if( (xvals[i] == xvals[i]) && (yvals[i] == yvals[i]) )
+			pi->bin_start[ point_index_bin( pi, xvals[i], yvals[i] ) + 1 ]++;
+	for( b=0; b<nbins; b++ ) {
+		pi->bin_start[b+1] += pi->bin_start[b];
+		fill[b] = pi->bin_start[b];
+		}
+	for( i=0; i<n; i++ )
+		if( (xvals[i] == xvals[i]) && (yvals[i] == yvals[i]) )
+			pi->pts[ fill[ point_index_bin( pi, xvals[i], yvals[i] ) ]++ ] = i;
+
+	free( fill );
+	return( pi );
+}
+
+/******************************************************************************/
+	void
+point_index_free( PointIndex *pi )
+{
+	if( pi == NULL )
+		return;
+	if( pi->bin_start != NULL )
+		free( pi->bin_start );
+	if( pi->pts != NULL )
+		free( pi->pts );
+	free( pi );
+}
+
+/******************************************************************************
+ * Which bin location (x,y) falls in.  Locations off the edges go in the
+ * nearest bin on the edge.
+ */
+	static long
+point_index_bin( PointIndex *pi, float x, float y )
+{
+	long	bx, by;
+
+	point_index_bin_xy( pi, x, y, &bx, &by );
+	return( bx + by*pi->nbx );
+}
+
+/******************************************************************************/
+	static void
+point_index_bin_xy( PointIndex *pi, float x, float y, long *bx, long *by )
+{
+	double	fx, fy;
+
+	fx = (x - pi->x0)/pi->bin_dx;
+	fy = (y - pi->y0)/pi->bin_dy;
+	*bx = (fx < 0.0) ? 0 : ((fx >= pi->nbx) ? pi->nbx-1 : (long)fx);
+	*by = (fy < 0.0) ? 0 : ((fy >= pi->nby) ? pi->nby-1 : (long)fy);
+}
+
+/******************************************************************************
+ * Returns the index of the location that is closest to (x,y), or -1 if
+ * there aren't any.  Distance is measured in the units of the locations
+ * themselves, with no allowance for longitude wrapping around.  When two
+ * locations are equally close, the one with the lower index wins.
+ *
+ * This looks through the bins in rings around the one that (x,y) is in,
+ * and stops once everything in the next ring has to be farther away than
+ * the best location found so far.
+ */
+	long
+point_index_nearest( PointIndex *pi, float x, float y )
+{
+	long	bx, by, r, ix, iy, best, b;
+	size_t	k, p;
+	double	dx, dy, d, best_d, gap, g;
+
+	point_index_bin_xy( pi, x, y, &bx, &by );
+
+	best   = -1L;
+	best_d = 0.0;
+	for( r=0; ; r++ ) {
+		for( iy=by-r; iy<=by+r; iy++ ) {
+			if( (iy < 0) || (iy >= pi->nby) )
+				continue;
+			for( ix=bx-r; ix<=bx+r; ix++ ) {
+				if( (ix < 0) || (ix >= pi->nbx) )
+					continue;
+				/* Only the bins on the ring itself are new */
+				if( (iy != by-r) && (iy != by+r) && (ix != bx-r) && (ix != bx+r) )
+					continue;
+				b = ix + iy*pi->nbx;
+				for( k=pi->bin_start[b]; k<pi->bin_start[b+1]; k++ ) {
+					p  = pi->pts[k];
+					dx = x - pi->xvals[p];
+					dy = y - pi->yvals[p];
+					d  = dx*dx + dy*dy;
+					if( (best == -1L) || (d < best_d) || ((d == best_d) && (p < best)) ) {
+						best   = p;
+						best_d = d;
+						}
+					}
+				}
+			}
+
+		/* How close could anything in the next ring out be?  Sides
+		 * where the rings have already reached the edge of the bins
+		 * don't count.
+		 */
+		gap = 1.0e35;
+		if( bx-r > 0 ) {
+			g = x - (pi->x0 + (bx-r)*pi->bin_dx);
+			if( g < gap ) gap = g;
+			}
+		if( bx+r < pi->nbx-1 ) {
+			g = (pi->x0 + (bx+r+1)*pi->bin_dx) - x;
+			if( g < gap ) gap = g;
+			}
+		if( by-r > 0 ) {
+			g = y - (pi->y0 + (by-r)*pi->bin_dy);
+			if( g < gap ) gap = g;
+			}
+		if( by+r < pi->nby-1 ) {
+			g = (pi->y0 + (by+r+1)*pi->bin_dy) - y;
+			if( g < gap ) gap = g;
+			}
+		if( gap == 1.0e35 )
+			break;		/* Been through all the bins */
+		if( gap < 0.0 )
+			gap = 0.0;
+		if( (best != -1L) && (best_d < gap*gap) )
+			break;
+		}
+
+	return( best );
+}
@@ -50,6 +50,15 @@ View  *view = NULL;
 
 /* See comments in routine "view_draw" */
 static int 	lockout_view_changes = FALSE;
+static char	scan_place_label[1024] = "";	/* What set_scan_view last put on the scan place label */
+
+/* During fast animation the frame labels are only redone every so often,
+ * since formatting the time and the scalar coordinates costs more than
+ * drawing some frames, and nobody can read them at that speed anyway.
+ */
+#define SCAN_LABEL_THROTTLE_MS	200.0
+static struct timeval	scan_label_time;
+static int		scan_labels_stale = FALSE;
 
 /* Saved x/y values that are on the XY plot, used later for
  * dumping out.
@@ -80,6 +89,10 @@ static void 		set_scan_place( View *new_view, NCVar *var, View *old_view );
 static void 		initial_set_scan_place( View *view, NCVar *var );
 static void 		re_set_scan_place( View *new_view, NCVar *new_var, View *old_view );
 static void		calculate_blowup( View *view, NCVar *var, int val_to_set_to );
+static void		set_blowup_label( void );
+static void		resize_view_pixels( int redraw_flag );
+static float		fit_zoom( size_t x_size, size_t y_size );
+static int		zoom_to_blowup( float zoom );
 static void 		draw_file_info( NCVar *var );
 static void 		label_dimensions( View *view );
 static void 		show_current_dim_values( View *view );
@@ -261,6 +274,7 @@ set_scan_variable( NCVar *var )
 			do_overlay(OVERLAY_NONE,NULL,TRUE);
 
 		/* Release the old storage */
+		invalidate_shrink_levels( old_view );
 		free( old_view->data      );
 		free( old_view->pixels    );
 		free( old_view->var_place );
@@ -289,8 +303,11 @@ set_scan_variable( NCVar *var )
 		}
 
 	/* Set the min and maxes of the data */
-	if( !view->variable->have_set_range )
+	if( !view->variable->have_set_range ) {
+		trace_begin( "init_min_max", "compute", var->name );
 		init_min_max( var );
+		trace_end( "init_min_max", "compute" );
+		}
 
 	/* If we are automatically putting on overlays, do so now */
 	xdim = *(view->variable->dim + view->x_axis_id);
@@ -515,6 +532,14 @@ set_scan_view( size_t scan_place )
 	dim = *(view->variable->dim + view->scan_axis_id);
 	dim_name = dim->name;
 	*(view->var_place + view->scan_axis_id) = scan_place;
+	view->data_status = VDS_INVALID;
+
+	if( (which_button_pressed() != BUTTON_PAUSE) &&
+	    (ms_since( &scan_label_time ) < SCAN_LABEL_THROTTLE_MS) ) {
+		scan_labels_stale = TRUE;
+		return;
+		}
+
 	snprintf( view_place, 1023, "frame %1ld/%1ld ", scan_place+1, size );
 
 	/* type is the data type of the dimension--can be float or character */
@@ -562,9 +587,9 @@ set_scan_view( size_t scan_place )
 		; /* don't have to do anything, since string-type dimval
 		   * is already in variable "temp_string"
 		   */
-	in_set_label( LABEL_SCAN_PLACE, view_place );
+	strcpy( scan_place_label, view_place );
+	view_update_scan_label();
 	in_set_cur_dim_value( dim_name, temp_string );
-	view->data_status = VDS_INVALID;
 	if( options.want_extra_info ) {
 		in_set_label( LABEL_CCINFO_2, temp_string );
 		}
@@ -574,6 +599,27 @@ set_scan_view( size_t scan_place )
 	 */
 	view_construct_scalar_coord_str( scalar_coord_str, 1020 );
 	in_set_label( LABEL_SCALAR_DIMS, scalar_coord_str );
+
+	scan_labels_stale = FALSE;
+	gettimeofday( &scan_label_time, NULL );
+}
+
+/********************************************************************************
+ * If set_scan_view skipped the labels during an animation, put them up
+ * now.  Called when the animation stops.
+ */
+	void
+view_flush_scan_labels( void )
+{
+	int	data_status;
+
+	if( (! scan_labels_stale) || (view == NULL) || (view->scan_axis_id == -1) )
+		return;
+
+	/* Only the labels are out of date, not the data */
+	data_status = view->data_status;
+	set_scan_view( *(view->var_place + view->scan_axis_id) );
+	view->data_status = data_status;
 }
 
 /********************************************************************************
@@ -583,10 +629,12 @@ set_scan_view( size_t scan_place )
 view_draw( int allow_framestore_usage, int force_range_to_frame )
 {
 	long		i; 
-	size_t		x_size, y_size, scan_size, scaled_x_size, scaled_y_size, framesize, frameno;
+	size_t		x_size, y_size, scan_size, scaled_x_size, scaled_y_size, frameno;
+	size_t		rx0, ry0, rnx, rny;
 	static int	last_x_size=0, last_y_size=0;
-	int		must_recalc_range;
+	int		must_recalc_range, drawn, partial, from_levels;
 	float		min, max, dat;
+	ncv_pixel	*levels;
 
 	/* The reason why we have to lockout the possiblity that this
 	 * routine is called WHILE it is executing is tricky.  The 
@@ -610,6 +658,9 @@ view_draw( int allow_framestore_usage, int force_range_to_frame )
 		return(0);
 		}
 
+	timing_frame_start();
+	trace_begin( "view_draw", "draw", NULL );
+
 	x_size = *(view->variable->size + view->x_axis_id);
 	y_size = *(view->variable->size + view->y_axis_id);
 
@@ -641,7 +692,6 @@ view_draw( int allow_framestore_usage, int force_range_to_frame )
 
 	view_get_scaled_size( options.blowup, x_size, y_size, &scaled_x_size, &scaled_y_size );
 
-	framesize = scaled_x_size * scaled_y_size;
 	if( view->scan_axis_id == -1 )
 		frameno = 0;
 	else
@@ -657,14 +707,25 @@ view_draw( int allow_framestore_usage, int force_range_to_frame )
 						frameno );
 		}
 
-	/* Is this frame stored in the framestore? */
-	if( framestore.valid && allow_framestore_usage ) {
-		if( *(framestore.frame_valid + frameno) == TRUE ) {
-			if( options.debug )
-				printf( "drawing from framestore...\n" );
-			in_draw_2d_field( (framestore.frame + frameno*framesize), 
-				scaled_x_size, scaled_y_size, frameno );
+	/* Is this frame already on the X server, or stored in the framestore? */
+	if( allow_framestore_usage ) {
+		drawn = FALSE;
+		if( (last_x_size == scaled_x_size) && (last_y_size == scaled_y_size))
+			drawn = in_draw_cached_2d_field( scaled_x_size, scaled_y_size, frameno );
+		if( ! drawn ) {
+			timing_start( TIMING_STORE );
+			drawn = framestore_get( FRAMES_DISPLAY, frameno, scaled_x_size, scaled_y_size, view->pixels );
+			timing_stop( TIMING_STORE );
+			if( drawn ) {
+				if( options.debug )
+					printf( "drawing from framestore...\n" );
+				in_draw_2d_field( view->pixels, scaled_x_size, scaled_y_size, frameno );
+				}
+			}
+		if( drawn ) {
 			lockout_view_changes = FALSE;
+			timing_frame_end();
+			trace_end( "view_draw", "draw" );
 
 			if( view->scan_axis_id != -1 ) {
 				scan_size  = *(view->variable->size  + view->scan_axis_id);
@@ -676,7 +737,16 @@ view_draw( int allow_framestore_usage, int force_range_to_frame )
 			}
 		}
 
-	if( view->data_status == VDS_INVALID ) {
+	/* If we have this frame saved at data resolution, it can be made
+	 * from that without going back to the data, as long as that gives
+	 * the same pixels at this blowup.
+	 */
+	from_levels = allow_framestore_usage && levels_match_data() && framestore_has( FRAMES_DATA, frameno );
+	if( from_levels ) {
+		if( options.debug )
+			printf( "making frame from saved color levels...\n" );
+		}
+	else if( view->data_status == VDS_INVALID ) {
 		if( options.debug )
 			printf( "Reading data to contour...\n" );
 		fill_view_data( view );
@@ -687,31 +757,87 @@ view_draw( int allow_framestore_usage, int force_range_to_frame )
 			printf( "NOT reading data to contour, since data is valid (%d)\n", view->data_status );
 		}
 
-	if( options.debug )
+	if( (last_x_size != scaled_x_size) ||
+	    (last_y_size != scaled_y_size)) {
+		last_x_size = scaled_x_size;
+		last_y_size = scaled_y_size;
+		in_set_2d_size  ( scaled_x_size, scaled_y_size );
+		}
+
+	/* When the blown-up image is larger than the window, only render
+	 * the part that can be seen.  The rest is done if the user scrolls
+	 * to it.  Printing, dumping, and streaming frames need the whole
+	 * image.
+	 */
+	partial = FALSE;
+	if( allow_framestore_usage && ((options.blowup > 1) || (options.zoom > 0.0)) &&
+	    (! options.dump_frames) && (options.stream_file == NULL) )
+		partial = in_get_visible_region( scaled_x_size, scaled_y_size, &rx0, &ry0, &rnx, &rny );
+	if( partial ) {
+		view->render_x0 = rx0;
+		view->render_y0 = ry0;
+		view->render_nx = rnx;
+		view->render_ny = rny;
+		}
+
+	if( from_levels ) {
+		levels = (ncv_pixel *)malloc( x_size*y_size*sizeof(ncv_pixel) );
+		if( levels == NULL ) {
+			fprintf( stderr, "ncview: view_draw: can't allocate %ld bytes\n", x_size*y_size*sizeof(ncv_pixel) );
+			exit( -1 );
+			}
+		timing_start( TIMING_STORE );
+		framestore_get( FRAMES_DATA, frameno, x_size, y_size, levels );
+		timing_stop( TIMING_STORE );
+		timing_start( TIMING_RESAMPLE );
+		if( partial )
+			levels_to_pixels( view, levels, rx0, ry0, rnx, rny );
+		else
+			levels_to_pixels( view, levels, 0L, 0L, scaled_x_size, scaled_y_size );
+		timing_stop( TIMING_RESAMPLE );
+		free( levels );
+		}
+	else if( options.debug )
 		printf( "Calling data_to_pixels...\n" );
-	if( data_to_pixels( view ) < 0 ) {
+	if( (! from_levels) && (data_to_pixels( view ) < 0) ) {
+		view->render_nx = 0L;
 		in_timer_clear();
 		if( view->variable->global_min == view->variable->global_max )
 			invalidate_variable( view->variable );
 		lockout_view_changes = FALSE;
+		trace_end( "view_draw", "draw" );
 		return( -1 );
 		}
-
-	if( (last_x_size != scaled_x_size) ||
-	    (last_y_size != scaled_y_size)) {
-		last_x_size = scaled_x_size;
-		last_y_size = scaled_y_size;
-		in_set_2d_size  ( scaled_x_size, scaled_y_size );
-		}
+	view->render_nx = 0L;
 
 	if( options.debug )
 		printf( "Calling draw_2d_field...\n" );
-	in_draw_2d_field( view->pixels, scaled_x_size, scaled_y_size, frameno );
+	if( partial )
+		in_draw_2d_field_region( view->pixels, scaled_x_size, scaled_y_size, frameno, rx0, ry0, rnx, rny );
+	else
+		in_draw_2d_field( view->pixels, scaled_x_size, scaled_y_size, frameno );
+
+	/* Only whole frames can go into the framestore */
+	if( (framestore.valid == TRUE) && (! partial) ) {
+		timing_start( TIMING_STORE );
+		framestore_put( FRAMES_DISPLAY, frameno, scaled_x_size, scaled_y_size, view->pixels );
+		timing_stop( TIMING_STORE );
+		}
 
-	if( framestore.valid == TRUE ) {
-		for( i=0; i<framesize; i++ )
-			*(framestore.frame + frameno*framesize + i) = *(view->pixels + i);
-		*(framestore.frame_valid + frameno) = TRUE;
+	/* Keep the frame at data resolution too, so it can be redrawn at any
+	 * blowup; this is cheap compared to the blown-up image.
+	 */
+	if( (framestore.valid == TRUE) && (! from_levels) && (! framestore_has( FRAMES_DATA, frameno )) ) {
+		levels = (ncv_pixel *)malloc( x_size*y_size*sizeof(ncv_pixel) );
+		if( levels != NULL ) {
+			timing_start( TIMING_QUANTIZE );
+			data_to_levels( view, levels );
+			timing_stop( TIMING_QUANTIZE );
+			timing_start( TIMING_STORE );
+			framestore_put( FRAMES_DATA, frameno, x_size, y_size, levels );
+			timing_stop( TIMING_STORE );
+			free( levels );
+			}
 		}
 
 	/* If we just drew the last time entry for this var, then
@@ -725,6 +851,8 @@ view_draw( int allow_framestore_usage, int force_range_to_frame )
 			}
 		}
 
+	timing_frame_end();
+	trace_end( "view_draw", "draw" );
 	lockout_view_changes = FALSE;
 	return( 0 );
 }
@@ -737,7 +865,7 @@ view_check_new_data( int unused )
 {
 	size_t 	file_var_size[MAX_NC_DIMS], *t, n_other;
 	int	i, has_grown, ierr, t_ncid, timelike_index;
-	size_t	dt, nt_new, n_scan_entries, n_extra_frames, storage_size, old_nt;
+	size_t	dt, nt_new, n_scan_entries, n_extra_frames;
 	char	message[1024], rate_units[50];
 	time_t	tt;
 	long	nframes_tot, delta_time;
@@ -826,34 +954,17 @@ view_check_new_data( int unused )
 		}
 	in_set_label( LABEL_TITLE, message );
 
-	/* See if we need to reallocate the framestore */
-	if( nt_new >= framestore.nt ) {
-		old_nt = framestore.nt;
+	/* See if we need to make the framestore bigger */
+	if( framestore.valid && (nt_new >= framestore.nt) ) {
 		n_scan_entries = *(view->variable->size + view->scan_axis_id);
 		n_extra_frames = floor( n_scan_entries * 0.2 ) + 1;
 		if( n_extra_frames < 25 )
 			n_extra_frames = 25;
-		framestore.nt = nt_new + n_extra_frames;
-		storage_size  = framestore.nx * framestore.ny * framestore.nt;
 
 		if( options.debug )
-			printf( "reallocating framestore to new nt=%ld\n", framestore.nt );
+			printf( "growing framestore to new nt=%ld\n", nt_new + n_extra_frames );
 
-		framestore.frame = (ncv_pixel *)realloc( framestore.frame, storage_size*sizeof(ncv_pixel) );
-		if( framestore.frame == NULL ) {
-			framestore.valid = FALSE;
-			return;
-			}
-
-		framestore.frame_valid = (int *)realloc( framestore.frame_valid, framestore.nt*sizeof(int) );
-		if( framestore.frame_valid == NULL ) {
-			framestore.valid = FALSE;
-			return;
-			}
-
-		/* Initialize to NOT a valid frame for the new frames */
-		for( i=old_nt; i<framestore.nt; i++ )
-			*(framestore.frame_valid+i) = FALSE;
+		framestore_grow( nt_new + n_extra_frames );
 		}
 
 	view->variable->size[ timelike_index ] = nt_new;
@@ -1136,6 +1247,7 @@ fill_view_data( View *v )
 		}
 
 	fi_get_data( v->variable, v->var_place, count, v->data );
+	invalidate_shrink_levels( v );
 
 	v->data_status = VDS_VALID;
 	free( count );
@@ -1147,10 +1259,6 @@ fill_view_data( View *v )
 	void
 view_change_blowup( int delta, int redraw_flag, int view_var_is_valid )
 {
-	size_t	x_size, y_size, scaled_x_size, scaled_y_size;
-	char	blowup_label[32];
-	int	changed_size;
-
 	in_set_cursor_busy();
 
 	/* Sequence of 'options.blowup' should be: ..., -4, -3, -2, 1, 2, 3, ... */
@@ -1171,16 +1279,75 @@ view_change_blowup( int delta, int redraw_flag, int view_var_is_valid )
 			options.blowup += delta;
 		}
 
-	if( options.blowup > 0 ) 
+	set_blowup_label();
+
+	if( view_var_is_valid ) {
+		view->variable->user_set_blowup = options.blowup;
+		}
+
+	resize_view_pixels( redraw_flag );
+	in_set_cursor_normal();
+}
+
+/********************************************************************************
+ * Change to a zoom factor that need not be an integer.  If 'fit' is TRUE, the
+ * zoom is set so the image just fits in the largest window we allow.  If
+ * 'zoom' is 0 and 'fit' is FALSE, go back to integer blowups, starting from
+ * the one nearest the current zoom.
+ */
+	void
+view_set_zoom( float zoom, int fit, int redraw_flag )
+{
+	in_set_cursor_busy();
+
+	if( fit )
+		zoom = fit_zoom( *(view->variable->size + view->x_axis_id),
+				 *(view->variable->size + view->y_axis_id) );
+	if( zoom > 0.0 ) {
+		options.zoom     = zoom;
+		options.zoom_fit = fit;
+		}
+	else
+		{
+		if( options.zoom > 0.0 )
+			options.blowup = zoom_to_blowup( options.zoom );
+		options.zoom     = 0.0;
+		options.zoom_fit = FALSE;
+		view->variable->user_set_blowup = options.blowup;
+		}
+
+	set_blowup_label();
+	resize_view_pixels( redraw_flag );
+	in_set_cursor_normal();
+}
+
+/********************************************************************************/
+	static void
+set_blowup_label( void )
+{
+	char	blowup_label[32];
+
+	if( options.zoom_fit )
+		snprintf( blowup_label, 31, "M fit" );
+	else if( options.zoom > 0.0 )
+		snprintf( blowup_label, 31, "M X%.3g", options.zoom );
+	else if( options.blowup > 0 ) 
 		snprintf( blowup_label, 31, "M X%1d", options.blowup );
 	else
 		snprintf( blowup_label, 31, "M 1/%1d", -options.blowup );
 
         in_set_label( LABEL_BLOWUP, blowup_label );
+}
 
-	if( view_var_is_valid ) {
-		view->variable->user_set_blowup = options.blowup;
-		}
+/********************************************************************************
+ * The size of the image has changed; make new pixel storage for it, and 
+ * redraw if requested.
+ */
+	static void
+resize_view_pixels( int redraw_flag )
+{
+	size_t	x_size, y_size, scaled_x_size, scaled_y_size;
+	int	changed_size;
 
 	free( view->pixels );
 
@@ -1192,8 +1359,8 @@ view_change_blowup( int delta, int redraw_flag, int view_var_is_valid )
 
 	if( options.save_frames == TRUE ) {
 		if( options.debug )
-			fprintf( stderr, "calling init_saveframes from view_change_blowup\n" );
-		init_saveframes();
+			fprintf( stderr, "calling resize_saveframes from view_change_blowup\n" );
+		resize_saveframes();
 		}
 
 	if( redraw_flag ) {
@@ -1205,7 +1372,38 @@ view_change_blowup( int delta, int redraw_flag, int view_var_is_valid )
 		if( changed_size < 0 ) 
 			view_draw( FALSE, FALSE );
 		}
-	in_set_cursor_normal();
+}
+
+/********************************************************************************
+ * The zoom that makes the largest image that fits in the window without
+ * scrollbars.
+ */
+	static float
+fit_zoom( size_t x_size, size_t y_size )
+{
+	size_t	max_width, max_height;
+	double	zx, zy;
+
+	in_get_max_2d_size( &max_width, &max_height );
+	zx = (double)max_width  / (double)x_size;
+	zy = (double)max_height / (double)y_size;
+
+	return( (float)((zx < zy) ? zx : zy) );
+}
+
+/********************************************************************************
+ * The integer blowup (as in options.blowup) closest to the given zoom factor
+ */
+	static int
+zoom_to_blowup( float zoom )
+{
+	int	n;
+
+	if( zoom >= 1.0 )
+		return( (int)(zoom + 0.5) );
+
+	n = (int)(1.0/zoom + 0.5);
+	return( (n <= 1) ? 1 : -n );
 }
 
 /**************************************************************************************/
@@ -1621,16 +1819,13 @@ beep()
 	void
 init_saveframes()
 {
-	long	i;
-	size_t	storage_size, n_scan_entries, xsize, ysize, n_extra_frames;
-	char	err_message[132];
+	size_t	n_scan_entries, xsize, ysize, scaled_xsize, scaled_ysize, n_extra_frames;
 
-	if( options.save_frames == FALSE )
-		return;
+	in_invalidate_frame_cache();
 
-	if( framestore.frame != NULL ) {
-		free( framestore.frame );
-		free( framestore.frame_valid );
+	if( options.save_frames == FALSE ) {
+		prerender_cancel();
+		return;
 		}
 
 	if( view->scan_axis_id == -1 ) {
@@ -1644,55 +1839,162 @@ init_saveframes()
 		if( n_extra_frames < 10 )
 			n_extra_frames = 10;
 		}
-	framestore.nt = n_scan_entries + n_extra_frames;
 
 	xsize = *(view->variable->size + view->x_axis_id);
 	ysize = *(view->variable->size + view->y_axis_id);
-	view_get_scaled_size( options.blowup, xsize, ysize, &(framestore.nx), &(framestore.ny) );
-
-	storage_size =  framestore.nx * framestore.ny * framestore.nt;
+	view_get_scaled_size( options.blowup, xsize, ysize, &scaled_xsize, &scaled_ysize );
 
 	if( options.debug ) {
 		fprintf( stderr, "initializing saveframes:\n" );
 		fprintf( stderr, "	n_scan_entries: %ld\n", n_scan_entries );
 		fprintf( stderr, "	n_extra_frames: %ld\n", n_extra_frames );
-		fprintf( stderr, "	frame size: %ld\n", 
-				*(view->variable->size + view->x_axis_id) *
-				*(view->variable->size + view->y_axis_id) );
-		fprintf( stderr, "	total storage size:%ld\n", storage_size );
+		fprintf( stderr, "	frame size: %ld\n", scaled_xsize*scaled_ysize );
 		}
 
-	framestore.frame = (ncv_pixel *)malloc( storage_size*sizeof( ncv_pixel ));
-	if( framestore.frame == NULL ) {
-		framestore.valid = FALSE;
-		snprintf( err_message, 131, "Can't allocate space for frame store.\nRequested size: %.1f MB",
-				(float)(storage_size*sizeof( ncv_pixel ))/1000000. );
-		options.save_frames = FALSE;
-		in_error( err_message );
+	/* Frames are only kept as memory allows (see framestore.c), so
+	 * this can't fail for lack of space the way it once could.
+	 */
+	framestore_init( scaled_xsize, scaled_ysize, n_scan_entries + n_extra_frames );
+	prerender_restart();
+}
+
+/**************************************************************************************
+ * Like init_saveframes, but for when only the size the frames are shown at
+ * has changed (a new blowup or blowup type).  The frames saved at data
+ * resolution are still good, so they are kept.
+ */
+	void
+resize_saveframes()
+{
+	size_t	xsize, ysize, scaled_xsize, scaled_ysize;
+
+	if( (options.save_frames == FALSE) || (view == NULL) || (! framestore.valid) ) {
+		init_saveframes();
+		return;
 		}
-	else
-		{
-		framestore.valid = TRUE;
-		framestore.frame_valid = (int *)(malloc( framestore.nt * sizeof( int )));
-		for( i=0; i<framestore.nt; i++ )
-			*(framestore.frame_valid+i) = FALSE;
+
+	in_invalidate_frame_cache();
+
+	xsize = *(view->variable->size + view->x_axis_id);
+	ysize = *(view->variable->size + view->y_axis_id);
+	view_get_scaled_size( options.blowup, xsize, ysize, &scaled_xsize, &scaled_ysize );
+
+	framestore_resize( scaled_xsize, scaled_ysize );
+
+	/* Whether pre-rendering is any use depends on the blowup */
+	prerender_restart();
+}
+
+/**************************************************************************************
+ * Set up the view of a variable for the -bench and -batch modes, where
+ * there is no user interface.  This is the part of set_scan_variable that
+ * doesn't touch the display.  Returns -1 if the variable can't be shown
+ * as a 2-D field.
+ */
+	int
+view_init_headless( NCVar *var )
+{
+	View	*old_view;
+
+	old_view = view;
+	init_view( &view, var );
+	if( old_view != NULL ) {
+		invalidate_shrink_levels( old_view );
+		free( old_view->data      );
+		free( old_view->pixels    );
+		free( old_view->var_place );
+		free( old_view );
+		}
+	determine_scan_axes( view, var, NULL );
+	if( (var->effective_dimensionality < 2) || (view->x_axis_id == -1) || (view->y_axis_id == -1) )
+		return( -1 );
+	set_scan_place( view, var, NULL );
+	flip_if_inverted( view );
+	alloc_view_storage( view );
+
+	if( ! var->have_set_range ) {
+		trace_begin( "init_min_max", "compute", var->name );
+		init_min_max( var );
+		trace_end( "init_min_max", "compute" );
 		}
+
+	return( 0 );
+}
+
+/**************************************************************************************
+ * Read frame 'frameno' and turn it into view->pixels, for the -bench
+ * mode.  Returns -1 if the data can't be turned into pixels.
+ */
+	int
+view_render_headless( size_t frameno )
+{
+	if( view->scan_axis_id != -1 )
+		*(view->var_place + view->scan_axis_id) = frameno;
+	view->data_status = VDS_INVALID;
+
+	fill_view_data( view );
+	return( data_to_pixels( view ));
+}
+
+/**************************************************************************************
+ * Make sure view->pixels holds the whole of the frame being shown, for
+ * printing.  What's on the screen may have come from the X server's cache,
+ * or only the visible part may have been made, so view->pixels can't be
+ * used as it is.  The frame is taken from the framestore if it's there;
+ * otherwise it's made from the view's data without drawing anything (the
+ * data is read from the file first if it isn't already loaded).  Returns
+ * -1 if it can't be made.
+ */
+	int
+view_get_whole_frame( void )
+{
+	size_t	x_size, y_size, scaled_x_size, scaled_y_size, frameno;
+
+	x_size = *(view->variable->size + view->x_axis_id);
+	y_size = *(view->variable->size + view->y_axis_id);
+	view_get_scaled_size( options.blowup, x_size, y_size, &scaled_x_size, &scaled_y_size );
+
+	if( view->scan_axis_id == -1 )
+		frameno = 0;
+	else
+		frameno = *(view->var_place + view->scan_axis_id);
+
+	if( (view->data_status != VDS_EDITED) &&
+	    framestore_get( FRAMES_DISPLAY, frameno, scaled_x_size, scaled_y_size, view->pixels ))
+		return( 0 );
+
+	fill_view_data( view );
+	view->render_nx = 0L;
+	return( data_to_pixels( view ));
+}
+
+/**************************************************************************************
+ * Put the scan place back on its label, with the animation frame rate and
+ * how far along pre-rendering is, if those are going on.
+ */
+	void
+view_update_scan_label( void )
+{
+	char	label[1200];
+
+	if( (view == NULL) || (view->scan_axis_id == -1) || (strlen(scan_place_label) == 0) )
+		return;
+
+	snprintf( label, 1199, "%s%s%s", scan_place_label, play_status(), prerender_status() );
+	in_set_label( LABEL_SCAN_PLACE, label );
 }
 
 /**************************************************************************************/
 	void
 invalidate_all_saveframes()
 {
-	size_t	i;
+	in_invalidate_frame_cache();
 
 	if( view == NULL )
 		return;
 
-	if( (view->scan_axis_id == -1) || ( framestore.valid == FALSE ))
-		return;
-
-	for( i=0L; i<framestore.nt; i++ )
-		*(framestore.frame_valid+i) = FALSE;
+	framestore_invalidate();
+	prerender_restart();
 }
 
 /**************************************************************************************/
@@ -1710,6 +2012,9 @@ init_view( View **view, NCVar *var )
 	(*view)->data         = NULL;
 	(*view)->data_status  = VDS_INVALID;
 	(*view)->pixels       = NULL;
+	(*view)->render_nx    = 0L;
+	(*view)->shrink_levels   = NULL;
+	(*view)->n_shrink_levels = 0;
 	(*view)->x_axis_id    = -1;
 	(*view)->y_axis_id    = -1;
 	(*view)->scan_axis_id = -1;
@@ -1904,6 +2209,16 @@ calculate_blowup( View *view, NCVar *var, int val_to_set_to )
 	float	fbx, fby, f_x_size, f_y_size, f_blowup;
 	int	ifbx, view_var_is_valid;
 
+	/* A non-integer zoom stays the same from variable to variable, unless
+	 * we are fitting the image to the window.
+	 */
+	if( options.zoom_fit || (options.zoom > 0.0) ) {
+		if( options.zoom_fit )
+			options.zoom = fit_zoom( *(var->size + view->x_axis_id), *(var->size + view->y_axis_id) );
+		set_blowup_label();
+		return;
+		}
+
 	if( options.small )
 		return;
 
@@ -2114,7 +2429,8 @@ flip_if_inverted( View *view )
 	else
 		options.invert_physical = FALSE;
 
-	x_force_set_invert_state( options.invert_physical );
+	if( (! options.bench) && (! options.batch) )
+		x_force_set_invert_state( options.invert_physical );
 }
 
 /**************************************************************************************/
@@ -2492,6 +2808,7 @@ view_change_dat( size_t index, float new_val )
 		*((float *)view->data + x + (x_size)*y), new_val );
 
 	*((float *)view->data + x + (x_size)*y) = new_val;
+	invalidate_shrink_levels( view );
 	init_saveframes();
 	lockout_view_changes = TRUE;
 	if( data_to_pixels( view ) < 0 ) {
@@ -2797,19 +3114,29 @@ plot_XY_sc( size_t *start, size_t *count )
 
 	in_set_cursor_busy();
 
-	/* Get the X values for the plot. */
-	for(i_size=0L; i_size<n; i_size++) {
+	/* Get the X values for the plot.  If the dim is 2-d mapped they
+	 * can all be had at once.
+	 */
+	if( (view->variable->dim_map_info[dim_to_plot] != NULL) &&
+	    (fi_dim_values_2d( view->variable, dim_to_plot, dim_to_plot, -1, view->var_place, tmp_yvals ) == 0) ) {
+		for( i_size=0L; i_size<n; i_size++ )
+			*(plot_XY_xvals+i_size) = tmp_yvals[i_size];
+		}
+	else
+		{
+		for(i_size=0L; i_size<n; i_size++) {
 
-		for( i=0; i<view->variable->n_dims; i++ )
-			virt_cursor_place[i] = *(view->var_place + i);
-		virt_cursor_place[dim_to_plot] = i_size;
+			for( i=0; i<view->variable->n_dims; i++ )
+				virt_cursor_place[i] = *(view->var_place + i);
+			virt_cursor_place[dim_to_plot] = i_size;
 
-		type = fi_dim_value( view->variable, dim_to_plot, i_size, &temp_double, 
-				temp_string, &has_bounds, &bound_min, &bound_max, virt_cursor_place );
-		if( type == NC_DOUBLE ) 
-			*(plot_XY_xvals+i_size) = temp_double;
-		else
-			*(plot_XY_xvals+i_size) = (double)i_size;
+			type = fi_dim_value( view->variable, dim_to_plot, i_size, &temp_double, 
+					temp_string, &has_bounds, &bound_min, &bound_max, virt_cursor_place );
+			if( type == NC_DOUBLE ) 
+				*(plot_XY_xvals+i_size) = temp_double;
+			else
+				*(plot_XY_xvals+i_size) = (double)i_size;
+			}
 		}
 	/* If there is a range of the axis of 0, commonly because
 	 * the dimvar has only fill values, then the plotting widget
@@ -3020,6 +3347,17 @@ view_get_scaled_size( int blowup, size_t old_nx, size_t old_ny, size_t *new_nx,
 {
 	double d_new_nx, d_new_ny, d_old_nx, d_old_ny, d_blowup, epsilon;
 
+	/* A non-integer zoom, if there is one, overrides 'blowup' */
+	if( options.zoom > 0.0 ) {
+		*new_nx = (size_t)((double)old_nx * options.zoom + 0.5);
+		*new_ny = (size_t)((double)old_ny * options.zoom + 0.5);
+		if( *new_nx < 1 )
+			*new_nx = 1;
+		if( *new_ny < 1 )
+			*new_ny = 1;
+		return;
+		}
+
 	if( blowup > 0 ) {
 		*new_nx = blowup * old_nx;
 		*new_ny = blowup * old_ny;
@@ -3044,6 +3382,17 @@ view_get_scaled_size( int blowup, size_t old_nx, size_t old_ny, size_t *new_nx,
 mouse_xy_to_data_xy( int mouse_x, int mouse_y, int blowup, size_t *data_x, size_t *data_y )
 {
 	int b;
+	size_t	nx, ny, scaled_nx, scaled_ny;
+
+	/* With a non-integer zoom, pixel i shows the data at (i+0.5)*nx/scaled_nx */
+	if( options.zoom > 0.0 ) {
+		nx = *(view->variable->size + view->x_axis_id);
+		ny = *(view->variable->size + view->y_axis_id);
+		view_get_scaled_size( blowup, nx, ny, &scaled_nx, &scaled_ny );
+		*data_x = (size_t)(((double)mouse_x + 0.5) * (double)nx / (double)scaled_nx);
+		*data_y = (size_t)(((double)mouse_y + 0.5) * (double)ny / (double)scaled_ny);
+		return;
+		}
 
 	if( blowup > 0 ) {
 		*data_x = mouse_x / options.blowup;
@@ -3129,11 +3478,13 @@ void view_recompute_colorbar( void )
 				view->variable->user_min, view->variable->user_max, options.transform );
 		}
 
+	trace_begin( "view_recompute_colorbar", "draw", NULL );
 	x_create_colorbar( view->variable->user_min, view->variable->user_max, options.transform );
 
 	if( options.debug )
 		fprintf( stderr, "view_recompute_colorbar: about to call x_draw_colorbar" );
 	x_draw_colorbar();
+	trace_end( "view_recompute_colorbar", "draw" );
 
 	if( options.debug )
 		fprintf( stderr, "view_recompute_colorbar: exiting\n" );